@@ -0,0 +1,225 @@
+// Замер двух моделей ввода-вывода http_server: общий io_context на всех потоках против io_context
+// на поток с Listener на сокетах SO_REUSEPORT. Для каждой модели замеряется частота новых соединений
+// (запрос с Connection: close) и число запросов в секунду по постоянным соединениям.
+// Каждая модель замеряется с двумя обработчиками: ответ сразу в потоке соединения (как статический файл
+// из кэша) и ответ из strand приложения (как запрос API). Strand, как и в main, живет на общем io_context,
+// который в режиме per-core выполняет один поток, поэтому запрос API переходит в этот поток и обратно.
+// Запуск: ./io_model_bench [потоки сервера] [клиенты] [секунды на замер] [порт]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include "../src/server/http_server.h"
+#include "../src/server/io_context_pool.h"
+
+namespace {
+
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    using tcp = net::ip::tcp;
+
+    using Strand = net::strand<net::io_context::executor_type>;
+
+    // Короткий ответ: замеряется работа сервера с соединениями, а не формирование тела
+    template <typename Request>
+    http::response<http::string_body> MakeResponse(const Request& request) {
+        http::response<http::string_body> response{http::status::ok, request.version()};
+        response.set(http::field::content_type, "application/json"sv);
+        response.body() = "{}"s;
+        response.keep_alive(request.keep_alive());
+        response.prepare_payload();
+        return response;
+    }
+
+    auto MakeInlineHandler() {
+        return [](auto&&, auto&& request, auto&& send) {
+            send(MakeResponse(request));
+        };
+    }
+
+    // Ответ формируется в strand приложения, как у обработчиков API
+    auto MakeStrandHandler(Strand strand) {
+        return [strand](auto&&, auto&& request, auto&& send) {
+            net::post(strand, [request = std::move(request), send = std::move(send)]() mutable {
+                send(MakeResponse(request));
+            });
+        };
+    }
+
+    // Запущенный сервер одной из моделей
+    class BenchServer {
+    public:
+        BenchServer(bool per_core, bool strand_handler, unsigned threads, const tcp::endpoint& endpoint) {
+            if(per_core) {
+                pool_.emplace(threads);
+            }
+            if(strand_handler) {
+                Serve(per_core, endpoint, MakeStrandHandler(strand_));
+            } else {
+                Serve(per_core, endpoint, MakeInlineHandler());
+            }
+
+            // Общий io_context в режиме per-core выполняет только strand приложения, ему хватает потока
+            for(unsigned i = 0; i < (per_core ? 1u : threads); ++i) {
+                workers_.emplace_back([this] {
+                    ioc_.run();
+                });
+            }
+        }
+
+        ~BenchServer() {
+            ioc_.stop();
+            workers_.clear();
+            if(pool_) {
+                pool_->Stop();
+                pool_->Join();
+            }
+        }
+
+    private:
+        template <typename Handler>
+        void Serve(bool per_core, const tcp::endpoint& endpoint, const Handler& handler) {
+            if(!per_core) {
+                http_server::ServeHttp(ioc_, endpoint, handler);
+                return;
+            }
+
+            for(size_t i = 0; i < pool_->Size(); ++i) {
+                http_server::ServeHttp(pool_->GetContext(i), endpoint, handler, true);
+            }
+            pool_->Run();
+        }
+
+        net::io_context ioc_;
+        net::executor_work_guard<net::io_context::executor_type> work_guard_ = net::make_work_guard(ioc_);
+        Strand strand_ = net::make_strand(ioc_);
+        std::vector<std::jthread> workers_;
+        std::optional<http_server::IoContextPool> pool_;
+    };
+
+    bool SendRequest(beast::tcp_stream& stream, bool keep_alive, beast::flat_buffer& buffer) {
+        http::request<http::empty_body> request{http::verb::get, "/api/v1/maps"s, 11};
+        request.set(http::field::host, "localhost"sv);
+        request.keep_alive(keep_alive);
+
+        beast::error_code ec;
+        http::write(stream, request, ec);
+        if(ec) {
+            return false;
+        }
+
+        http::response<http::string_body> response;
+        http::read(stream, buffer, response, ec);
+        return !ec && response.result() == http::status::ok;
+    }
+
+    // Каждый клиент в своем потоке до истечения времени выполняет client_loop, возвращает операций в секунду
+    template <typename ClientLoop>
+    double MeasureRate(unsigned clients, std::chrono::seconds duration, ClientLoop client_loop) {
+        std::atomic<size_t> operations{0};
+        const auto deadline = Clock::now() + duration;
+        const auto start = Clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for(unsigned i = 0; i < clients; ++i) {
+                threads.emplace_back([&] {
+                    operations += client_loop(deadline);
+                });
+            }
+        }
+
+        return static_cast<double>(operations) / std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Новое соединение на каждый запрос
+    size_t ConnectLoop(const tcp::endpoint& endpoint, Clock::time_point deadline) {
+        net::io_context ioc;
+        beast::flat_buffer buffer;
+        size_t count = 0;
+
+        while(Clock::now() < deadline) {
+            beast::tcp_stream stream{ioc};
+            beast::error_code ec;
+            stream.socket().connect(endpoint, ec);
+            if(!ec && SendRequest(stream, false, buffer)) {
+                ++count;
+            }
+            stream.socket().close(ec);
+            buffer.clear();
+        }
+
+        return count;
+    }
+
+    // Запросы по одному постоянному соединению
+    size_t KeepAliveLoop(const tcp::endpoint& endpoint, Clock::time_point deadline) {
+        net::io_context ioc;
+        beast::tcp_stream stream{ioc};
+        beast::flat_buffer buffer;
+        size_t count = 0;
+
+        beast::error_code ec;
+        stream.socket().connect(endpoint, ec);
+        if(ec) {
+            return 0;
+        }
+
+        while(Clock::now() < deadline && SendRequest(stream, true, buffer)) {
+            ++count;
+        }
+
+        return count;
+    }
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    const unsigned threads = argc > 1 ? std::stoul(argv[1]) : std::max(std::thread::hardware_concurrency(), 1u);
+    const unsigned clients = argc > 2 ? std::stoul(argv[2]) : threads * 4;
+    const std::chrono::seconds duration{argc > 3 ? std::stoul(argv[3]) : 3};
+    const auto port = static_cast<unsigned short>(argc > 4 ? std::stoul(argv[4]) : 18080);
+    const tcp::endpoint endpoint{net::ip::make_address("127.0.0.1"), port};
+
+    std::cout << "server threads: "sv << threads << ", clients: "sv << clients
+              << ", "sv << duration.count() << " s per measurement"sv << std::endl;
+    std::cout << std::setw(10) << "mode"sv << std::setw(10) << "handler"sv << std::setw(16) << "connections/s"sv << std::setw(16) << "requests/s"sv
+              << std::endl << std::fixed << std::setprecision(0);
+
+    try {
+        for(const bool strand_handler : {false, true}) {
+            for(const bool per_core : {false, true}) {
+                BenchServer server{per_core, strand_handler, threads, endpoint};
+
+                const double connections = MeasureRate(clients, duration, [&endpoint](Clock::time_point deadline) {
+                    return ConnectLoop(endpoint, deadline);
+                });
+                const double requests = MeasureRate(clients, duration, [&endpoint](Clock::time_point deadline) {
+                    return KeepAliveLoop(endpoint, deadline);
+                });
+
+                std::cout << std::setw(10) << (per_core ? "per-core"sv : "shared"sv)
+                          << std::setw(10) << (strand_handler ? "strand"sv : "inline"sv)
+                          << std::setw(16) << connections << std::setw(16) << requests << std::endl;
+            }
+        }
+    } catch(const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,296 @@
+// Нагрузочный замер запущенного сервера: players игроков входят в игру (/api/v1/game/join) и по кругу
+// отправляют действия и запрашивают состояние игры. Игроки распределены по connections постоянным
+// соединениям, каждое соединение обслуживается своим потоком. Если задан период тика, отдельный поток
+// двигает время запросами /api/v1/game/tick (сервер запускается без --tick-period).
+// Действия и запросы состояния начинаются, когда вошли все игроки, и длятся заданное время.
+// По каждому адресу выводятся число запросов в секунду (вход - за время входа, остальные - за время
+// основной фазы), ошибки и перцентили задержки.
+// Запуск: ./load_bench [игроки] [соединения] [секунды] [период тика, мс; 0 - без тиков] [адрес] [порт]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+
+namespace {
+
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace json = boost::json;
+    using tcp = net::ip::tcp;
+
+    const std::string_view JOIN_TARGET = "/api/v1/game/join"sv;
+    const std::string_view ACTION_TARGET = "/api/v1/game/player/action"sv;
+    const std::string_view STATE_TARGET = "/api/v1/game/state"sv;
+    const std::string_view TICK_TARGET = "/api/v1/game/tick"sv;
+    const std::string_view MAPS_TARGET = "/api/v1/maps"sv;
+
+    // Задержки запросов к одному адресу в микросекундах
+    struct EndpointStats {
+        std::vector<int64_t> latencies;
+        size_t errors = 0;
+
+        void Merge(EndpointStats&& other) {
+            latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+            errors += other.errors;
+        }
+    };
+
+    using Stats = std::map<std::string_view, EndpointStats>;
+
+    // Постоянное соединение с сервером, переоткрывается после ошибки
+    class Client {
+    public:
+        explicit Client(const tcp::endpoint& endpoint)
+            : endpoint_(endpoint) {
+        }
+
+        // Выполняет запрос, замеряет задержку. Возвращает тело ответа 200 OK или ничего при ошибке
+        std::optional<std::string> Request(http::verb method, std::string_view target, std::string body
+                                           , std::string_view token, EndpointStats& stats) {
+            http::request<http::string_body> request{method, target, 11};
+            request.set(http::field::host, "localhost"sv);
+            if(!token.empty()) {
+                request.set(http::field::authorization, "Bearer "s.append(token));
+            }
+            if(method == http::verb::post) {
+                request.set(http::field::content_type, "application/json"sv);
+                request.body() = std::move(body);
+            }
+            request.prepare_payload();
+
+            const auto start = Clock::now();
+            beast::error_code ec;
+            http::response<http::string_body> response;
+            if(Connect(ec)) {
+                http::write(*stream_, request, ec);
+                if(!ec) {
+                    http::read(*stream_, buffer_, response, ec);
+                }
+            }
+            stats.latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+
+            if(ec) {
+                Reset();
+            }
+            if(ec || response.result() != http::status::ok) {
+                ++stats.errors;
+                return std::nullopt;
+            }
+            return std::move(response.body());
+        }
+
+    private:
+        bool Connect(beast::error_code& ec) {
+            if(!stream_) {
+                stream_.emplace(ioc_);
+                buffer_.clear();
+                stream_->connect(endpoint_, ec);
+                if(ec) {
+                    Reset();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void Reset() {
+            stream_.reset();
+        }
+
+        net::io_context ioc_;
+        tcp::endpoint endpoint_;
+        std::optional<beast::tcp_stream> stream_;
+        beast::flat_buffer buffer_;
+    };
+
+    struct Player {
+        std::string token;
+    };
+
+    std::vector<std::string> LoadMapIds(Client& client) {
+        EndpointStats stats;
+        const auto body = client.Request(http::verb::get, MAPS_TARGET, {}, {}, stats);
+        if(!body) {
+            throw std::runtime_error("Failed to get map list"s);
+        }
+
+        const json::value maps = json::parse(*body);
+        std::vector<std::string> ids;
+        for(const auto& map : maps.as_array()) {
+            ids.emplace_back(map.as_object().at("id").as_string());
+        }
+        if(ids.empty()) {
+            throw std::runtime_error("Server has no maps"s);
+        }
+        return ids;
+    }
+
+    // Поток соединения: вход своих игроков, затем, когда вошли игроки всех соединений (joined),
+    // действия и запросы состояния в течение duration
+    Stats PlayersLoop(const tcp::endpoint& endpoint, const std::vector<std::string>& map_ids, size_t first_player
+                      , size_t players_count, std::latch& joined, std::chrono::seconds duration) {
+        Client client{endpoint};
+        Stats stats;
+        std::mt19937 random{static_cast<unsigned>(first_player)};
+        std::uniform_int_distribution<size_t> move_dist{0, 4};
+        static const std::string_view MOVES[] = {"L"sv, "R"sv, "U"sv, "D"sv, ""sv};
+
+        std::vector<Player> players;
+        players.reserve(players_count);
+        for(size_t i = 0; i < players_count; ++i) {
+            json::object join;
+            join["userName"] = "bench" + std::to_string(first_player + i);
+            join["mapId"] = map_ids[(first_player + i) % map_ids.size()];
+
+            auto& join_stats = stats[JOIN_TARGET];
+            const auto body = client.Request(http::verb::post, JOIN_TARGET, json::serialize(join), {}, join_stats);
+            if(!body) {
+                continue;
+            }
+            // Ответ без токена - ошибка сервера, а не повод остановить замер
+            try {
+                players.push_back({std::string(json::parse(*body).as_object().at("authToken").as_string())});
+            } catch(const std::exception&) {
+                ++join_stats.errors;
+            }
+        }
+
+        joined.arrive_and_wait();
+        if(players.empty()) {
+            return stats;
+        }
+
+        const auto deadline = Clock::now() + duration;
+        while(Clock::now() < deadline) {
+            for(const auto& player : players) {
+                json::object action;
+                action["move"] = MOVES[move_dist(random)];
+                client.Request(http::verb::post, ACTION_TARGET, json::serialize(action), player.token, stats[ACTION_TARGET]);
+                client.Request(http::verb::get, STATE_TARGET, {}, player.token, stats[STATE_TARGET]);
+            }
+        }
+
+        return stats;
+    }
+
+    // Ручные тики в основной фазе: каждые period сервер продвигает игру на period
+    Stats TickLoop(const tcp::endpoint& endpoint, std::chrono::milliseconds period, std::latch& joined
+                   , std::chrono::seconds duration) {
+        Client client{endpoint};
+        Stats stats;
+        const std::string body = json::serialize(json::object{{"timeDelta", period.count()}});
+
+        joined.wait();
+        const auto deadline = Clock::now() + duration;
+        for(auto next = Clock::now() + period; next < deadline; next += period) {
+            std::this_thread::sleep_until(next);
+            client.Request(http::verb::post, TICK_TARGET, body, {}, stats[TICK_TARGET]);
+        }
+
+        return stats;
+    }
+
+    int64_t Percentile(const std::vector<int64_t>& sorted, double p) {
+        if(sorted.empty()) {
+            return 0;
+        }
+        const auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+        return sorted[index];
+    }
+
+    // Частота входа считается за время входа, остальных запросов - за время основной фазы
+    void PrintStats(Stats& stats, double join_seconds, double loop_seconds) {
+        std::cout << std::setw(28) << "endpoint"sv << std::setw(10) << "requests"sv << std::setw(8) << "errors"sv
+                  << std::setw(10) << "req/s"sv << std::setw(10) << "p50, us"sv << std::setw(10) << "p90, us"sv
+                  << std::setw(10) << "p99, us"sv << std::setw(10) << "max, us"sv << std::endl << std::fixed;
+
+        for(auto& [target, endpoint_stats] : stats) {
+            auto& latencies = endpoint_stats.latencies;
+            const double seconds = target == JOIN_TARGET ? join_seconds : loop_seconds;
+            std::sort(latencies.begin(), latencies.end());
+            std::cout << std::setw(28) << target << std::setw(10) << latencies.size() << std::setw(8) << endpoint_stats.errors
+                      << std::setw(10) << std::setprecision(0) << static_cast<double>(latencies.size()) / seconds
+                      << std::setw(10) << Percentile(latencies, 0.5) << std::setw(10) << Percentile(latencies, 0.9)
+                      << std::setw(10) << Percentile(latencies, 0.99) << std::setw(10) << Percentile(latencies, 1.0)
+                      << std::endl;
+        }
+    }
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    const size_t players = argc > 1 ? std::stoul(argv[1]) : 100;
+    if(players == 0) {
+        std::cerr << "Number of players must be positive"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+    const size_t connections = std::clamp<size_t>(argc > 2 ? std::stoul(argv[2]) : 8, 1, players);
+    const std::chrono::seconds duration{argc > 3 ? std::stoul(argv[3]) : 10};
+    const std::chrono::milliseconds tick_period{argc > 4 ? std::stoul(argv[4]) : 50};
+    const std::string address = argc > 5 ? argv[5] : "127.0.0.1"s;
+    const auto port = static_cast<unsigned short>(argc > 6 ? std::stoul(argv[6]) : 8080);
+
+    try {
+        const tcp::endpoint endpoint{net::ip::make_address(address), port};
+        Client client{endpoint};
+        const auto map_ids = LoadMapIds(client);
+
+        std::cout << "players: "sv << players << ", connections: "sv << connections << ", maps: "sv << map_ids.size()
+                  << ", "sv << duration.count() << " s, tick period: "sv << tick_period.count() << " ms"sv << std::endl;
+
+        std::vector<Stats> results(connections + 1);
+        std::latch joined{static_cast<std::ptrdiff_t>(connections)};
+        const auto start = Clock::now();
+        Clock::time_point loop_start;
+        {
+            std::vector<std::jthread> threads;
+            for(size_t i = 0; i < connections; ++i) {
+                // Игроки делятся между соединениями поровну, остаток достается первым
+                const size_t first = i * (players / connections) + std::min(i, players % connections);
+                const size_t count = players / connections + (i < players % connections ? 1 : 0);
+                threads.emplace_back([&, i, first, count] {
+                    results[i] = PlayersLoop(endpoint, map_ids, first, count, joined, duration);
+                });
+            }
+            if(tick_period.count() > 0) {
+                threads.emplace_back([&] {
+                    results[connections] = TickLoop(endpoint, tick_period, joined, duration);
+                });
+            }
+            joined.wait();
+            loop_start = Clock::now();
+        }
+        const double join_seconds = std::chrono::duration<double>(loop_start - start).count();
+        const double loop_seconds = std::chrono::duration<double>(Clock::now() - loop_start).count();
+
+        Stats total;
+        for(auto& result : results) {
+            for(auto& [target, endpoint_stats] : result) {
+                total[target].Merge(std::move(endpoint_stats));
+            }
+        }
+        PrintStats(total, join_seconds, loop_seconds);
+    } catch(const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+// Замер журналирования запросов: потоки пишут записи, похожие на журнал LogRequestHandler
+// (получен запрос, отправлен ответ), через logger::LogEntryToConsole. Сравниваются прежний
+// синхронный консольный приемник со сбросом после каждой записи и logger::AsyncLogSink, а также
+// выборка каждого n-го запроса. Выводится число запросов в секунду и число отброшенных записей.
+// Запуск: ./log_bench [потоки] [запросы на поток] [файл вывода, по умолчанию /dev/null]
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/json.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/utility/setup/console.hpp>
+
+#include "../src/logging/async_sink.h"
+#include "../src/logging/logger.h"
+#include "../src/metrics/metrics.h"
+
+namespace {
+
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+    namespace keywords = boost::log::keywords;
+
+    // Две записи на запрос, как у LogRequestHandler
+    void LogRequest(size_t thread, size_t request) {
+        logger::LogEntryToConsole(boost::json::object{{"ip"s, "127.0.0.1"s}, {"URI"s, "/api/v1/game/state"s}
+                                                    , {"method"s, "GET"s}}
+                                , "request received"s);
+        logger::LogEntryToConsole(boost::json::object{{"response_time"s, static_cast<int64_t>(thread * 100 + request % 100)}
+                                                    , {"code"s, 200}, {"content_type"s, "application/json"s}}
+                                , "response sent"s);
+    }
+
+    double RunThreads(size_t threads_count, size_t requests, const logger::RequestSampler& sampler) {
+        const auto start = Clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for(size_t t = 0; t < threads_count; ++t) {
+                threads.emplace_back([t, requests, &sampler] {
+                    for(size_t i = 0; i < requests; ++i) {
+                        if(sampler.Sample()) {
+                            LogRequest(t, i);
+                        }
+                    }
+                });
+            }
+        }
+        boost::log::core::get()->flush();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void PrintResult(std::string_view mode, size_t total_requests, double seconds, uint64_t dropped) {
+        std::cout << std::setw(22) << mode << std::setw(14) << std::setprecision(0)
+                  << static_cast<double>(total_requests) / seconds << std::setw(10) << dropped << std::endl;
+    }
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    const size_t threads_count = argc > 1 ? std::stoul(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    const size_t requests = argc > 2 ? std::stoul(argv[2]) : 100'000;
+    const std::string path = argc > 3 ? argv[3] : "/dev/null"s;
+
+    std::ofstream out{path};
+    if(!out) {
+        std::cerr << "Failed to open "sv << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    boost::log::add_common_attributes();
+    auto& dropped = metrics::GetServerMetrics().log_records_dropped;
+    const size_t total = threads_count * requests;
+
+    std::cout << "threads: "sv << threads_count << ", requests per thread: "sv << requests << ", output: "sv << path
+              << std::endl << std::setw(22) << "mode"sv << std::setw(14) << "requests/s"sv << std::setw(10) << "dropped"sv
+              << std::endl << std::fixed;
+
+    {
+        auto sink = boost::log::add_console_log(out, keywords::format = &logger::JsonFormatter, keywords::auto_flush = true);
+        PrintResult("sync, auto_flush"sv, total, RunThreads(threads_count, requests, logger::RequestSampler{1}), 0);
+        boost::log::core::get()->remove_sink(sink);
+    }
+
+    for(const size_t rate : {1, 10}) {
+        const uint64_t dropped_before = dropped.Value();
+        double seconds = 0;
+        {
+            logger::AsyncLogRegistration registration{out, &logger::JsonFormatter};
+            seconds = RunThreads(threads_count, requests, logger::RequestSampler{rate});
+        }
+        PrintResult(rate == 1 ? "async"sv : "async, 1 of 10"sv, total, seconds, dropped.Value() - dropped_before);
+    }
+
+    {
+        const uint64_t dropped_before = dropped.Value();
+        PrintResult("off"sv, total, RunThreads(threads_count, requests, logger::RequestSampler{0})
+                  , dropped.Value() - dropped_before);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+// Замер пропускной способности сборки ответов http_response::Response в нескольких потоках.
+// Каждый поток собирает свою долю ответов с JSON-телом; при сборке без общих блокировок
+// число ответов в секунду растет с числом потоков.
+// Запуск: ./response_bench [1000000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/response/response.h"
+
+namespace {
+
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+    using http_response::Response;
+    namespace http = boost::beast::http;
+
+    // Тело ответа размером с типичное состояние игры
+    std::string MakeBody() {
+        std::string body = "{\"players\":{"s;
+        for(int i = 0; i < 32; ++i) {
+            body += "\""s + std::to_string(i) + "\":{\"pos\":[10.5,20.25],\"speed\":[0.0,1.5],\"dir\":\"U\"},"s;
+        }
+        body.back() = '}';
+        body += '}';
+        return body;
+    }
+
+    // Собирает responses ответов в threads потоках, возвращает число ответов в секунду
+    template <typename MakeResponse>
+    double MeasureThroughput(size_t threads, size_t responses, MakeResponse make_response) {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads);
+        const size_t per_thread = responses / threads;
+
+        const auto start = Clock::now();
+        for(size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&make_response, per_thread] {
+                size_t total_size = 0;
+                for(size_t i = 0; i < per_thread; ++i) {
+                    total_size += make_response().body().size();
+                }
+                // Не даем компилятору выбросить сборку ответов
+                if(total_size == 0) {
+                    std::cerr << "empty responses"sv << std::endl;
+                }
+            });
+        }
+        workers.clear();
+
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(per_thread * threads) / seconds;
+    }
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    const size_t responses = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    const size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const std::string body = MakeBody();
+
+    // Копия тела из string_view, как при ответе из закэшированной строки
+    const auto copy_body = [&body] {
+        return Response::CreateStringResponse(http::status::ok, 11, std::string_view{body}, true
+                                            , "application/json"sv, "no-cache"sv, ""sv);
+    };
+    // Тело, собранное обработчиком, перемещается в ответ
+    const auto move_body = [&body] {
+        std::string json = body;
+        return Response::CreateStringResponse(http::status::ok, 11, std::move(json), true
+                                            , "application/json"sv, "no-cache"sv, ""sv);
+    };
+
+    std::cout << "responses: "sv << responses << ", body: "sv << body.size() << " bytes"sv << std::endl;
+    std::cout << std::setw(8) << "threads"sv << std::setw(16) << "copy, resp/s"sv << std::setw(16) << "move, resp/s"sv
+              << std::endl << std::fixed << std::setprecision(0);
+
+    for(size_t threads = 1; threads <= max_threads; threads *= 2) {
+        std::cout << std::setw(8) << threads
+                  << std::setw(16) << MeasureThroughput(threads, responses, copy_body)
+                  << std::setw(16) << MeasureThroughput(threads, responses, move_body) << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
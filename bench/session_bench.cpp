@@ -0,0 +1,177 @@
+// Замер сессии http_server на постоянных соединениях в духе wrk: clients соединений, в каждом
+// depth запросов отправляются подряд, не дожидаясь ответов (конвейер HTTP/1.1). Сервер работает
+// в одном потоке; счетчик выделений памяти в этом потоке показывает, сколько выделений
+// приходится на один запрос (включая заголовки, которые выставляет сам обработчик).
+// Запуск: ./session_bench [клиенты] [глубина конвейера] [секунды] [порт]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include "../src/server/http_server.h"
+
+namespace {
+
+    // Выделения памяти в текущем потоке
+    thread_local size_t allocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if(void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, [[maybe_unused]] std::size_t size) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    using tcp = net::ip::tcp;
+
+    auto MakeHandler() {
+        return [](auto&&, auto&& request, auto&& send) {
+            http::response<http::string_body> response{http::status::ok, request.version()};
+            response.set(http::field::content_type, "application/json"sv);
+            response.body() = "{}"s;
+            response.keep_alive(request.keep_alive());
+            response.prepare_payload();
+            send(std::move(response));
+        };
+    }
+
+    // Число выделений памяти в потоке сервера
+    size_t ServerAllocations(net::io_context& ioc) {
+        std::promise<size_t> result;
+        net::post(ioc, [&result] {
+            result.set_value(allocations);
+        });
+        return result.get_future().get();
+    }
+
+    // depth запросов одним куском: клиент отправляет их подряд
+    std::string MakePipelinedRequests(size_t depth) {
+        http::request<http::empty_body> request{http::verb::get, "/api/v1/maps"s, 11};
+        request.set(http::field::host, "localhost"sv);
+        request.prepare_payload();
+
+        std::ostringstream out;
+        out << request;
+        std::string requests;
+        for(size_t i = 0; i < depth; ++i) {
+            requests += out.str();
+        }
+        return requests;
+    }
+
+    size_t ClientLoop(const tcp::endpoint& endpoint, size_t depth, Clock::time_point deadline) {
+        net::io_context ioc;
+        tcp::socket socket{ioc};
+        socket.connect(endpoint);
+
+        const std::string requests = MakePipelinedRequests(depth);
+        beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        size_t count = 0;
+
+        while(Clock::now() < deadline) {
+            net::write(socket, net::buffer(requests));
+            for(size_t i = 0; i < depth; ++i) {
+                response = {};
+                http::read(socket, buffer, response);
+                if(response.result() != http::status::ok) {
+                    throw std::runtime_error("Unexpected response status"s);
+                }
+            }
+            count += depth;
+        }
+
+        return count;
+    }
+
+    struct RunResult {
+        double requests_per_second = 0;
+        double allocations_per_request = 0;
+    };
+
+    RunResult Run(net::io_context& ioc, const tcp::endpoint& endpoint, size_t clients, size_t depth
+                , std::chrono::seconds duration) {
+        std::atomic<size_t> requests{0};
+        const size_t allocations_before = ServerAllocations(ioc);
+        const auto start = Clock::now();
+        const auto deadline = start + duration;
+        {
+            std::vector<std::jthread> threads;
+            for(size_t i = 0; i < clients; ++i) {
+                threads.emplace_back([&] {
+                    requests += ClientLoop(endpoint, depth, deadline);
+                });
+            }
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const size_t allocations_after = ServerAllocations(ioc);
+
+        return {static_cast<double>(requests) / seconds
+                , static_cast<double>(allocations_after - allocations_before) / static_cast<double>(requests)};
+    }
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    const size_t clients = argc > 1 ? std::stoul(argv[1]) : 8;
+    const size_t max_depth = argc > 2 ? std::stoul(argv[2]) : 16;
+    const std::chrono::seconds duration{argc > 3 ? std::stoul(argv[3]) : 3};
+    const auto port = static_cast<unsigned short>(argc > 4 ? std::stoul(argv[4]) : 18081);
+    const tcp::endpoint endpoint{net::ip::make_address("127.0.0.1"), port};
+
+    try {
+        net::io_context ioc{1};
+        auto work_guard = net::make_work_guard(ioc);
+        http_server::ServeHttp(ioc, endpoint, MakeHandler());
+        std::jthread server{[&ioc] {
+            ioc.run();
+        }};
+
+        std::cout << "clients: "sv << clients << ", "sv << duration.count() << " s per measurement"sv << std::endl;
+        std::cout << std::setw(8) << "depth"sv << std::setw(14) << "requests/s"sv << std::setw(16) << "allocs/request"sv
+                  << std::endl << std::fixed;
+
+        for(size_t depth = 1; depth <= max_depth; depth *= 4) {
+            const auto result = Run(ioc, endpoint, clients, depth, duration);
+            std::cout << std::setw(8) << depth << std::setw(14) << std::setprecision(0) << result.requests_per_second
+                      << std::setw(16) << std::setprecision(2) << result.allocations_per_request << std::endl;
+        }
+
+        ioc.stop();
+    } catch(const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
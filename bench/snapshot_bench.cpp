@@ -0,0 +1,109 @@
+// Замер сохранения и восстановления состояния игры: текстовый архив boost против двоичного снимка.
+// Игроки добавляются на все карты конфигурации по очереди. Двоичный снимок дополнительно
+// восстанавливается с параллельным восстановлением сессий на всех ядрах.
+// Запуск: ./snapshot_bench data/config.json [100000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+#include "../src/application/game_manager.h"
+#include "../src/serialization_game/binary_snapshot.h"
+#include "../src/serialization_game/game_manager_serialization.h"
+#include "../src/work_with_json/json_loader.h"
+
+namespace {
+
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+    namespace fs = std::filesystem;
+
+    template <typename Fn>
+    double MeasureMilliseconds(Fn&& fn) {
+        const auto start = Clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void PrintRow(std::string_view format, double save_ms, double restore_ms, uintmax_t size) {
+        std::cout << std::setw(8) << format << std::setw(14) << save_ms << std::setw(14) << restore_ms
+                  << std::setw(14) << size / 1024 << std::endl;
+    }
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    if(argc < 2) {
+        std::cerr << "Usage: snapshot_bench <config.json> [players]"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const size_t players = argc > 2 ? std::stoul(argv[2]) : 100'000;
+
+    try {
+        const model::Game game = json_loader::LoadGame(argv[1]);
+        app::GameManager manager{game};
+
+        const auto& maps = game.GetMaps();
+        for(size_t i = 0; i < players; ++i) {
+            manager.AddPlayer(*maps[i % maps.size()].GetId(), "dog_"s + std::to_string(i));
+        }
+
+        const fs::path text_path = fs::temp_directory_path() / "snapshot_bench.txt"s;
+        const fs::path binary_path = fs::temp_directory_path() / "snapshot_bench.bin"s;
+
+        std::cout << "players: "sv << players << ", sessions: "sv << manager.GetAllSessions().size() << std::endl;
+        std::cout << std::setw(8) << "format"sv << std::setw(14) << "save, ms"sv << std::setw(14) << "restore, ms"sv
+                  << std::setw(14) << "size, KiB"sv << std::endl << std::fixed << std::setprecision(1);
+
+        const double text_save = MeasureMilliseconds([&] {
+            std::ofstream ofs{text_path, std::ios::binary};
+            boost::archive::text_oarchive archive{ofs};
+            serialization::GameManagerRepr repr{manager};
+            archive << repr;
+        });
+        const double text_restore = MeasureMilliseconds([&] {
+            std::ifstream ifs{text_path, std::ios::binary};
+            boost::archive::text_iarchive archive{ifs};
+            serialization::GameManagerRepr repr;
+            archive >> repr;
+            auto restored = repr.Restore(game);
+        });
+        PrintRow("text"sv, text_save, text_restore, fs::file_size(text_path));
+
+        const double binary_save = MeasureMilliseconds([&] {
+            std::ofstream ofs{binary_path, std::ios::binary};
+            serialization::WriteSnapshot(ofs, manager);
+        });
+        const double binary_restore = MeasureMilliseconds([&] {
+            std::ifstream ifs{binary_path, std::ios::binary};
+            auto restored = serialization::ReadSnapshot(ifs, game);
+        });
+        PrintRow("binary"sv, binary_save, binary_restore, fs::file_size(binary_path));
+
+        const size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        const double parallel_restore = MeasureMilliseconds([&] {
+            std::ifstream ifs{binary_path, std::ios::binary};
+            auto restored = serialization::ReadSnapshot(ifs, game, threads);
+        });
+        PrintRow("binary/"s + std::to_string(threads), binary_save, parallel_restore, fs::file_size(binary_path));
+
+        fs::remove(text_path);
+        fs::remove(binary_path);
+    } catch(const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+// Замер тика без HTTP: игроки добавляются на все карты конфигурации по очереди, затем игра
+// продвигается ручными тиками фиксированной длины. Перед каждым тиком часть игроков меняет
+// направление движения (генератор с заданным зерном, поэтому команды одинаковы от запуска к запуску).
+// Рекорды вышедших игроков хранятся в памяти, база данных не нужна. Если задан файл сохранения,
+// после каждого тика вызывается сохранение состояния, как при --save-state-period.
+// Выводится суммарное и среднее на тик время этапов: трофеи, движение, столкновения,
+// удаление неактивных игроков и сохранение. Запись показателей сервера (metrics) можно выключить:
+// разница времени тика двух запусков с одним зерном - стоимость показателей.
+// Запуск: ./tick_bench data/config.json [игроки] [тики] [длина тика, мс] [зерно] [файл сохранения; - без него]
+//         [показатели: 1 - вкл, 0 - выкл]
+// Стоимость показателей - два запуска с одним зерном, без сохранения:
+//         ./tick_bench data/config.json 1000 2000 50 42 - 1
+//         ./tick_bench data/config.json 1000 2000 50 42 - 0
+// Показатели тика - один ScopedTimer и два Counter::Add на тик и столько же на каждую сессию (столкновения)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+
+#include "../src/application/application.h"
+#include "../src/game_data_persistence/backup_restore_manager.h"
+#include "../src/metrics/metrics.h"
+#include "../src/work_with_json/json_loader.h"
+
+namespace {
+
+    using namespace std::literals;
+    namespace net = boost::asio;
+    namespace fs = std::filesystem;
+
+    // Доля игроков, получающих новую команду перед каждым тиком
+    const double MOVE_CHANGE_PROBABILITY = 0.1;
+    // Период полного сохранения, если задан файл сохранения
+    const double SAVE_PERIOD_MS = 1000.0;
+
+    // Случайные команды игрокам. Игроки, удаленные за неактивность, выбывают из списка
+    class MoveDriver {
+    public:
+        MoveDriver(std::vector<std::string> tokens, unsigned seed)
+            : tokens_{std::move(tokens)}
+            , random_{seed} {
+        }
+
+        void Apply(app::GameManager& manager) {
+            // Команды клиента; "" - остановка
+            static const std::string MOVES[] = {"L"s, "R"s, "U"s, "D"s, ""s};
+            std::bernoulli_distribution change{MOVE_CHANGE_PROBABILITY};
+            std::uniform_int_distribution<size_t> move{0, std::size(MOVES) - 1};
+
+            for(size_t i = 0; i < tokens_.size();) {
+                auto player = manager.FindPlayerByToken(tokens_[i]);
+                if(!player) {
+                    tokens_[i] = std::move(tokens_.back());
+                    tokens_.pop_back();
+                    continue;
+                }
+
+                if(change(random_)) {
+                    // Как Application::CharacterMoveManagement, но без разбора JSON
+                    const auto direction = model::STRING_TO_DIRECTION.at(MOVES[move(random_)]);
+                    if(direction == model::Direction::NONE) {
+                        player->GetDog()->ResetVelocity();
+                    } else {
+                        player->GetDog()->SetDirection(direction);
+                        player->GetDog()->SetVelocity(player->GetVelocityOnMap());
+                    }
+                }
+                ++i;
+            }
+        }
+
+        size_t ActivePlayers() const noexcept {
+            return tokens_.size();
+        }
+
+    private:
+        std::vector<std::string> tokens_;
+        std::mt19937 random_;
+    };
+
+    void PrintPhase(std::string_view name, app::TickProfile::Duration duration, app::TickProfile::Duration total
+                    , uint64_t ticks) {
+        const double ms = std::chrono::duration<double, std::milli>(duration).count();
+        const double total_ms = std::chrono::duration<double, std::milli>(total).count();
+        std::cout << std::setw(12) << name << std::setw(14) << std::setprecision(1) << ms
+                  << std::setw(16) << std::setprecision(1) << ms * 1000.0 / static_cast<double>(ticks)
+                  << std::setw(10) << std::setprecision(1) << (total_ms > 0 ? ms * 100.0 / total_ms : 0.0) << std::endl;
+    }
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    if(argc < 2) {
+        std::cerr << "Usage: tick_bench <config.json> [players] [ticks] [tick ms] [seed] [save file | -] [metrics 1|0]"sv
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const size_t players = argc > 2 ? std::stoul(argv[2]) : 10'000;
+    const size_t ticks = argc > 3 ? std::stoul(argv[3]) : 1'000;
+    const double tick_ms = argc > 4 ? std::stod(argv[4]) : 50.0;
+    const unsigned seed = argc > 5 ? static_cast<unsigned>(std::stoul(argv[5])) : 1;
+    const std::optional<fs::path> save_path = argc > 6 && argv[6] != "-"sv ? std::optional<fs::path>{argv[6]} : std::nullopt;
+    const bool metrics_enabled = argc > 7 ? std::stoul(argv[7]) != 0 : true;
+    metrics::SetRecording(metrics_enabled);
+
+    try {
+        model::Game game = json_loader::LoadGame(argv[1]);
+
+        net::io_context ioc{1};
+        auto strand = net::make_strand(ioc);
+
+        db_conn_settings::DbConnectrioSettings db_settings;
+        db_settings.records_storage = db_conn_settings::RecordsStorage::MEMORY;
+
+        const app::TimeType save_interval = save_path ? app::TimeType{SAVE_PERIOD_MS} : std::nullopt;
+        app::Application application{ioc, strand, std::move(game), std::nullopt, save_interval, db_settings};
+
+        std::shared_ptr<data_persistence::BackupRestoreManager> backup_restore_manager;
+        if(save_path) {
+            backup_restore_manager = std::make_shared<data_persistence::BackupRestoreManager>(*save_path, save_interval, true);
+            application.SetSaveNeeded(true);
+            application.SetSavedGame([&backup_restore_manager](const app::GameManager& manager) {
+                backup_restore_manager->SaveGame(manager);
+            });
+        }
+
+        app::TickProfile profile;
+        app::TickProfile::Duration total{};
+        size_t active_players = 0;
+        const size_t maps_count = application.GetGame().GetMaps().size();
+
+        // Тик выполняется на strand приложения, как при обработке /api/v1/game/tick
+        net::post(strand, [&] {
+            auto& manager = application.GetManager();
+            const auto& maps = application.GetGame().GetMaps();
+            std::vector<std::string> tokens;
+            tokens.reserve(players);
+            for(size_t i = 0; i < players; ++i) {
+                tokens.emplace_back(manager.AddPlayer(*maps[i % maps.size()].GetId(), "dog_"s + std::to_string(i))->GetToken());
+            }
+
+            MoveDriver driver{std::move(tokens), seed};
+            application.SetTickProfile(&profile);
+
+            for(size_t i = 0; i < ticks; ++i) {
+                driver.Apply(manager);
+
+                const auto start = std::chrono::steady_clock::now();
+                application.UpdateGameManager(tick_ms);
+                total += std::chrono::steady_clock::now() - start;
+            }
+
+            application.SetTickProfile(nullptr);
+            active_players = driver.ActivePlayers();
+        });
+        ioc.run();
+
+        application.DrainRecords();
+        if(backup_restore_manager) {
+            backup_restore_manager->Flush();
+        }
+
+        std::cout << "players: "sv << players << " (active at the end: "sv << active_players << "), maps: "sv << maps_count
+                  << ", ticks: "sv << profile.ticks << " x "sv << tick_ms << " ms, seed: "sv << seed
+                  << ", metrics: "sv << (metrics_enabled ? "on"sv : "off"sv) << std::endl;
+        std::cout << std::setw(12) << "phase"sv << std::setw(14) << "total, ms"sv << std::setw(16) << "per tick, us"sv
+                  << std::setw(10) << "share, %"sv << std::endl << std::fixed;
+
+        const uint64_t measured_ticks = std::max<uint64_t>(profile.ticks, 1);
+        PrintPhase("loot"sv, profile.loot, total, measured_ticks);
+        PrintPhase("movement"sv, profile.movement, total, measured_ticks);
+        PrintPhase("collisions"sv, profile.collisions, total, measured_ticks);
+        PrintPhase("retirement"sv, profile.retirement, total, measured_ticks);
+        PrintPhase("save"sv, profile.save, total, measured_ticks);
+        PrintPhase("tick"sv, total, total, measured_ticks);
+    } catch(const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -6,15 +6,45 @@
 
 #include "../models/geometry_primitives.h"
 #include "utils.h"
-#include "collision_manager.h"
 #include "../logging/logger.h"
 #include "../database/database_invariants.h"
+#include "../metrics/metrics.h"
 
 namespace app {
 
     using NearestPointType = std::pair<int,         // id карты
                                 model::Position>;  // координаты точки
 
+    namespace {
+
+        // Добавляет время своей жизни к этапу тика, если замер включен
+        class PhaseTimer {
+        public:
+            PhaseTimer(TickProfile* profile, TickProfile::Duration TickProfile::* phase) noexcept
+                : profile_{profile}
+                , phase_{phase} {
+                if(profile_) {
+                    start_ = std::chrono::steady_clock::now();
+                }
+            }
+
+            PhaseTimer(const PhaseTimer&) = delete;
+            PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+            ~PhaseTimer() {
+                if(profile_) {
+                    profile_->*phase_ += std::chrono::steady_clock::now() - start_;
+                }
+            }
+
+        private:
+            TickProfile* profile_;
+            TickProfile::Duration TickProfile::* phase_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+    } // namespace
+
         StatusMessage Application::JoinGame(const std::string &dog_name, const std::string &map_id) {
             StatusMessage result;
 
@@ -176,31 +206,56 @@ namespace app {
         }
 
         StatusMessage Application::GetRecords(std::optional<size_t> offset, std::optional<size_t> limit) {
-            size_t start = db_invariants::DEFAULT_OFFSET;
-            size_t number_row = db_invariants::DEFAULT_LIMIT;
+            const size_t start = offset.value_or(db_invariants::DEFAULT_OFFSET);
+            const size_t number_row = limit.value_or(db_invariants::DEFAULT_LIMIT);
 
-            if(offset) {
-                start = offset.value();
+            try {
+                return MakeRecordsResponse(nullptr, leaderboard_.GetRecords(start, number_row));
+            } catch(...) {
+                return MakeRecordsResponse(std::current_exception(), {});
             }
+        }
+
+        StatusMessage Application::GetRecordsAfter(const std::string& after, std::optional<size_t> limit) {
+            auto cursor = domain::ParseRecordCursor(after);
 
-            if(limit) {
-                number_row = limit.value();
+            if(!cursor) {
+                return MakeInvalidCursorResponse(); //400
             }
 
-            std::optional<std::vector<domain::PlayerRecord>> players_table = use_cases_.GetRecordsTable(start, number_row);
+            const size_t number_row = limit.value_or(db_invariants::DEFAULT_LIMIT);
 
-            json::array players_records_arr;
-            for(const auto& player_record : players_table.value()) {
-                players_records_arr.emplace_back(
-                    json::object{
-                        {"name"sv, player_record.GetName()}
-                        , {"score"sv, player_record.GetScore()}
-                        , {"playTime"sv, player_record.GetPlayTime()}
-                    }
-                );
+            try {
+                return MakeRecordsResponse(nullptr, leaderboard_.GetRecordsAfter(*cursor, number_row));
+            } catch(...) {
+                return MakeRecordsResponse(std::current_exception(), {});
+            }
+        }
+
+        void Application::GetRecords(std::optional<size_t> offset, std::optional<size_t> limit, StatusMessageHandler send) {
+            const size_t start = offset.value_or(db_invariants::DEFAULT_OFFSET);
+            const size_t number_row = limit.value_or(db_invariants::DEFAULT_LIMIT);
+
+            leaderboard_.GetRecords(start, number_row, db_queries_.get_executor()
+                , [send = std::move(send)](std::exception_ptr error, std::vector<domain::PlayerRecord> records) {
+                    send(MakeRecordsResponse(error, records));
+                });
+        }
+
+        void Application::GetRecordsAfter(const std::string& after, std::optional<size_t> limit, StatusMessageHandler send) {
+            auto cursor = domain::ParseRecordCursor(after);
+
+            if(!cursor) {
+                send(MakeInvalidCursorResponse()); //400
+                return;
             }
 
-            return {http::status::ok, json::serialize(players_records_arr)};
+            const size_t number_row = limit.value_or(db_invariants::DEFAULT_LIMIT);
+
+            leaderboard_.GetRecordsAfter(*cursor, number_row, db_queries_.get_executor()
+                , [send = std::move(send)](std::exception_ptr error, std::vector<domain::PlayerRecord> records) {
+                    send(MakeRecordsResponse(error, records));
+                });
         }
 
         StatusMessage Application::CharacterMoveManagement(const std::string &token, const std::string &move_character) {
@@ -273,6 +328,8 @@ namespace app {
 
         void Application::SetRestoreGameManager(GameManager&& manager_rest) {
             game_manager_ = std::move(manager_rest);
+            // Сессии заменены - миры коллизий будут построены заново
+            collision_manager_.Reset();
         }
 
         void Application::SetSaveNeeded(bool auto_save_needed) {
@@ -283,6 +340,20 @@ namespace app {
             save_game_ = save;
         }
 
+        void Application::SetCollisionThreads(size_t threads_count) {
+            collision_manager_.SetThreadsCount(threads_count);
+        }
+
+        void Application::SetTickMaxStep(size_t max_step_ms) {
+            if(ticker_) {
+                ticker_->SetMaxStep(std::chrono::milliseconds{max_step_ms});
+            }
+        }
+
+        void Application::SetTickProfile(TickProfile* profile) noexcept {
+            tick_profile_ = profile;
+        }
+
         bool Application::IsRemovePlayer(PlayerPtr player, TimeType time, model::Velocity start_velocity) {
             // Обновляем время игрока
             player->CorrectTimeInGame(time.value());
@@ -331,40 +402,73 @@ namespace app {
         StatusMessage Application::UpdateGameSessions(double delta_time) {
             StatusMessage result;
             net::dispatch(*strand_, [this, &result, delta_time]() {
-                // Создаем обработчик коллизий (столкновений)
-                CollisionManager collision_manager(game_, game_manager_);
+                auto& server_metrics = metrics::GetServerMetrics();
+                metrics::ScopedTimer tick_timer{server_metrics.tick_duration};
+                server_metrics.ticks.Add();
+                server_metrics.sessions_ticked.Add(game_manager_.GetAllSessions().size());
+
+                // Освобождаем память, выделенную в арене за предыдущий тик
+                tick_arena_.Reset();
+                // Получаем ресурс памяти для временных объектов тика
+                std::pmr::memory_resource* resource = tick_arena_.Resource();
 
                 // Перебираем все запущенные сессии
                 for(auto& [_, session] : game_manager_.GetAllSessions()) {
                     // Добавляем предметы на карту сессии
-                    AddLostObject(delta_time, *session);
+                    {
+                        PhaseTimer timer{tick_profile_, &TickProfile::loot};
+                        AddLostObject(delta_time, *session);
+                    }
                     // Обновляем позицию игрока
-                    UpdatePlayerPositions(delta_time, *session);
+                    std::pmr::vector<std::string_view> retired_tokens{resource};
+                    {
+                        PhaseTimer timer{tick_profile_, &TickProfile::movement};
+                        retired_tokens = UpdatePlayerPositions(delta_time, *session, resource);
+                    }
+                    // Проверяем активность игроков и при отсутствии активности в течении
+                    //   допустимого периода - удаляем неактивных, сохранив их достижения в БД
+                    {
+                        PhaseTimer timer{tick_profile_, &TickProfile::retirement};
+                        ControlPlayersInGame(retired_tokens);
+                    }
                     // Запускаем обработчик коллизий
-                    collision_manager.HandlerCollision(*session);
+                    {
+                        PhaseTimer timer{tick_profile_, &TickProfile::collisions};
+                        collision_manager_.HandlerCollision(*session, resource);
+                    }
 
                 } // for(auto& [_, session] : game_.GetAllGameSessions())
 
+                // Миры коллизий закончившихся или замененных сессий больше не нужны
+                collision_manager_.DropStaleWorlds(game_manager_.GetAllSessions());
+
                 // Если установлен флаг необходимости авто сохранения
                 if(auto_save_needed_) {
+                    PhaseTimer timer{tick_profile_, &TickProfile::save};
                     EmitSerializeSignal();
                 }
+                if(tick_profile_) {
+                    ++tick_profile_->ticks;
+                }
                 result = {http::status::ok, json::serialize(json::object{})}; // 200
             });
             return result;
         }
 
-        void Application::UpdatePlayerPositions(double delta_time, model::GameSession &session) {
+        std::pmr::vector<std::string_view> Application::UpdatePlayerPositions(double delta_time, model::GameSession &session
+                                                , std::pmr::memory_resource* resource) {
             // Создаем вектор с токенами игроков, которых необходимо удалить из-за превышения допустимого времени неактивности
-            std::vector<std::string> token_player_for_remove;
+            std::pmr::vector<std::string_view> token_player_for_remove{resource};
+            // Получаем id карты для поиска игрока
+            const size_t map_id = Stoi(*session.GetMapId());
+            // Получаем карту дорог
+            const auto& roads_map = session.GetMapRoads();
             // Расчет перемещения в текущей карте
-            for(auto [_, dog] : session.GetDogsList()) {
+            for(const auto& [_, dog] : session.GetDogsList()) {
                 // Получаем текущую скорость игрока
                 auto start_velocity = dog->GetVelocity();
                 // Получаем направление движениия
                 model::Direction current_derect = dog->GetDirection();
-                // Получаем id карты для поиска игрока
-                size_t map_id = Stoi(*session.GetMapId());
                 // Ищем игрока
                 auto player = game_manager_.FindPlayerByDogAndMapId(static_cast<size_t>(dog->GetId()), map_id);
                 // Получаем текущую позицию
@@ -376,8 +480,6 @@ namespace app {
                                                 current_pos.x + dog->GetVelocity().vx * time
                                                 , current_pos.y + dog->GetVelocity().vy * time
                                             };
-                // Получаем карту дорог
-                auto roads_map = session.GetMapRoads();
                 // Получаем id дороги на которой находится пес
                 auto old_road_id = player->GetRoadId();
 
@@ -407,13 +509,11 @@ namespace app {
                 // Проверяем активность игрока
                 if(IsRemovePlayer(control_player, delta_time, start_velocity)) {
                     // Добавляем токен игрока, которого необходимо удалить
-                    token_player_for_remove.emplace_back(std::string(player->GetToken()));
+                    token_player_for_remove.emplace_back(player->GetToken());
                 }
             } // for(auto [_, dog] : session->GetDogsList())
 
-            // Проверяем активность игроков и при отсутствии активности в течении
-            //   допустимого периода - удаляем неактивных, сохранив их достижения в БД
-            ControlPlayersInGame(token_player_for_remove);
+            return token_player_for_remove;
         }
 
         void Application::AddLostObject(double delta_time, model::GameSession &session) {
@@ -428,10 +528,21 @@ namespace app {
 
             // Добавляем необходимое кол-во объектов на карту
             session.AddLostObjects(count_object);
+
+            // Добавляем новые предметы в мир коллизий сессии
+            if(count_object != 0) {
+                collision_manager_.AddLostObjects(session, count_object);
+            }
+        }
+
+    void Application::ControlPlayersInGame(const std::pmr::vector<std::string_view>& tokens) {
+        // В большинстве тиков удалять некого - не обращаемся к БД понапрасну
+        if(tokens.empty()) {
+            return;
         }
 
-    void Application::ControlPlayersInGame(const std::vector<std::string>& tokens) {
         std::vector<domain::PlayerRecord> player_to_record;
+        player_to_record.reserve(tokens.size());
         for(auto it = tokens.begin(); it != tokens.end(); ++it) {
             // Получаем игрока по токену
             auto player = game_manager_.GetPlayer(*it);
@@ -441,14 +552,86 @@ namespace app {
             }
             // Создаем объект игрока для записи в таблицу
             domain::PlayerRecord player_record{player->GetName(), player->GetScore()
-                                                                , player->GetTimeInGame().count()};
+                                                                , player->GetTimeInGame().count(), ++last_record_id_};
             // Добавляем игрока в вектор для записи
             player_to_record.emplace_back(player_record);
             // Удаляем пользователя из игры
             game_manager_.RemovePlayer(player);
         }
-        // Сохраняем данные в таблицу
-        use_cases_.AddPlayerRecords(player_to_record);
+        // Таблица лидеров обновляется сразу, не дожидаясь записи в БД
+        leaderboard_.Add(player_to_record);
+        // Ставим записи в очередь на сохранение, тик не ждет БД
+        records_writer_.Enqueue(std::move(player_to_record));
+    }
+
+    void Application::DrainRecords() {
+        records_writer_.Stop();
+    }
+
+    domain::PlayerRecordRepository& Application::OpenRecordsStorage(const db_conn_settings::DbConnectrioSettings& db_settings) {
+        // Таблица в памяти - то же хранилище без файла
+        if(db_settings.records_storage == db_conn_settings::RecordsStorage::EMBEDDED
+            || db_settings.records_storage == db_conn_settings::RecordsStorage::MEMORY) {
+            return records_storage_.emplace<embedded::Database>(db_settings, &Application::ReportDatabaseError).GetPlayerRecords();
+        }
+
+        return records_storage_.emplace<postgres::Database>(db_settings).GetPlayerRecords();
+    }
+
+    void Application::ReportDatabaseError(const std::string& message) {
+        logger::LogEntryToConsole(json::object{}, message, boost::log::trivial::error);
+    }
+
+    StatusMessage Application::MakeRecordsResponse(std::exception_ptr error, const std::vector<domain::PlayerRecord>& records) {
+        if(!error) {
+            return {http::status::ok, SerializeRecords(records)};
+        }
+
+        try {
+            std::rethrow_exception(error);
+        } catch(const db_ex::ConnectionTimeout&) {
+            json::object message{
+            {"code"s, "serviceUnavailable"s},
+            {"message"s, "Records storage is busy"s}
+            };
+
+            return {http::status::service_unavailable, json::serialize(message)}; //503
+        } catch(const std::exception& ex) {
+            ReportDatabaseError("Failed to read player records: "s + ex.what());
+        }
+
+        json::object message{
+        {"code"s, "internalError"s},
+        {"message"s, "Failed to read records"s}
+        };
+
+        return {http::status::internal_server_error, json::serialize(message)}; //500
+    }
+
+    StatusMessage Application::MakeInvalidCursorResponse() {
+        json::object message{
+        {"code"s, "invalidArgument"s},
+        {"message"s, "Invalid records cursor"s}
+        };
+
+        return {http::status::bad_request, json::serialize(message)}; //400
+    }
+
+    std::string Application::SerializeRecords(const std::vector<domain::PlayerRecord>& records) {
+        json::array players_records_arr;
+
+        for(const auto& player_record : records) {
+            players_records_arr.emplace_back(
+                json::object{
+                    {"name"sv, player_record.GetName()}
+                    , {"score"sv, player_record.GetScore()}
+                    , {"playTime"sv, player_record.GetPlayTime()}
+                    , {"id"sv, player_record.GetId()}
+                }
+            );
+        }
+
+        return json::serialize(players_records_arr);
     }
 
 } // app
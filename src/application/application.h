@@ -2,34 +2,39 @@
 
 //#define THREAD_POOL // есть мысли сделать в пуле
 
+#include <algorithm>
 #include <functional>
 #include <chrono>
 #include <future>
 #include <optional>
+#include <memory_resource>
 #include <mutex>
+#include <variant>
 
 #include <boost/json.hpp>
 #include <unordered_map>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/signals2.hpp>
 
-#ifdef THREAD_POOL
-    #include <boost/asio/thread_pool.hpp>
-#endif
-
 #include "../models/geometry_primitives.h"
 #include "../models/game.h"
 #include "../models/loot_generator.h"
 #include "../time_management/ticker.h"
 #include "../physics/collision_detector.h"
 #include "game_manager.h"
+#include "tick_arena.h"
+#include "collision_manager.h"
 #include "../domain_models/player.h"
 #include "../database/use_cases_impl.h"
+#include "../database/records_write_behind.h"
+#include "../database/leaderboard.h"
 #include "../database/database_connection_settings.h"
 #include "../database/postgres.h"
+#include "../database/embedded_records.h"
 
 // Предварительное объявление RestoreManager
 namespace data_persistence {
@@ -52,6 +57,21 @@ namespace app{
     using TimeType = std::optional<double>;
     using StatusMessage = pair<http::status         // Статус-код
                             ,std::string>;          // body
+    // Получатель ответа, готового не сразу (например, после запроса к БД)
+    using StatusMessageHandler = std::function<void(StatusMessage)>;
+
+    // Суммарное время этапов тика. Копится, пока приемник подключен через SetTickProfile
+    struct TickProfile {
+        using Duration = std::chrono::steady_clock::duration;
+
+        Duration loot{};
+        Duration movement{};
+        Duration collisions{};
+        // Удаление неактивных игроков и постановка их рекордов в очередь записи
+        Duration retirement{};
+        Duration save{};
+        uint64_t ticks = 0;
+    };
 
     class Application{
     public:
@@ -71,8 +91,17 @@ namespace app{
                     std::chrono::milliseconds{static_cast<uint64_t>(game_.GetGameSetting().default_period * MILLISECONDS_IN_SECOND)}
                     , game_.GetGameSetting().default_probability}}
                 , save_interval_{save_interval}
-                , data_base_{db_settings}
-                , use_cases_{data_base_.GetPlayerRecords()} {
+                , use_cases_{OpenRecordsStorage(db_settings)}
+                , records_writer_{use_cases_
+                                , db_storage::WriteBehindSettings{.journal_path = db_settings.records_journal}
+                                , &Application::ReportDatabaseError}
+                , leaderboard_{use_cases_}
+                , db_queries_{std::max<size_t>(db_settings.number_of_connection, 1)} {
+                // Загружаем лучшие рекорды, чтобы отдавать их без обращения к БД
+                leaderboard_.Warm();
+                // Номера новых записей продолжают сохраненные в БД и ожидающие в журнале
+                last_record_id_ = std::max(use_cases_.GetLastRecordId(), records_writer_.GetLastJournalId());
+
                 // Если интервал задан, то включаем автоматическое обновление времени
                 if(auto_update_interval_){
                     ticker_ = std::make_shared<time_m::Ticker>(
@@ -98,7 +127,14 @@ namespace app{
         const model::Game& GetGame()const noexcept;
         StatusMessage GetPlayerList(const std::string& token);
         StatusMessage GetGameState(const std::string& token);
+        // Записи дальше таблицы лидеров в памяти запрашиваются у БД на вызывающем потоке
         StatusMessage GetRecords(std::optional<size_t> offset, std::optional<size_t> limit);
+        // Страница рекордов после курсора "score,play_time,id,name" - последней записи предыдущей страницы
+        StatusMessage GetRecordsAfter(const std::string& after, std::optional<size_t> limit);
+        // Те же страницы через send: записи дальше таблицы лидеров в памяти запрашиваются у БД
+        // на потоках db_queries_, не занимая потоки io_context. send вызывается на потоке db_queries_
+        void GetRecords(std::optional<size_t> offset, std::optional<size_t> limit, StatusMessageHandler send);
+        void GetRecordsAfter(const std::string& after, std::optional<size_t> limit, StatusMessageHandler send);
         SerializeSignal& GetSerializeSignal() noexcept;
         RestoreSignal& GetRestoreSignal() noexcept;
 
@@ -109,9 +145,16 @@ namespace app{
         void SetRestoreGameManager(GameManager&& manager_rest);
         void SetSaveNeeded(bool auto_save_needed);
         void SetSavedGame(const SavedGame& save);
+        void SetCollisionThreads(size_t threads_count);
+        // Автоматический тик длиннее max_step_ms делится на подшаги (0 - не делить)
+        void SetTickMaxStep(size_t max_step_ms);
+        // Приемник замеров этапов тика (nullptr - замер выключен). Вызывается на strand или до запуска
+        void SetTickProfile(TickProfile* profile) noexcept;
 
         void EmitSerializeSignal();
         void EmitRestoreSignal();
+        // Дожидаемся записи в БД (или в журнал) рекордов вышедших игроков
+        void DrainRecords();
 
         GameManager& GetManager() noexcept{
             return game_manager_;
@@ -119,10 +162,18 @@ namespace app{
 
     private:
         void AddLostObject(double delta_time, model::GameSession& session);
-        void ControlPlayersInGame(const std::vector<std::string>& tokens);
+        void ControlPlayersInGame(const std::pmr::vector<std::string_view>& tokens);
         bool IsRemovePlayer(PlayerPtr player, TimeType time, model::Velocity start_velocity);
         StatusMessage UpdateGameSessions(double delta_time);
-        void UpdatePlayerPositions(double delta_time, model::GameSession& session);
+        // Возвращает токены игроков, превысивших допустимое время неактивности
+        std::pmr::vector<std::string_view> UpdatePlayerPositions(double delta_time, model::GameSession& session
+                                                                , std::pmr::memory_resource* resource);
+        static void ReportDatabaseError(const std::string& message);
+        domain::PlayerRecordRepository& OpenRecordsStorage(const db_conn_settings::DbConnectrioSettings& db_settings);
+        static std::string SerializeRecords(const std::vector<domain::PlayerRecord>& records);
+        // Ответ на запрос рекордов: страница или ошибка хранилища
+        static StatusMessage MakeRecordsResponse(std::exception_ptr error, const std::vector<domain::PlayerRecord>& records);
+        static StatusMessage MakeInvalidCursorResponse();
 
     private:
     SavedGame save_game_;
@@ -135,12 +186,27 @@ namespace app{
     std::optional<loot_gen::LootGenerator> loot_generator_;
     TimeType save_interval_;
     bool auto_save_needed_ = false;
-    postgres::Database data_base_;
+    // Хранилище рекордов выбирается при запуске (PostgreSQL или локальный файл)
+    std::variant<std::monostate, postgres::Database, embedded::Database> records_storage_;
     db_storage::UseCasesImpl use_cases_;
+    // Рекорды пишутся в БД отдельным потоком, тик только ставит их в очередь
+    db_storage::RecordsWriteBehind records_writer_;
+    // Лучшие рекорды в памяти (обновляются вместе с постановкой рекордов в очередь на запись)
+    db_storage::Leaderboard leaderboard_;
+    // Потоки запросов рекордов к хранилищу (по одному на соединение). Запрос к БД блокирует поток,
+    // а общий io_context в режиме per-core выполняет strand игры и тикер на единственном потоке
+    net::thread_pool db_queries_;
+    // Последний выданный номер записи рекорда (меняется только на strand_)
+    uint64_t last_record_id_ = 0;
     // Создаем сигнал для сериализации
     SerializeSignal serialize_signal_;
     // Создаем сигнал для восстановления
     RestoreSignal restore_signal_;
+    // Арена для временных объектов тика
+    TickArena tick_arena_;
+    // Обработчик коллизий (столкновений) с мирами коллизий сессий, живущими между тиками
+    CollisionManager collision_manager_{game_, game_manager_};
+    TickProfile* tick_profile_ = nullptr;
     };
 
 } // app
\ No newline at end of file
@@ -1,60 +1,178 @@
 #include "collision_manager.h"
 
+#include <algorithm>
+
 #include "utils.h"
 
 #include "../logging/logger.h"
+#include "../metrics/metrics.h"
 
 namespace app {
 
     using namespace std::literals;
 
     // Обработчик коллизий
-    void CollisionManager::HandlerCollision(model::GameSession& session) {
-        // Добавляем все офисы бюро находок в индекс
-        AddOfficesInItems(session.GetMap().GetOffices());
-        // Добавляем все потерянные предметы в индекс
-        AddObjectsInItems(session.GetLostObjects());
+    void CollisionManager::HandlerCollision(model::GameSession& session, std::pmr::memory_resource* resource) {
+        auto& server_metrics = metrics::GetServerMetrics();
+        metrics::ScopedTimer timer{server_metrics.collision_duration};
+
+        // Получаем мир коллизий сессии (офисы и потерянные предметы в нем уже есть)
+        SessionCollisionWorld& world = GetWorld(session);
         // Добавляем всех соискателей в индекс
-        AddGatherer(session.GetDogsList());
+        AddGatherer(world, session.GetDogsList());
         // Получаем список всех событий
-        auto events = collision_detector::FindGatherEvents(provider_);
+        size_t tested_pairs = 0;
+        auto events = parallel_finder_ ? parallel_finder_->FindGatherEvents(world.provider, resource, &tested_pairs)
+                                       : collision_detector::FindGatherEvents(world.provider, resource, &tested_pairs);
+        server_metrics.collision_pairs_tested.Add(tested_pairs);
+        server_metrics.collision_events.Add(events.size());
         // Обрабатываем события
-        RequestEvent(session, events);
-        // Очищаем все индексы в провайдере
-        ResetProvider();
+        RequestEvent(session, world, events, resource);
+        // Соискатели перемещаются каждый тик - очищаем их индекс
+        world.provider.ResetGathererList();
+    }
+
+    // Добавляем в мир коллизий появившиеся на карте потерянные предметы
+    void CollisionManager::AddLostObjects(const model::GameSession& session, size_t spawned_count) {
+        SessionCollisionWorld& world = GetWorld(session);
+        const auto& lost_objects = session.GetLostObjects();
+
+        // Новые предметы получают id, следующие за последним известным: проверяем только их
+        size_t found = 0;
+        for(; found < spawned_count; ++found) {
+            const size_t id = world.lost_object_watermark + 1;
+            const auto it = lost_objects.find(id);
+            if(it == lost_objects.end()) {
+                break;
+            }
+            if(!world.provider.ContainsItem(id)) {
+                AddObjectInItems(world, session.GetMap(), it->second);
+            }
+            world.lost_object_watermark = id;
+        }
+
+        // Id новых предметов идут не подряд (например, после восстановления игры) - сверяем все предметы
+        if(found < spawned_count) {
+            AddMissingObjects(world, session);
+        }
+    }
+
+    // Удаляем все миры коллизий (например, после восстановления игры)
+    void CollisionManager::Reset() noexcept {
+        worlds_.clear();
+    }
+
+    // Мир удаляется, если его сессии нет в списке или под тем же id теперь другой объект сессии
+    void CollisionManager::DropStaleWorlds(const AllGameSessionsList& sessions) {
+        std::erase_if(worlds_, [&sessions](const auto& entry) {
+            const auto session = sessions.find(entry.first);
+            return session == sessions.end() || session->second.get() != entry.second.session;
+        });
+    }
+
+    // Задаем число потоков поиска событий
+    void CollisionManager::SetThreadsCount(size_t threads_count) {
+        if(threads_count <= 1) {
+            parallel_finder_.reset();
+            return;
+        }
+
+        parallel_finder_ = std::make_unique<collision_detector::ParallelGatherEventsFinder>(threads_count);
+    }
+
+    // Получаем мир коллизий сессии, при первом обращении строим его
+    SessionCollisionWorld& CollisionManager::GetWorld(const model::GameSession& session) {
+        SessionCollisionWorld& world = worlds_[session.GetGameSessionId()];
+
+        // Сессия совпадает с той, по которой строился мир - индекс актуален
+        if(world.session == &session) {
+            return world;
+        }
+
+        const model::Map& map = session.GetMap();
+
+        world.session = &session;
+        world.lost_object_watermark = 0;
+        world.provider.FullResetLists();
+        SetWorldParameters(world, map);
+        world.provider.Reserve(map.GetOffices().size() + session.GetLostObjects().size()
+                            , session.GetDogsList().size());
+        // Офисы статичны для карты - добавляем их один раз
+        AddOfficesInItems(world, map.GetOffices());
+        // Добавляем все потерянные предметы в индекс
+        AddObjectsInItems(world, map, session.GetLostObjects());
+        for(const auto& [id, _] : session.GetLostObjects()) {
+            RaiseLostObjectWatermark(world, id);
+        }
+
+        return world;
+    }
+
+    // Задаем радиусы столкновений и размер ячейки сетки по параметрам карты
+    void CollisionManager::SetWorldParameters(SessionCollisionWorld& world, const model::Map& map) const {
+        const auto& setting = game_.GetGameSetting();
+        world.office_width = map.GetOfficeWidth().value_or(setting.default_office_width);
+        world.dog_width = map.GetDogWidth().value_or(setting.default_player_width);
+
+        // Если размер ячейки не задан, берем диаметр наибольшей зоны подбора: собиратель за тик
+        // проходит немного, поэтому область поиска накрывает всего несколько ячеек
+        const double max_item_width = std::max(world.office_width, map.GetMaxLootWidth());
+        world.provider.SetCellSize(map.GetCollisionCellSize().value_or(2.0 * (world.dog_width + max_item_width)));
     }
 
     // Добавляем все офисы бюро находок в индекс
-    void CollisionManager::AddOfficesInItems(const std::vector<model::Office>& offices) {
-        for(const auto& office : offices){
+    void CollisionManager::AddOfficesInItems(SessionCollisionWorld& world, const std::vector<model::Office>& offices) {
+        for(size_t i = 0; i < offices.size(); ++i){
             collision_detector::Item item{
-                .position = { static_cast<double>(office.GetPosition().x)
-                            , static_cast<double>(office.GetPosition().y)
+                .position = { static_cast<double>(offices[i].GetPosition().x)
+                            , static_cast<double>(offices[i].GetPosition().y)
                 }
-                , .width = game_.GetGameSetting().default_office_width
+                , .width = world.office_width
                 , .type = collision_detector::BASE
             };
 
-            provider_.AddItem(Stoi(*office.GetId()),item);        
+            world.provider.AddItem(OFFICE_ITEM_ID_FLAG | i, item);
         }
     }
 
     // Добавляем все потерянные предметы в индекс
-    void CollisionManager::AddObjectsInItems(const std::unordered_map<size_t, model::LostObject> &lost_object) {
+    void CollisionManager::AddObjectsInItems(SessionCollisionWorld& world, const model::Map& map
+                                            , const std::unordered_map<size_t, model::LostObject> &lost_object) {
         for(const auto& object : lost_object){
-            collision_detector::Item item{
-                .position = { static_cast<double>(object.second.GetPosition().x)
-                            , static_cast<double>(object.second.GetPosition().y)
-                }
-                , .width = game_.GetGameSetting().default_office_width
-            };
-                
-            provider_.AddItem(object.second.GetId(),item);
+            AddObjectInItems(world, map, object.second);
+        }
+    }
+
+    // Добавляем потерянный предмет в индекс с радиусом подбора его типа
+    void CollisionManager::AddObjectInItems(SessionCollisionWorld& world, const model::Map& map
+                                            , const model::LostObject& object) {
+        collision_detector::Item item{
+            .position = { static_cast<double>(object.GetPosition().x)
+                        , static_cast<double>(object.GetPosition().y)
+            }
+            , .width = map.GetLootWidth(object.GetType())
+        };
+            
+        world.provider.AddItem(object.GetId(),item);
+    }
+
+    // Добавляем в индекс предметы сессии, которых в нем еще нет
+    void CollisionManager::AddMissingObjects(SessionCollisionWorld& world, const model::GameSession& session) {
+        for(const auto& [id, object] : session.GetLostObjects()) {
+            if(!world.provider.ContainsItem(id)) {
+                AddObjectInItems(world, session.GetMap(), object);
+            }
+            RaiseLostObjectWatermark(world, id);
         }
     }
 
+    void CollisionManager::RaiseLostObjectWatermark(SessionCollisionWorld& world, size_t id) noexcept {
+        world.lost_object_watermark = std::max(world.lost_object_watermark, id);
+    }
+
     // Добавляем всех соискателей в индекс
-    void CollisionManager::AddGatherer(const std::unordered_map<uint64_t, std::shared_ptr<model::Dog>> &gatherer) {
+    void CollisionManager::AddGatherer(SessionCollisionWorld& world
+                                    , const std::unordered_map<uint64_t, std::shared_ptr<model::Dog>> &gatherer) {
         for(const auto& dog : gatherer){
             collision_detector::Gatherer gather{
                 .start_pos = {dog.second->GetOldPosition().x
@@ -63,23 +181,41 @@ namespace app {
                 , .end_pos = {dog.second->GetCurrentPosition().x
                             , dog.second->GetCurrentPosition().y
                 }
-                , .width = game_.GetGameSetting().default_player_width
+                , .width = world.dog_width
             };
 
-            provider_.AddGatherer(dog.first, gather);
+            world.provider.AddGatherer(dog.first, gather);
         }
     }
 
-    // Очищаем все индексы в провайдере
-    void CollisionManager::ResetProvider() noexcept {
-        provider_.FullResetLists();
-    }
-
     // Обрабатываем события
-    void CollisionManager::RequestEvent(model::GameSession& session, std::vector<collision_detector::GatheringEvent>& events) {
+    void CollisionManager::RequestEvent(model::GameSession& session, SessionCollisionWorld& world
+                                        , std::pmr::vector<collision_detector::GatheringEvent>& events
+                                        , std::pmr::memory_resource* resource) {
+        // Получаем id карты для поиска игроков
+        const size_t map_id = Stoi(*session.GetMapId());
+        // Игроки, уже найденные по id собаки (события спорных собирателей идут вперемешку)
+        std::pmr::unordered_map<size_t, domain::Player*> players{resource};
+        size_t current_gatherer_id = 0;
+        domain::Player* player = nullptr;
+
         for(auto& event : events){
-            // Находим игрока
-            auto player = game_manager_.FindPlayerByDogAndMapId(event.gatherer_id, Stoi(*session.GetMapId()));
+            // Находим игрока один раз на собирателя: события одного собирателя обычно идут подряд
+            if(player == nullptr || event.gatherer_id != current_gatherer_id) {
+                auto [found, inserted] = players.try_emplace(event.gatherer_id, nullptr);
+
+                if(inserted) {
+                    found->second = game_manager_.FindPlayerByDogAndMapId(event.gatherer_id, map_id);
+                }
+
+                current_gatherer_id = event.gatherer_id;
+                player = found->second;
+            }
+
+            if(player == nullptr) {
+                continue;
+            }
+
             // Проверяем что это событие - сбор потерянного предмета
             if(event.actor == collision_detector::Actor::MOVE_BAG){
                 // Проверяем есть ли место в рюкзаке
@@ -93,6 +229,9 @@ namespace app {
                     // Удаляем предмет из эндекса элементов сессии, чтобы больше его не добавлять
                     session.RemoveLostObj(event.item_id);
                     }
+
+                    // Предмета больше нет на карте - убираем его из мира коллизий
+                    world.provider.RemoveItem(event.item_id);
                 }
                 continue;
             }
@@ -104,4 +243,4 @@ namespace app {
         }
     }
 
-} //namespace app
\ No newline at end of file
+} //namespace app
@@ -1,7 +1,10 @@
 #pragma once 
 
 #include "../physics/collision_detector.h"
+#include "../physics/parallel_collision_detector.h"
 
+#include <memory>
+#include <memory_resource>
 #include <unordered_map>
 
 #include "game_manager.h"
@@ -13,6 +16,22 @@
 
 namespace app{
 
+    // Признак id офиса в индексе предметов (чтобы id офисов не пересекались с id потерянных предметов)
+    const size_t OFFICE_ITEM_ID_FLAG = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+    // Мир коллизий сессии. Офисы добавляются один раз при создании, потерянные предметы - по мере
+    // появления и подбора, собиратели - заново в каждом тике
+    struct SessionCollisionWorld {
+        const model::GameSession* session = nullptr;
+        collision_detector::ItemGathererProviderImpl provider;
+        // Радиусы столкновений карты сессии
+        double office_width = 0.0;
+        double dog_width = 0.0;
+        // Наибольший id потерянного предмета сессии, уже известный миру. Id выдаются по возрастанию,
+        // поэтому новые предметы ищутся сразу за ним, без обхода всех предметов сессии
+        size_t lost_object_watermark = 0;
+    };
+
     class CollisionManager{
     public:
         CollisionManager(model::Game& game, GameManager& game_manager) 
@@ -20,19 +39,39 @@ namespace app{
         , game_manager_{game_manager} { 
         }
 
-        void HandlerCollision(model::GameSession& session);
+        // Временные списки событий размещаются в resource (арена тика)
+        void HandlerCollision(model::GameSession& session
+                            , std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        // Добавляем в мир коллизий spawned_count предметов, только что созданных генератором
+        void AddLostObjects(const model::GameSession& session, size_t spawned_count);
+        void Reset() noexcept;
+        // Удаляем миры коллизий сессий, которых больше нет (или которые заменены другим объектом)
+        void DropStaleWorlds(const AllGameSessionsList& sessions);
+        // Число потоков поиска событий внутри одной сессии (1 - поиск в потоке тика)
+        void SetThreadsCount(size_t threads_count);
 
     private:
-        void AddOfficesInItems(const std::vector<model::Office>& offices);
-        void AddObjectsInItems(const std::unordered_map<size_t, model::LostObject>& lost_object);
-        void AddGatherer(const std::unordered_map<uint64_t, std::shared_ptr<model::Dog>>& gatherer);
-        void ResetProvider() noexcept;
-        void RequestEvent(model::GameSession& session, std::vector<collision_detector::GatheringEvent>& events);
+        SessionCollisionWorld& GetWorld(const model::GameSession& session);
+        void SetWorldParameters(SessionCollisionWorld& world, const model::Map& map) const;
+        void AddOfficesInItems(SessionCollisionWorld& world, const std::vector<model::Office>& offices);
+        void AddObjectsInItems(SessionCollisionWorld& world, const model::Map& map
+                            , const std::unordered_map<size_t, model::LostObject>& lost_object);
+        void AddObjectInItems(SessionCollisionWorld& world, const model::Map& map, const model::LostObject& object);
+        void AddMissingObjects(SessionCollisionWorld& world, const model::GameSession& session);
+        static void RaiseLostObjectWatermark(SessionCollisionWorld& world, size_t id) noexcept;
+        void AddGatherer(SessionCollisionWorld& world
+                            , const std::unordered_map<uint64_t, std::shared_ptr<model::Dog>>& gatherer);
+        void RequestEvent(model::GameSession& session, SessionCollisionWorld& world
+                            , std::pmr::vector<collision_detector::GatheringEvent>& events
+                            , std::pmr::memory_resource* resource);
 
     private:
         model::Game& game_;
         GameManager& game_manager_;
-        collision_detector::ItemGathererProviderImpl provider_;
+        // Миры коллизий по id сессии
+        std::unordered_map<size_t, SessionCollisionWorld> worlds_;
+        // Многопоточный поиск событий для больших сессий (если задано больше одного потока)
+        std::unique_ptr<collision_detector::ParallelGatherEventsFinder> parallel_finder_;
     };
 
-} //app
\ No newline at end of file
+} //app
@@ -154,6 +154,15 @@ namespace app {
         dog_id_ = dog_id;
     }
 
+    void GameManager::Reserve(size_t sessions_count, size_t players_count) {
+        players_.reserve(players_count);
+        dog_id_and_map_id_to_players_.reserve(players_count);
+        token_to_player_.reserve(players_count);
+        id_session_to_players_.reserve(sessions_count);
+        game_session_.reserve(sessions_count);
+        all_sessions_list_.reserve(sessions_count);
+    }
+
     bool GameManager::operator==(const GameManager& other) const {
         return is_restore_ == other.is_restore_
                 && players_ == other.players_
@@ -132,6 +132,9 @@ class Player;
 
         void SetDogId(size_t dog_id);
 
+        // Заранее выделяем место во всех индексах (при восстановлении из сохранения)
+        void Reserve(size_t sessions_count, size_t players_count);
+
         bool operator==(const GameManager& other) const;
 
         void RemovePlayer(PlayerPtr player);
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace app {
+
+    // Начальный размер арены тика (байт)
+    const size_t DEFAULT_TICK_ARENA_SIZE = 64 * 1024;
+
+    // Арена для временных объектов одного тика игры (индексы коллизий, списки событий, токены на удаление).
+    // Память выделяется из заранее подготовленного буфера и освобождается целиком в начале следующего тика.
+    // Если за тик буфера не хватило, недостающая память берется из кучи, а к следующему тику буфер
+    // увеличивается, поэтому в установившемся режиме тик обходится без обращений к глобальной куче.
+    class TickArena {
+    public:
+        explicit TickArena(size_t initial_size = DEFAULT_TICK_ARENA_SIZE)
+            : buffer_(initial_size) {
+            arena_.emplace(buffer_.data(), buffer_.size(), &upstream_);
+        }
+
+        TickArena(const TickArena&) = delete;
+        TickArena& operator=(const TickArena&) = delete;
+
+        // Ресурс памяти текущего тика
+        std::pmr::memory_resource* Resource() noexcept {
+            return &*arena_;
+        }
+
+        // Освобождаем память предыдущего тика. Все объекты, размещенные в арене, к этому моменту
+        // должны быть уничтожены
+        void Reset() {
+            size_t spilled = upstream_.TakeSpilledBytes();
+
+            if(spilled == 0) {
+                arena_->release();
+                return;
+            }
+
+            // В прошлом тике буфера не хватило - расширяем его с запасом
+            arena_.reset();
+            buffer_.resize((buffer_.size() + spilled) * 2);
+            arena_.emplace(buffer_.data(), buffer_.size(), &upstream_);
+        }
+
+        size_t Capacity() const noexcept {
+            return buffer_.size();
+        }
+
+    private:
+        // Вышестоящий ресурс: берет память из кучи и запоминает, сколько ее понадобилось сверх буфера
+        class SpillCountingResource : public std::pmr::memory_resource {
+        public:
+            size_t TakeSpilledBytes() noexcept {
+                size_t result = spilled_bytes_;
+                spilled_bytes_ = 0;
+                return result;
+            }
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                spilled_bytes_ += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+
+        private:
+            size_t spilled_bytes_ = 0;
+        };
+
+    private:
+        std::vector<std::byte> buffer_;
+        SpillCountingResource upstream_;
+        std::optional<std::pmr::monotonic_buffer_resource> arena_;
+    };
+
+} // app
@@ -1,23 +1,68 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <condition_variable>
+#include <optional>
+#include <system_error>
+#include <vector>
 
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 #include <pqxx/connection>
 
 #include "database_exceptions.h"
+#include "../metrics/metrics.h"
 
 namespace db {
 
-    class ConnectionPool {
-        using PoolType = ConnectionPool;
-        using ConnectionPtr = std::shared_ptr<pqxx::connection>;
+    // Сколько по умолчанию ждать свободного соединения
+    const std::chrono::milliseconds DEFAULT_ACQUIRE_TIMEOUT{5'000};
+
+    // Снимок состояния пула соединений
+    struct ConnectionPoolMetrics {
+        size_t capacity = 0;
+        size_t in_use = 0;
+        // Ожидающие соединения (синхронно и асинхронно)
+        size_t waiting = 0;
+        uint64_t acquired = 0;
+        uint64_t timeouts = 0;
+        uint64_t reconnects = 0;
+        uint64_t failed_reconnects = 0;
+        // Суммарное и наибольшее время ожидания соединения
+        std::chrono::nanoseconds total_wait{0};
+        std::chrono::nanoseconds max_wait{0};
+    };
+
+    // Пул соединений. Соединение можно получить синхронно (с ожиданием на condition_variable)
+    // или асинхронно: обработчик вызывается на исполнителе io_context, когда соединение освободится,
+    // поэтому потоки io_context не блокируются. Синхронные и асинхронные запросы обслуживаются
+    // в общем порядке поступления (по номеру очереди), ни те ни другие не ждут дольше остальных.
+    // Перед выдачей закрытое соединение пересоздается фабрикой. Ожидание, истекшие ожидания
+    // и переподключения попадают и в снимок GetMetrics, и в показатели сервера (metrics::ServerMetrics).
+    // Пул должен пережить все выданные соединения и незавершенные асинхронные запросы
+    template <typename Connection>
+    class BasicConnectionPool {
+        using PoolType = BasicConnectionPool;
+        using ConnectionPtr = std::shared_ptr<Connection>;
+        using Clock = std::chrono::steady_clock;
 
     public:
+        using ConnectionFactory = std::function<ConnectionPtr()>;
+
         class ConnectionWrapper {
         public:
-            ConnectionWrapper(std::shared_ptr<pqxx::connection>&& conn, PoolType& pool) noexcept
+            ConnectionWrapper(std::shared_ptr<Connection>&& conn, PoolType& pool) noexcept
                 : conn_{std::move(conn)}
                 , pool_{&pool} {
             }
@@ -26,17 +71,33 @@ namespace db {
             ConnectionWrapper& operator=(const ConnectionWrapper&) = delete;
 
             ConnectionWrapper(ConnectionWrapper&&) = default;
-            ConnectionWrapper& operator=(ConnectionWrapper&&) = default;
 
-            pqxx::connection& operator*() const& noexcept {
+            // Прежнее соединение возвращается в пул, а не теряется
+            ConnectionWrapper& operator=(ConnectionWrapper&& other) noexcept {
+                if (this != &other) {
+                    if (conn_) {
+                        pool_->ReturnConnection(std::move(conn_));
+                    }
+                    conn_ = std::move(other.conn_);
+                    pool_ = other.pool_;
+                }
+                return *this;
+            }
+
+            Connection& operator*() const& noexcept {
                 return *conn_;
             }
-            pqxx::connection& operator*() const&& = delete;
+            Connection& operator*() const&& = delete;
 
-            pqxx::connection* operator->() const& noexcept {
+            Connection* operator->() const& noexcept {
                 return conn_.get();
             }
 
+            // Пустая обертка приходит в асинхронный обработчик вместе с ошибкой
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(conn_);
+            }
+
             ~ConnectionWrapper() {
                 if (conn_) {
                     pool_->ReturnConnection(std::move(conn_));
@@ -44,49 +105,314 @@ namespace db {
             }
 
         private:
-            std::shared_ptr<pqxx::connection> conn_;
+            friend class BasicConnectionPool;
+
+            std::shared_ptr<Connection> conn_;
             PoolType* pool_;
         };
 
-        // ConnectionFactory is a functional object returning std::shared_ptr<pqxx::connection>
-        template <typename ConnectionFactory>
-        ConnectionPool(size_t capacity, ConnectionFactory&& connection_factory) {
+        BasicConnectionPool(size_t capacity, ConnectionFactory connection_factory)
+            : connection_factory_{std::move(connection_factory)} {
             pool_.reserve(capacity);
             for (size_t i = 0; i < capacity; ++i) {
-                pool_.emplace_back(connection_factory());
+                pool_.emplace_back(connection_factory_());
+            }
+        }
+
+        BasicConnectionPool(const BasicConnectionPool&) = delete;
+        BasicConnectionPool& operator=(const BasicConnectionPool&) = delete;
+
+        // Незавершенные асинхронные запросы получают operation_canceled
+        ~BasicConnectionPool() {
+            std::deque<std::shared_ptr<AsyncWaiter>> waiters;
+            {
+                std::lock_guard lock{mutex_};
+                waiters.swap(async_waiters_);
+            }
+
+            for (auto& waiter : waiters) {
+                waiter->Complete(std::make_error_code(std::errc::operation_canceled), nullptr);
             }
         }
 
         ConnectionWrapper GetConnection() {
-            std::unique_lock lock{mutex_};
-            // Блокируем текущий поток и ждём, пока cond_var_ не получит уведомление и не освободится
-            // хотя бы одно соединение
-            cond_var_.wait(lock, [this] {
-                return used_connections_ < pool_.size();
-            });
-            // После выхода из цикла ожидания мьютекс остаётся захваченным
-
-            return {std::move(pool_[used_connections_++]), *this};
+            return Acquire(std::nullopt);
+        }
+
+        // Если соединение не освободилось за timeout, бросается db_ex::ConnectionTimeout
+        ConnectionWrapper GetConnection(std::chrono::milliseconds timeout) {
+            return Acquire(timeout);
+        }
+
+        // Асинхронное получение соединения. Сигнатура завершения void(std::error_code, ConnectionWrapper):
+        // std::errc::timed_out - соединение не освободилось за timeout,
+        // std::errc::connection_refused - закрытое соединение не удалось открыть заново
+        template <typename Executor, typename CompletionToken>
+        auto AsyncGetConnection(const Executor& executor, std::chrono::milliseconds timeout, CompletionToken&& token) {
+            return boost::asio::async_initiate<CompletionToken, void(std::error_code, ConnectionWrapper)>(
+                [this, executor, timeout](auto handler) {
+                    StartAcquire(boost::asio::any_io_executor{executor}, timeout, std::move(handler));
+                }
+                , token
+            );
+        }
+
+        // Число соединений в пуле (не меняется после создания)
+        size_t Capacity() const noexcept {
+            return pool_.size();
+        }
+
+        ConnectionPoolMetrics GetMetrics() const {
+            std::lock_guard lock{mutex_};
+            ConnectionPoolMetrics metrics = metrics_;
+            metrics.capacity = pool_.size();
+            metrics.in_use = used_connections_;
+            metrics.waiting = async_waiters_.size() + sync_waiters_.size();
+            return metrics;
         }
 
     private:
+        // Асинхронный запрос соединения, ожидающий в очереди
+        class AsyncWaiter {
+        public:
+            virtual ~AsyncWaiter() = default;
+            // Передаем соединение (или ошибку) обработчику на его исполнителе
+            virtual void Complete(std::error_code ec, ConnectionPtr conn) = 0;
+
+            const Clock::time_point start = Clock::now();
+            // Номер в общей с синхронными запросами очереди
+            uint64_t ticket = 0;
+            std::atomic_bool done{false};
+        };
+
+        // Синхронный запрос: поток ждет, пока освободившееся соединение не будет передано ему
+        struct SyncWaiter {
+            uint64_t ticket = 0;
+            Clock::time_point start;
+            ConnectionPtr conn;
+            std::condition_variable cond_var;
+        };
+
+        // Таймер ожидания работает на своем strand: взвод и отмена таймера приходят из разных потоков
+        template <typename Handler>
+        class AsyncWaiterImpl : public AsyncWaiter
+                              , public std::enable_shared_from_this<AsyncWaiterImpl<Handler>> {
+        public:
+            AsyncWaiterImpl(PoolType& pool, Handler&& handler, boost::asio::any_io_executor executor)
+                : pool_{pool}
+                , handler_{std::move(handler)}
+                , executor_{executor}
+                , timer_{boost::asio::make_strand(executor)} {
+            }
+
+            void Start(std::chrono::milliseconds timeout) {
+                boost::asio::post(timer_.get_executor(), [self = this->shared_from_this(), timeout] {
+                    if (self->done) {
+                        return;
+                    }
+
+                    self->timer_.expires_after(timeout);
+                    self->timer_.async_wait([self](const boost::system::error_code& ec) {
+                        if (!ec && !self->done) {
+                            self->pool_.OnWaitTimeout(self);
+                        }
+                    });
+                });
+            }
+
+            void Complete(std::error_code ec, ConnectionPtr conn) override {
+                this->done = true;
+                boost::asio::post(timer_.get_executor(), [self = this->shared_from_this()] {
+                    self->timer_.cancel();
+                });
+                pool_.Deliver(std::move(handler_), executor_, ec, std::move(conn));
+            }
+
+        private:
+            PoolType& pool_;
+            Handler handler_;
+            boost::asio::any_io_executor executor_;
+            boost::asio::steady_timer timer_;
+        };
+
+        ConnectionWrapper Acquire(std::optional<std::chrono::milliseconds> timeout) {
+            ConnectionPtr conn;
+            {
+                std::unique_lock lock{mutex_};
+
+                if (used_connections_ < pool_.size()) {
+                    conn = std::move(pool_[used_connections_++]);
+                    RecordWait(Clock::duration::zero());
+                } else {
+                    // Встаем в очередь и ждем, пока ReturnConnection не передаст соединение
+                    SyncWaiter waiter{.ticket = next_ticket_++, .start = Clock::now()};
+                    sync_waiters_.push_back(&waiter);
+                    auto is_delivered = [&waiter] {
+                        return static_cast<bool>(waiter.conn);
+                    };
+
+                    if (timeout) {
+                        if (!waiter.cond_var.wait_for(lock, *timeout, is_delivered)) {
+                            sync_waiters_.erase(std::find(sync_waiters_.begin(), sync_waiters_.end(), &waiter));
+                            RecordTimeout();
+                            throw db_ex::ConnectionTimeout{};
+                        }
+                    } else {
+                        waiter.cond_var.wait(lock, is_delivered);
+                    }
+                    // После выхода из ожидания мьютекс остаётся захваченным
+
+                    conn = std::move(waiter.conn);
+                }
+            }
+
+            ConnectionWrapper wrapper{std::move(conn), *this};
+            // Если переподключиться не удалось, обертка вернет закрытое соединение в пул
+            Reconnect(wrapper.conn_);
+            return wrapper;
+        }
+
+        template <typename Handler>
+        void StartAcquire(boost::asio::any_io_executor executor, std::chrono::milliseconds timeout, Handler&& handler) {
+            ConnectionPtr conn;
+            {
+                std::lock_guard lock{mutex_};
+
+                if (used_connections_ == pool_.size()) {
+                    auto waiter = std::make_shared<AsyncWaiterImpl<std::decay_t<Handler>>>(*this, std::move(handler), executor);
+                    // Таймер взводится раньше, чем запрос станет виден в очереди, иначе отмена могла бы его опередить
+                    waiter->Start(timeout);
+                    waiter->ticket = next_ticket_++;
+                    async_waiters_.emplace_back(std::move(waiter));
+                    return;
+                }
+
+                conn = std::move(pool_[used_connections_++]);
+                RecordWait(Clock::duration::zero());
+            }
+
+            // Обработчик не вызывается изнутри инициирующей функции
+            Deliver(std::move(handler), executor, {}, std::move(conn));
+        }
+
+        template <typename Handler>
+        void Deliver(Handler&& handler, const boost::asio::any_io_executor& executor, std::error_code ec, ConnectionPtr conn) {
+            auto handler_executor = boost::asio::get_associated_executor(handler, executor);
+            boost::asio::post(handler_executor
+                , [this, handler = std::move(handler), ec, wrapper = ConnectionWrapper{std::move(conn), *this}]() mutable {
+                    if (wrapper) {
+                        try {
+                            Reconnect(wrapper.conn_);
+                        } catch (...) {
+                            ec = std::make_error_code(std::errc::connection_refused);
+                            ConnectionWrapper broken = std::move(wrapper);
+                        }
+                    }
+                    handler(ec, std::move(wrapper));
+                }
+            );
+        }
+
+        void OnWaitTimeout(const std::shared_ptr<AsyncWaiter>& waiter) {
+            {
+                std::lock_guard lock{mutex_};
+                auto it = std::find(async_waiters_.begin(), async_waiters_.end(), waiter);
+
+                // Соединение уже передано этому запросу
+                if (it == async_waiters_.end()) {
+                    return;
+                }
+
+                async_waiters_.erase(it);
+                RecordTimeout();
+            }
+
+            waiter->Complete(std::make_error_code(std::errc::timed_out), nullptr);
+        }
+
+        // Закрытое соединение (например, после обрыва связи с сервером) заменяем новым
+        void Reconnect(ConnectionPtr& conn) {
+            if (conn->is_open()) {
+                return;
+            }
+
+            try {
+                conn = connection_factory_();
+            } catch (...) {
+                std::lock_guard lock{mutex_};
+                ++metrics_.failed_reconnects;
+                throw;
+            }
+
+            metrics::GetServerMetrics().db_reconnects.Add();
+            std::lock_guard lock{mutex_};
+            ++metrics_.reconnects;
+        }
+
         void ReturnConnection(ConnectionPtr&& conn) {
+            std::shared_ptr<AsyncWaiter> waiter;
             // Возвращаем соединение обратно в пул
             {
                 std::lock_guard lock{mutex_};
                 if(used_connections_ == 0) {
                     db_ex::ReturnZeroDbConnection();
                 }
-                pool_[--used_connections_] = std::move(conn);
+
+                // Первый по очереди запрос получает соединение напрямую, минуя пул
+                const bool sync_first = !sync_waiters_.empty()
+                                     && (async_waiters_.empty() || sync_waiters_.front()->ticket < async_waiters_.front()->ticket);
+
+                if (sync_first) {
+                    SyncWaiter* sync_waiter = sync_waiters_.front();
+                    sync_waiters_.pop_front();
+                    RecordWait(Clock::now() - sync_waiter->start);
+                    sync_waiter->conn = std::move(conn);
+                    sync_waiter->cond_var.notify_one();
+                    return;
+                }
+
+                if (!async_waiters_.empty()) {
+                    waiter = std::move(async_waiters_.front());
+                    async_waiters_.pop_front();
+                    RecordWait(Clock::now() - waiter->start);
+                } else {
+                    pool_[--used_connections_] = std::move(conn);
+                }
+            }
+
+            if (waiter) {
+                waiter->Complete({}, std::move(conn));
             }
-            // Уведомляем один из ожидающих потоков об изменении состояния пула
-            cond_var_.notify_one();
         }
 
-        std::mutex mutex_;
-        std::condition_variable cond_var_;
+        // Вызывается под mutex_
+        void RecordWait(Clock::duration wait) {
+            const auto wait_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait);
+            ++metrics_.acquired;
+            metrics_.total_wait += wait_ns;
+            metrics_.max_wait = std::max(metrics_.max_wait, wait_ns);
+            metrics::GetServerMetrics().db_pool_wait.Record(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(wait).count()));
+        }
+
+        // Вызывается под mutex_
+        void RecordTimeout() {
+            ++metrics_.timeouts;
+            metrics::GetServerMetrics().db_pool_timeouts.Add();
+        }
+
+        ConnectionFactory connection_factory_;
+
+        mutable std::mutex mutex_;
         std::vector<ConnectionPtr> pool_;
         size_t used_connections_ = 0;
-    }; 
+        // Общая нумерация запросов обеих очередей: соединение получает запрос с меньшим номером
+        uint64_t next_ticket_ = 0;
+        std::deque<SyncWaiter*> sync_waiters_;
+        std::deque<std::shared_ptr<AsyncWaiter>> async_waiters_;
+        ConnectionPoolMetrics metrics_;
+    };
+
+    using ConnectionPool = BasicConnectionPool<pqxx::connection>;
 
-}
\ No newline at end of file
+}
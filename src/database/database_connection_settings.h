@@ -1,12 +1,29 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 
 namespace db_conn_settings {
 
+    // Где хранится таблица рекордов
+    enum class RecordsStorage {
+        POSTGRES,
+        // Локальный файл, внешняя БД не нужна
+        EMBEDDED,
+        // Только память процесса, рекорды не переживают перезапуск (замеры и тесты)
+        MEMORY
+    };
+
     struct DbConnectrioSettings {
         size_t number_of_connection{1};
         std::string db_url{};
+        // Журнал рекордов, которые не удалось сохранить в БД (пустой путь - журнал не ведется)
+        std::string records_journal{};
+        // Сколько запрос к БД ждет свободного соединения
+        std::chrono::milliseconds acquire_timeout{5'000};
+        RecordsStorage records_storage{RecordsStorage::POSTGRES};
+        // Файл таблицы рекордов для RecordsStorage::EMBEDDED
+        std::string records_log{};
     };
 
 }
\ No newline at end of file
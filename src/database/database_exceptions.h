@@ -1,6 +1,8 @@
 #pragma once
 
 #include <exception>
+#include <stdexcept>
+#include <string>
 
 namespace db_ex {
 
@@ -18,4 +20,19 @@ namespace db_ex {
         }
     };
 
+    class ConnectionTimeout : public std::exception {
+    public:
+        char const* what () const noexcept override {
+            return "Timed out waiting for a free database connection.";
+        }
+    };
+
+    // Номер записи рекорда уже занят другой записью (например, его выдал другой экземпляр сервера)
+    class RecordIdConflict : public std::runtime_error {
+    public:
+        explicit RecordIdConflict(const std::string& details)
+            : std::runtime_error("Player record id is taken by another record: " + details) {
+        }
+    };
+
 }
\ No newline at end of file
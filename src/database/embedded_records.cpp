@@ -0,0 +1,370 @@
+#include "embedded_records.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#include <boost/asio/post.hpp>
+#include <boost/crc.hpp>
+
+namespace embedded {
+
+    using namespace std::literals;
+
+    namespace {
+
+        const size_t RECORD_HEADER_SIZE = sizeof(uint64_t) + sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint32_t);
+        const size_t RECORD_CHECKSUM_SIZE = sizeof(uint32_t);
+
+        void AppendLittleEndian(std::string& out, uint64_t value, size_t size) {
+            for(size_t i = 0; i < size; ++i) {
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        uint64_t ReadLittleEndian(const char* data, size_t size) {
+            uint64_t value = 0;
+
+            for(size_t i = 0; i < size; ++i) {
+                value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+            }
+
+            return value;
+        }
+
+        uint32_t Checksum(const char* data, size_t size) {
+            boost::crc_32_type crc;
+            crc.process_bytes(data, size);
+            return crc.checksum();
+        }
+
+        void AppendRecord(std::string& out, const domain::PlayerRecord& record) {
+            const size_t start = out.size();
+            AppendLittleEndian(out, record.GetId(), sizeof(uint64_t));
+            AppendLittleEndian(out, record.GetScore(), sizeof(uint64_t));
+            AppendLittleEndian(out, static_cast<uint64_t>(record.GetPlayTime()), sizeof(int64_t));
+            AppendLittleEndian(out, record.GetName().size(), sizeof(uint32_t));
+            out += record.GetName();
+            AppendLittleEndian(out, Checksum(out.data() + start, out.size() - start), sizeof(uint32_t));
+        }
+
+        // Целая запись с верной контрольной суммой, начинающаяся с какого-либо байта после from.
+        // После обрезанной при дозаписи записи в файле ничего нет, а после записи с испорченной
+        // длиной имени остаются следующие целые записи. Просматривается не больше
+        // MAX_RECORD_NAME_SIZE байт, поэтому поиск идет только при открытии файла с неполной записью
+        bool HasRecordAfter(const std::string& data, size_t from) {
+            for(size_t pos = from; data.size() - pos >= RECORD_HEADER_SIZE + RECORD_CHECKSUM_SIZE; ++pos) {
+                const char* header = data.data() + pos;
+                const size_t name_size = ReadLittleEndian(header + 2 * sizeof(uint64_t) + sizeof(int64_t), sizeof(uint32_t));
+                const size_t record_size = RECORD_HEADER_SIZE + name_size + RECORD_CHECKSUM_SIZE;
+
+                if(name_size <= MAX_RECORD_NAME_SIZE && data.size() - pos >= record_size
+                    && ReadLittleEndian(header + record_size - RECORD_CHECKSUM_SIZE, RECORD_CHECKSUM_SIZE)
+                        == Checksum(header, record_size - RECORD_CHECKSUM_SIZE)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool WriteAll(int fd, std::string_view data) {
+            while(!data.empty()) {
+                const ssize_t written = ::write(fd, data.data(), data.size());
+                if(written < 0) {
+                    if(errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data.remove_prefix(static_cast<size_t>(written));
+            }
+            return true;
+        }
+
+        // fsync файла или каталога (после создания файла в нем)
+        void SyncPath(const std::filesystem::path& path) {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0) {
+                throw std::runtime_error("Couldn't open "s + path.string() + " for fsync"s);
+            }
+
+            const int result = ::fsync(fd);
+            ::close(fd);
+
+            if(result != 0) {
+                throw std::runtime_error("fsync failed for "s + path.string());
+            }
+        }
+
+    } // namespace
+
+    void SortedRecords::Assign(std::vector<domain::PlayerRecord>&& sorted) {
+        blocks_.clear();
+        size_ = sorted.size();
+
+        for(size_t begin = 0; begin < sorted.size(); begin += RECORDS_BLOCK_SIZE) {
+            const size_t end = std::min(begin + RECORDS_BLOCK_SIZE, sorted.size());
+            blocks_.emplace_back(std::make_move_iterator(sorted.begin() + begin), std::make_move_iterator(sorted.begin() + end));
+        }
+    }
+
+    void SortedRecords::Insert(domain::PlayerRecord record) {
+        ++size_;
+
+        if(blocks_.empty()) {
+            blocks_.emplace_back().push_back(std::move(record));
+            return;
+        }
+
+        const auto block_pos = blocks_.begin() + (FindBlock(record) - blocks_.cbegin());
+        auto& block = *block_pos;
+        block.insert(std::upper_bound(block.begin(), block.end(), record, domain::IsRecordBefore), std::move(record));
+
+        if(block.size() > RECORDS_BLOCK_SIZE) {
+            const auto middle = block.begin() + static_cast<std::ptrdiff_t>(block.size() / 2);
+            Block upper{std::make_move_iterator(middle), std::make_move_iterator(block.end())};
+            block.erase(middle, block.end());
+            blocks_.insert(block_pos + 1, std::move(upper));
+        }
+    }
+
+    std::vector<domain::PlayerRecord> SortedRecords::Slice(size_t offset, size_t limit) const {
+        auto block = blocks_.cbegin();
+        while(block != blocks_.cend() && offset >= block->size()) {
+            offset -= block->size();
+            ++block;
+        }
+
+        return Collect(block, offset, 0, limit);
+    }
+
+    std::vector<domain::PlayerRecord> SortedRecords::SliceAfter(const domain::PlayerRecord& after
+                                                              , size_t offset, size_t limit) const {
+        if(blocks_.empty()) {
+            return {};
+        }
+
+        const auto block = FindBlock(after);
+        const auto first = std::upper_bound(block->begin(), block->end(), after, domain::IsRecordBefore);
+        return Collect(block, static_cast<size_t>(first - block->begin()), offset, limit);
+    }
+
+    std::vector<SortedRecords::Block>::const_iterator SortedRecords::FindBlock(const domain::PlayerRecord& record) const {
+        auto block = std::upper_bound(blocks_.cbegin(), blocks_.cend(), record
+                                    , [](const domain::PlayerRecord& lhs, const Block& rhs) {
+                                        return domain::IsRecordBefore(lhs, rhs.back());
+                                    });
+        return block == blocks_.cend() ? std::prev(block) : block;
+    }
+
+    // Пропускаем offset записей с позиции pos блока block и собираем не больше limit следующих
+    std::vector<domain::PlayerRecord> SortedRecords::Collect(std::vector<Block>::const_iterator block, size_t pos
+                                                           , size_t offset, size_t limit) const {
+        std::vector<domain::PlayerRecord> result;
+
+        for(; block != blocks_.cend() && result.size() < limit; ++block, pos = 0) {
+            const size_t available = block->size() - pos;
+            if(offset >= available) {
+                offset -= available;
+                continue;
+            }
+
+            const auto first = block->begin() + static_cast<std::ptrdiff_t>(pos + offset);
+            const size_t count = std::min(limit - result.size(), available - offset);
+            result.insert(result.end(), first, first + static_cast<std::ptrdiff_t>(count));
+            offset = 0;
+        }
+
+        return result;
+    }
+
+    PlayerRecordRepositoryImpl::PlayerRecordRepositoryImpl(std::filesystem::path log_path, ErrorHandler on_error)
+        : log_path_{std::move(log_path)}
+        , on_error_{std::move(on_error)} {
+        if(log_path_.empty()) {
+            return;
+        }
+
+        Load();
+
+        log_fd_ = ::open(log_path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if(log_fd_ < 0) {
+            throw std::runtime_error("Failed to open records log "s + log_path_.string());
+        }
+        log_size_ = std::filesystem::file_size(log_path_);
+    }
+
+    PlayerRecordRepositoryImpl::~PlayerRecordRepositoryImpl() {
+        if(log_fd_ >= 0) {
+            ::close(log_fd_);
+        }
+    }
+
+    // Весь файл читается одним куском, индекс сортируется один раз после чтения
+    void PlayerRecordRepositoryImpl::Load() {
+        std::string data;
+        {
+            std::ifstream in{log_path_, std::ios::binary};
+            if(in) {
+                data.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+            }
+        }
+
+        if(data.empty()) {
+            std::ofstream out{log_path_, std::ios::binary | std::ios::trunc};
+            out << RECORDS_LOG_MAGIC;
+            if(!out.flush()) {
+                throw std::runtime_error("Failed to create records log "s + log_path_.string());
+            }
+            out.close();
+            // Без записи каталога на диске новый файл со всеми будущими пачками может пропасть при сбое
+            SyncPath(log_path_);
+            SyncPath(log_path_.has_parent_path() ? log_path_.parent_path() : std::filesystem::path{"."});
+            return;
+        }
+
+        if(data.compare(0, RECORDS_LOG_MAGIC.size(), RECORDS_LOG_MAGIC) != 0) {
+            throw std::runtime_error("Unknown records log format "s + log_path_.string());
+        }
+
+        std::vector<domain::PlayerRecord> records;
+        size_t pos = RECORDS_LOG_MAGIC.size();
+        while(data.size() - pos >= RECORD_HEADER_SIZE) {
+            const char* header = data.data() + pos;
+            const uint64_t id = ReadLittleEndian(header, sizeof(uint64_t));
+            const size_t score = ReadLittleEndian(header + sizeof(uint64_t), sizeof(uint64_t));
+            const auto play_time = static_cast<int64_t>(ReadLittleEndian(header + 2 * sizeof(uint64_t), sizeof(int64_t)));
+            const size_t name_size = ReadLittleEndian(header + 2 * sizeof(uint64_t) + sizeof(int64_t), sizeof(uint32_t));
+            const size_t record_size = RECORD_HEADER_SIZE + name_size + RECORD_CHECKSUM_SIZE;
+
+            // Обрезанной может быть только последняя запись: ее длина не больше наибольшей, и за ее началом
+            // нет ни одной целой записи. Иначе длина имени испорчена, и отрезать хвост нельзя
+            const bool overruns = data.size() - pos < record_size;
+            if(overruns && name_size <= MAX_RECORD_NAME_SIZE && !HasRecordAfter(data, pos + 1)) {
+                break;
+            }
+
+            if(overruns || name_size > MAX_RECORD_NAME_SIZE
+                || ReadLittleEndian(header + record_size - RECORD_CHECKSUM_SIZE, RECORD_CHECKSUM_SIZE)
+                    != Checksum(header, record_size - RECORD_CHECKSUM_SIZE)) {
+                throw std::runtime_error("Corrupt record at offset "s + std::to_string(pos) + " of records log "s
+                                        + log_path_.string() + " ("s + std::to_string(data.size() - pos)
+                                        + " bytes from it are not read)"s);
+            }
+
+            if(ids_.insert(id).second) {
+                records.emplace_back(data.substr(pos + RECORD_HEADER_SIZE, name_size), score, play_time, id);
+                last_id_ = std::max(last_id_, id);
+            }
+            pos += record_size;
+        }
+
+        // Отрезаем недописанную запись, чтобы новые записи шли сразу за последней целой
+        if(pos != data.size()) {
+            std::filesystem::resize_file(log_path_, pos);
+            if(on_error_) {
+                on_error_("Dropped "s + std::to_string(data.size() - pos) + " bytes of a torn record at the end of records log "s
+                        + log_path_.string());
+            }
+        }
+
+        std::stable_sort(records.begin(), records.end(), domain::IsRecordBefore);
+        records_.Assign(std::move(records));
+    }
+
+    // Пачка дописывается в файл одной операцией записи и сбрасывается на диск (fdatasync), затем ее записи
+    // вставляются в блоки индекса. Вызывающий (например, write-behind, удаляющий после этого свой журнал)
+    // может считать пачку сохраненной, как только метод вернул управление
+    void PlayerRecordRepositoryImpl::SaveRecordsTable(const std::vector<domain::PlayerRecord>& player_records) {
+        if(player_records.empty()) {
+            return;
+        }
+
+        std::unique_lock lock{mutex_};
+        const auto new_records = SelectNewRecords(player_records);
+
+        if(new_records.empty()) {
+            return;
+        }
+
+        if(log_path_.empty()) {
+            AddRecords(new_records);
+            return;
+        }
+
+        std::string buffer;
+        for(const auto& record : new_records) {
+            AppendRecord(buffer, record);
+        }
+
+        if(!WriteAll(log_fd_, buffer) || ::fdatasync(log_fd_) != 0) {
+            // Отрезаем частично записанную пачку, иначе следующие записи нельзя будет прочитать
+            [[maybe_unused]] const int truncated = ::ftruncate(log_fd_, static_cast<off_t>(log_size_));
+            throw std::runtime_error("Failed to write records log "s + log_path_.string());
+        }
+        log_size_ += buffer.size();
+
+        AddRecords(new_records);
+    }
+
+    std::vector<domain::PlayerRecord> PlayerRecordRepositoryImpl::SelectNewRecords(
+                                                const std::vector<domain::PlayerRecord>& player_records) const {
+        std::vector<domain::PlayerRecord> new_records;
+        std::unordered_set<uint64_t> batch_ids;
+        new_records.reserve(player_records.size());
+
+        for(const auto& record : player_records) {
+            if(!ids_.contains(record.GetId()) && batch_ids.insert(record.GetId()).second) {
+                new_records.push_back(record);
+            }
+        }
+
+        return new_records;
+    }
+
+    void PlayerRecordRepositoryImpl::AddRecords(const std::vector<domain::PlayerRecord>& player_records) {
+        for(const auto& record : player_records) {
+            ids_.insert(record.GetId());
+            last_id_ = std::max(last_id_, record.GetId());
+            records_.Insert(record);
+        }
+    }
+
+    std::vector<domain::PlayerRecord> PlayerRecordRepositoryImpl::GetRecordsTable(size_t offset, size_t limit) {
+        std::shared_lock lock{mutex_};
+        return records_.Slice(offset, limit);
+    }
+
+    std::vector<domain::PlayerRecord> PlayerRecordRepositoryImpl::GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                                                    , size_t offset, size_t limit) {
+        std::shared_lock lock{mutex_};
+        return records_.SliceAfter(after, offset, limit);
+    }
+
+    void PlayerRecordRepositoryImpl::AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                                             , const boost::asio::any_io_executor& executor
+                                                             , domain::RecordsHandler handler) {
+        boost::asio::post(executor, [handler = std::move(handler), records = GetRecordsTableAfter(after, offset, limit)]() mutable {
+            handler(nullptr, std::move(records));
+        });
+    }
+
+    uint64_t PlayerRecordRepositoryImpl::GetLastRecordId() {
+        std::shared_lock lock{mutex_};
+        return last_id_;
+    }
+
+    size_t PlayerRecordRepositoryImpl::Size() const {
+        std::shared_lock lock{mutex_};
+        return records_.Size();
+    }
+
+}  // namespace embedded
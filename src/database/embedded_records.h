@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "player_record.h"
+#include "database_connection_settings.h"
+
+namespace embedded {
+
+    // Заголовок файла рекордов (формат и его версия)
+    const std::string RECORDS_LOG_MAGIC = "HOFLOG02";
+    // Наибольшая длина имени в записи файла. Длина больше - признак порчи файла, а не обрезанной записи
+    const uint32_t MAX_RECORD_NAME_SIZE = 4096;
+    // Наибольшее число записей в блоке индекса (переполненный блок делится пополам)
+    const size_t RECORDS_BLOCK_SIZE = 1024;
+
+    // Записи в порядке таблицы рекордов, разбитые на отсортированные блоки. Вставка сдвигает записи
+    // только внутри одного блока, поэтому пачка не переписывает всю таблицу, а поиск по смещению
+    // проходит по размерам блоков, не трогая сами записи
+    class SortedRecords {
+    public:
+        // Заменяет содержимое уже отсортированными записями
+        void Assign(std::vector<domain::PlayerRecord>&& sorted);
+        void Insert(domain::PlayerRecord record);
+
+        std::vector<domain::PlayerRecord> Slice(size_t offset, size_t limit) const;
+        // Записи, следующие в таблице за after, начиная с offset-й из них
+        std::vector<domain::PlayerRecord> SliceAfter(const domain::PlayerRecord& after, size_t offset, size_t limit) const;
+
+        size_t Size() const noexcept {
+            return size_;
+        }
+
+    private:
+        using Block = std::vector<domain::PlayerRecord>;
+
+        // Первый блок, последняя запись которого идет в таблице после record (или последний блок)
+        std::vector<Block>::const_iterator FindBlock(const domain::PlayerRecord& record) const;
+        std::vector<domain::PlayerRecord> Collect(std::vector<Block>::const_iterator block, size_t pos
+                                                , size_t offset, size_t limit) const;
+
+        std::vector<Block> blocks_;
+        size_t size_ = 0;
+    };
+
+    // Таблица рекордов без внешней БД: записи дописываются в конец файла, а в памяти хранится
+    // отсортированный в порядке таблицы индекс. Порядок тот же, что у запросов PostgreSQL
+    // (domain::IsRecordBefore), поэтому смещение и курсор работают одинаково в обоих хранилищах.
+    // Запись файла: id (u64) | score (u64) | play_time (i64) | длина имени (u32) | имя | CRC-32 записи (u32),
+    // числа little-endian. Обрезанная запись в конце файла (сбой во время дозаписи) отрезается при открытии,
+    // число отрезанных байт сообщается on_error. Запись считается обрезанной, только если за ее началом
+    // нет ни одной целой записи. Испорченная запись (неверная контрольная сумма или длина имени, в том
+    // числе уводящая за конец файла) останавливает открытие с ошибкой: файл не меняется, следующие записи не теряются.
+    // Записи с уже сохраненным номером пропускаются (повтор пачки после сбоя).
+    // SaveRecordsTable возвращается только после fdatasync пачки: после этого записи переживают сбой питания.
+    // С пустым путем таблица хранится только в памяти
+    class PlayerRecordRepositoryImpl : public domain::PlayerRecordRepository {
+    public:
+        using ErrorHandler = std::function<void(const std::string& message)>;
+
+        explicit PlayerRecordRepositoryImpl(std::filesystem::path log_path, ErrorHandler on_error = {});
+        ~PlayerRecordRepositoryImpl();
+
+        PlayerRecordRepositoryImpl(const PlayerRecordRepositoryImpl&) = delete;
+        PlayerRecordRepositoryImpl& operator=(const PlayerRecordRepositoryImpl&) = delete;
+
+        void SaveRecordsTable(const std::vector<domain::PlayerRecord>& player_records) override;
+        std::vector<domain::PlayerRecord> GetRecordsTable(size_t offset, size_t limit) override;
+        std::vector<domain::PlayerRecord> GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                            , size_t offset, size_t limit) override;
+        // Таблица в памяти процесса: ждать нечего, запрос выполняется сразу, а handler ставится в очередь executor
+        void AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                     , const boost::asio::any_io_executor& executor
+                                     , domain::RecordsHandler handler) override;
+        uint64_t GetLastRecordId() override;
+
+        size_t Size() const;
+
+    private:
+        void Load();
+        // Записи пачки, номеров которых еще нет в таблице (под блокировкой записи)
+        std::vector<domain::PlayerRecord> SelectNewRecords(const std::vector<domain::PlayerRecord>& player_records) const;
+        // Вставляет записи пачки в индекс (под блокировкой записи)
+        void AddRecords(const std::vector<domain::PlayerRecord>& player_records);
+
+        std::filesystem::path log_path_;
+        ErrorHandler on_error_;
+        // Файл открыт на дозапись (O_APPEND), -1 - таблица только в памяти
+        int log_fd_ = -1;
+        // Размер файла после последней успешной дозаписи
+        uintmax_t log_size_ = 0;
+
+        mutable std::shared_mutex mutex_;
+        SortedRecords records_;
+        std::unordered_set<uint64_t> ids_;
+        uint64_t last_id_ = 0;
+    };
+
+    class Database {
+    public:
+        explicit Database(const db_conn_settings::DbConnectrioSettings& db_settings
+                        , PlayerRecordRepositoryImpl::ErrorHandler on_error = {})
+            : player_records_{db_settings.records_storage == db_conn_settings::RecordsStorage::MEMORY
+                                ? std::filesystem::path{} : std::filesystem::path{db_settings.records_log}
+                            , std::move(on_error)} {
+        }
+
+        PlayerRecordRepositoryImpl& GetPlayerRecords() & {
+            return player_records_;
+        }
+
+    private:
+        PlayerRecordRepositoryImpl player_records_;
+    };
+
+}  // namespace embedded
@@ -0,0 +1,142 @@
+#include "leaderboard.h"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <optional>
+
+#include <boost/asio/post.hpp>
+
+namespace db_storage {
+
+    Leaderboard::Leaderboard(UseCases& storage, size_t capacity)
+        : storage_{storage}
+        , capacity_{std::max<size_t>(capacity, 1)} {
+    }
+
+    void Leaderboard::Warm() {
+        auto records = storage_.GetRecordsTable(0, capacity_);
+        std::sort(records.begin(), records.end(), domain::IsRecordBefore);
+
+        std::unique_lock lock{mutex_};
+        // Если БД вернула меньше записей, чем помещается в память, значит в памяти вся таблица
+        complete_ = records.size() < capacity_;
+        records_ = std::move(records);
+    }
+
+    // Вставляем записи на их места. Записи, вытесненные за пределы capacity_, остаются только в БД
+    void Leaderboard::Add(const std::vector<domain::PlayerRecord>& records) {
+        std::unique_lock lock{mutex_};
+
+        for(const auto& record : records) {
+            // Таблица заполнена, а запись хуже последней - в память она не попадает
+            if(records_.size() == capacity_ && !domain::IsRecordBefore(record, records_.back())) {
+                complete_ = false;
+                continue;
+            }
+
+            auto pos = std::upper_bound(records_.begin(), records_.end(), record, domain::IsRecordBefore);
+            records_.insert(pos, record);
+
+            if(records_.size() > capacity_) {
+                records_.pop_back();
+                complete_ = false;
+            }
+        }
+    }
+
+    // Записи с позиции offset: сначала из памяти, недостающие - из БД после последней записи в памяти
+    std::vector<domain::PlayerRecord> Leaderboard::GetRecords(size_t offset, size_t limit) const {
+        auto page = TakeFromMemory(offset, limit);
+
+        if(page.last) {
+            auto tail = storage_.GetRecordsTableAfter(*page.last, page.db_offset, limit - page.records.size());
+            page.records.insert(page.records.end(), std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+        }
+
+        return std::move(page.records);
+    }
+
+    std::vector<domain::PlayerRecord> Leaderboard::GetRecordsAfter(const domain::PlayerRecord& after, size_t limit) const {
+        auto page = TakeAfterFromMemory(after, limit);
+
+        if(page.last) {
+            auto tail = storage_.GetRecordsTableAfter(*page.last, 0, limit - page.records.size());
+            page.records.insert(page.records.end(), std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+        }
+
+        return std::move(page.records);
+    }
+
+    void Leaderboard::GetRecords(size_t offset, size_t limit
+                               , const boost::asio::any_io_executor& executor, domain::RecordsHandler handler) const {
+        auto page = TakeFromMemory(offset, limit);
+        CompleteFromStorage(std::move(page.records), page.last, page.db_offset, limit, executor, std::move(handler));
+    }
+
+    void Leaderboard::GetRecordsAfter(const domain::PlayerRecord& after, size_t limit
+                                    , const boost::asio::any_io_executor& executor, domain::RecordsHandler handler) const {
+        auto page = TakeAfterFromMemory(after, limit);
+        CompleteFromStorage(std::move(page.records), page.last, 0, limit, executor, std::move(handler));
+    }
+
+    Leaderboard::Page Leaderboard::TakeFromMemory(size_t offset, size_t limit) const {
+        Page page;
+        std::shared_lock lock{mutex_};
+
+        if(offset < records_.size()) {
+            const size_t end = offset + std::min(limit, records_.size() - offset);
+            page.records.assign(records_.begin() + offset, records_.begin() + end);
+        }
+
+        // Если в памяти не вся таблица, то она заполнена целиком и последняя запись есть
+        if(page.records.size() < limit && !complete_) {
+            page.last = records_.back();
+            page.db_offset = offset > records_.size() ? offset - records_.size() : 0;
+        }
+
+        return page;
+    }
+
+    // Курсор ищется в памяти двоичным поиском. Если записи в памяти закончились, продолжение
+    // запрашивается у БД после курсора или последней записи в памяти, смотря что дальше по таблице
+    Leaderboard::Page Leaderboard::TakeAfterFromMemory(const domain::PlayerRecord& after, size_t limit) const {
+        Page page;
+        std::shared_lock lock{mutex_};
+
+        auto first = std::upper_bound(records_.begin(), records_.end(), after, domain::IsRecordBefore);
+        const size_t available = static_cast<size_t>(records_.end() - first);
+        page.records.assign(first, first + std::min(limit, available));
+
+        if(page.records.size() < limit && !complete_) {
+            page.last = page.records.empty() ? after : records_.back();
+        }
+
+        return page;
+    }
+
+    void Leaderboard::CompleteFromStorage(std::vector<domain::PlayerRecord>&& result
+                                        , const std::optional<domain::PlayerRecord>& last, size_t db_offset, size_t limit
+                                        , const boost::asio::any_io_executor& executor, domain::RecordsHandler handler) const {
+        if(!last) {
+            boost::asio::post(executor, [handler = std::move(handler), result = std::move(result)]() mutable {
+                handler(nullptr, std::move(result));
+            });
+            return;
+        }
+
+        const size_t missing = limit - result.size();
+        storage_.AsyncGetRecordsTableAfter(*last, db_offset, missing, executor
+            , [handler = std::move(handler), result = std::move(result)](std::exception_ptr error
+                                                                        , std::vector<domain::PlayerRecord> tail) mutable {
+                result.insert(result.end(), std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+                handler(error, error ? std::vector<domain::PlayerRecord>{} : std::move(result));
+            });
+    }
+
+    size_t Leaderboard::Size() const {
+        std::shared_lock lock{mutex_};
+        return records_.size();
+    }
+
+} // namespace db_storage
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+#include <boost/asio/any_io_executor.hpp>
+
+#include "player_record.h"
+#include "use_cases.h"
+
+namespace db_storage {
+
+    // Число лучших записей, которые хранятся в памяти
+    const size_t DEFAULT_LEADERBOARD_SIZE = 10'000;
+
+    // Таблица лучших рекордов в памяти. Заполняется из БД при запуске и дополняется записями
+    // вышедших игроков, поэтому запросы к первым позициям таблицы обходятся без обращения к БД.
+    // Позиции дальше capacity запрашиваются у БД с продолжением после последней записи в памяти.
+    // В асинхронных перегрузках поток не ждет свободного соединения, результат передается обработчику,
+    // который всегда вызывается на executor. Синхронные перегрузки ждут ответа БД на вызывающем потоке
+    class Leaderboard {
+    public:
+        explicit Leaderboard(UseCases& storage, size_t capacity = DEFAULT_LEADERBOARD_SIZE);
+
+        Leaderboard(const Leaderboard&) = delete;
+        Leaderboard& operator=(const Leaderboard&) = delete;
+
+        // Загружаем лучшие записи из БД
+        void Warm();
+        void Add(const std::vector<domain::PlayerRecord>& records);
+        std::vector<domain::PlayerRecord> GetRecords(size_t offset, size_t limit) const;
+        std::vector<domain::PlayerRecord> GetRecordsAfter(const domain::PlayerRecord& after, size_t limit) const;
+        void GetRecords(size_t offset, size_t limit
+                      , const boost::asio::any_io_executor& executor, domain::RecordsHandler handler) const;
+        // Записи, следующие в таблице за after (курсор вместо смещения)
+        void GetRecordsAfter(const domain::PlayerRecord& after, size_t limit
+                           , const boost::asio::any_io_executor& executor, domain::RecordsHandler handler) const;
+
+        size_t Size() const;
+
+    private:
+        // Записи страницы, найденные в памяти, и место, с которого ее продолжение нужно взять из БД
+        struct Page {
+            std::vector<domain::PlayerRecord> records;
+            // Запись, после которой продолжается выборка в БД; пусто, если страница полная
+            std::optional<domain::PlayerRecord> last;
+            size_t db_offset = 0;
+        };
+
+        Page TakeFromMemory(size_t offset, size_t limit) const;
+        Page TakeAfterFromMemory(const domain::PlayerRecord& after, size_t limit) const;
+        // Дополняет записи из памяти записями БД после last (или сразу отдает их, если last нет)
+        void CompleteFromStorage(std::vector<domain::PlayerRecord>&& result, const std::optional<domain::PlayerRecord>& last
+                               , size_t db_offset, size_t limit
+                               , const boost::asio::any_io_executor& executor, domain::RecordsHandler handler) const;
+
+        UseCases& storage_;
+        size_t capacity_;
+
+        mutable std::shared_mutex mutex_;
+        // Записи в порядке таблицы рекордов (не больше capacity_)
+        std::vector<domain::PlayerRecord> records_;
+        // В памяти вся таблица: ни одна запись не вытеснена и в БД их не больше, чем в памяти
+        bool complete_ = true;
+    };
+
+} // namespace db_storage
@@ -1,16 +1,29 @@
 #pragma once
 
+#include <charconv>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <vector>
 
+#include <boost/asio/any_io_executor.hpp>
+
 namespace domain {
 
+    // Номер записи (id) присваивает приложение при выходе игрока. Он уникален в таблице рекордов
+    // и замыкает порядок записей, поэтому у записей с одинаковыми очками, временем и именем
+    // есть однозначное место в таблице
     class PlayerRecord {
     public:
-        PlayerRecord(std::string name, size_t score, int64_t play_time)
+        PlayerRecord(std::string name, size_t score, int64_t play_time, uint64_t id)
             : name_(std::move(name))
             , score_(score)
-            , play_time_(play_time) {
+            , play_time_(play_time)
+            , id_(id) {
 
         };
 
@@ -26,17 +39,69 @@ namespace domain {
             return play_time_;
         }
 
+        uint64_t GetId() const noexcept {
+            return id_;
+        }
+
     private:
         std::string name_{};
         size_t score_{0};
         int64_t play_time_{0};
+        uint64_t id_{0};
     };
 
 
+    // Порядок таблицы рекордов: по убыванию очков, затем по возрастанию времени игры, имени и номера.
+    // Имена сравниваются побайтно, как в PostgreSQL с COLLATE "C" (а не с правилами локали БД)
+    inline bool IsRecordBefore(const PlayerRecord& lhs, const PlayerRecord& rhs) noexcept {
+        using Key = std::tuple<size_t, int64_t, const std::string&, uint64_t>;
+        return Key{rhs.GetScore(), lhs.GetPlayTime(), lhs.GetName(), lhs.GetId()}
+             < Key{lhs.GetScore(), rhs.GetPlayTime(), rhs.GetName(), rhs.GetId()};
+    }
+
+    // Курсор таблицы рекордов - последняя полученная клиентом запись в виде "score,play_time,id,name".
+    // Имя идет последним и может содержать запятые
+    inline std::optional<PlayerRecord> ParseRecordCursor(std::string_view cursor) {
+        size_t score = 0;
+        int64_t play_time = 0;
+        uint64_t id = 0;
+        const char* end = cursor.data() + cursor.size();
+
+        auto [score_end, score_ec] = std::from_chars(cursor.data(), end, score);
+        if(score_ec != std::errc{} || score_end == end || *score_end != ',') {
+            return std::nullopt;
+        }
+
+        auto [time_end, time_ec] = std::from_chars(score_end + 1, end, play_time);
+        if(time_ec != std::errc{} || play_time < 0 || time_end == end || *time_end != ',') {
+            return std::nullopt;
+        }
+
+        auto [id_end, id_ec] = std::from_chars(time_end + 1, end, id);
+        if(id_ec != std::errc{} || id_end == end || *id_end != ',') {
+            return std::nullopt;
+        }
+
+        return PlayerRecord{std::string(id_end + 1, end), score, play_time, id};
+    }
+
+    // Обработчик асинхронного запроса записей: ошибка (пустая при успехе) и записи
+    using RecordsHandler = std::function<void(std::exception_ptr error, std::vector<PlayerRecord> records)>;
+
     class PlayerRecordRepository {
     public:
+        // Повторное сохранение той же записи (номер и содержимое) не добавляет ее второй раз.
+        // Номер, занятый другой записью, - ошибка db_ex::RecordIdConflict (PostgreSQL)
         virtual void SaveRecordsTable(const std::vector<domain::PlayerRecord>& player_records) = 0;
         virtual std::vector<PlayerRecord> GetRecordsTable(size_t offset, size_t limit) = 0;
+        // Записи, следующие в таблице рекордов за after (keyset-пагинация без просмотра предыдущих строк)
+        virtual std::vector<PlayerRecord> GetRecordsTableAfter(const PlayerRecord& after, size_t offset, size_t limit) = 0;
+        // То же без блокировки потока на ожидании соединения: handler вызывается на executor.
+        // Сам запрос к БД может выполняться на потоке executor и занимать его
+        virtual void AsyncGetRecordsTableAfter(const PlayerRecord& after, size_t offset, size_t limit
+                                             , const boost::asio::any_io_executor& executor, RecordsHandler handler) = 0;
+        // Наибольший номер сохраненной записи (0 - таблица пуста)
+        virtual uint64_t GetLastRecordId() = 0;
 
     protected:
         ~PlayerRecordRepository() = default;
@@ -1,65 +1,222 @@
 #include "postgres.h"
+#include "database_exceptions.h"
 
 #include <string>
 #include <pqxx/zview.hxx>
 #include <pqxx/pqxx>
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
+#include <system_error>
 
 namespace postgres {
 
 using namespace std::literals;
 using pqxx::operator"" _zv;
 
+namespace {
+
+    // Имена подготовленных запросов, зарегистрированных на каждом соединении пула
+    const auto RECORDS_PAGE = "records_page"_zv;
+    const auto RECORDS_AFTER = "records_after"_zv;
+    const auto RECORDS_INSERT = "records_insert"_zv;
+    const auto RECORDS_LAST_ID = "records_last_id"_zv;
+
+    // Таблица создается до открытия пула: запросы подготавливаются на каждом новом соединении
+    // (в том числе при переподключении), а PostgreSQL проверяет таблицу уже при подготовке
+    std::string CreateRecordsTableAt(const std::string& db_url) {
+        pqxx::connection conn{db_url};
+        pqxx::work work_{conn};
+        CreateRecordsTable(work_);
+        // коммитим изменения
+        work_.commit();
+        return db_url;
+    }
+
+    // Строки после записи after. Условие из одних OR планировщик не превращает в границу просмотра
+    // индекса, поэтому к нему добавлено избыточное score <= $1: оно попадает в Index Cond и просмотр
+    // начинается с очков курсора, а не с начала таблицы (как при OFFSET)
+    std::vector<domain::PlayerRecord> SelectRecordsAfter(pqxx::connection& conn, const domain::PlayerRecord& after
+                                                       , size_t offset, size_t limit) {
+        std::vector<domain::PlayerRecord> records_table;
+        pqxx::read_transaction read_transaction_{conn};
+        auto result = read_transaction_.exec_prepared(RECORDS_AFTER, after.GetScore(), after.GetPlayTime()
+                                                    , after.GetName(), after.GetId(), limit, offset);
+
+        records_table.reserve(result.size());
+        for (const auto& row : result) {
+            records_table.emplace_back(row[1].as<std::string>(), row[2].as<size_t>(), row[3].as<int64_t>(), row[0].as<uint64_t>());
+        }
+        return records_table;
+    }
+
+} // namespace
+
+// Записи передаются потоком COPY (одна команда на пачку вместо INSERT на каждую запись).
+// Большие пачки (массовый выход игроков) разбиваются на части, каждая в своей транзакции,
+// чтобы не держать одну огромную транзакцию. COPY не умеет пропускать существующие строки,
+// поэтому пачка сначала копируется во временную таблицу соединения, а из нее переносится
+// в таблицу рекордов без записей, уже сохраненных с тем же содержимым (повтор пачки после сбоя).
+// Номер, занятый другой записью, - ошибка RecordIdConflict: пачка не сохраняется и остается в журнале
 void PlayerRecordRepositoryImpl::SaveRecordsTable(const std::vector<domain::PlayerRecord>& player_records) {
-    auto conn = connection_pool_.GetConnection();
-    pqxx::work work_{*conn};
-    for(const auto& player_record : player_records) {
-        work_.exec_params(R"(
-            INSERT INTO player_hall_of_fame (name, score, play_time) VALUES ($1, $2, $3);
-            )"_zv,
-            player_record.GetName(),
-            player_record.GetScore(),
-            player_record.GetPlayTime()
-        );
+    if(player_records.empty()) {
+        return;
+    }
+
+    auto conn = connection_pool_.GetConnection(acquire_timeout_);
+
+    for(size_t begin = 0; begin < player_records.size(); begin += RECORDS_INSERT_CHUNK_SIZE) {
+        const size_t end = std::min(begin + RECORDS_INSERT_CHUNK_SIZE, player_records.size());
+        pqxx::work work_{*conn};
+        auto stream = pqxx::stream_to::table(work_, {"hall_of_fame_incoming"sv}
+                                            , {"id"sv, "name"sv, "score"sv, "play_time"sv});
+
+        for(size_t i = begin; i < end; ++i) {
+            const auto& player_record = player_records[i];
+            stream.write_values(player_record.GetId(), player_record.GetName()
+                              , player_record.GetScore(), player_record.GetPlayTime());
+        }
+
+        stream.complete();
+        try {
+            work_.exec_prepared0(RECORDS_INSERT);
+        } catch (const pqxx::unique_violation& ex) {
+            throw db_ex::RecordIdConflict{ex.what()};
+        }
+        work_.commit();
     }
-    work_.commit();
 };
 
 
 std::vector<domain::PlayerRecord> PlayerRecordRepositoryImpl::GetRecordsTable(size_t offset, size_t limit) {
-    auto conn = connection_pool_.GetConnection();
+    auto conn = connection_pool_.GetConnection(acquire_timeout_);
     std::vector<domain::PlayerRecord> records_table;
     pqxx::read_transaction read_transaction_{*conn};
-    auto query_text = "SELECT name, score, play_time FROM player_hall_of_fame ORDER BY score DESC, play_time ASC, name ASC LIMIT "
-        + std::to_string(limit) + " OFFSET " + std::to_string(offset) + ";";
-    for (auto [name, score, play_time] : read_transaction_.query<std::string, size_t, int64_t>(query_text)) {
-        records_table.emplace_back(name, score, play_time);
+    auto result = read_transaction_.exec_prepared(RECORDS_PAGE, limit, offset);
+
+    records_table.reserve(result.size());
+    for (const auto& row : result) {
+        records_table.emplace_back(row[1].as<std::string>(), row[2].as<size_t>(), row[3].as<int64_t>(), row[0].as<uint64_t>());
     }
     return records_table;
 };
 
+std::vector<domain::PlayerRecord> PlayerRecordRepositoryImpl::GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                                                , size_t offset, size_t limit) {
+    auto conn = connection_pool_.GetConnection(acquire_timeout_);
+    return SelectRecordsAfter(*conn, after, offset, limit);
+};
+
+// Поток executor не блокируется, пока все соединения заняты: обработчик получит соединение
+// из очереди пула. Сам запрос синхронный и занимает поток executor на время обращения к БД,
+// поэтому executor - отдельные потоки запросов (Application::db_queries_), а не io_context игры
+void PlayerRecordRepositoryImpl::AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                                         , const boost::asio::any_io_executor& executor
+                                                         , domain::RecordsHandler handler) {
+    connection_pool_.AsyncGetConnection(executor, acquire_timeout_
+        , [after, offset, limit, handler = std::move(handler)](std::error_code ec, db::ConnectionPool::ConnectionWrapper conn) {
+            std::vector<domain::PlayerRecord> records_table;
+            std::exception_ptr error;
+
+            if (ec == std::errc::timed_out) {
+                error = std::make_exception_ptr(db_ex::ConnectionTimeout{});
+            } else if (ec) {
+                error = std::make_exception_ptr(std::system_error{ec});
+            } else {
+                try {
+                    // Соединение возвращается в пул до вызова обработчика
+                    const auto held = std::move(conn);
+                    records_table = SelectRecordsAfter(*held, after, offset, limit);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            handler(error, std::move(records_table));
+        }
+    );
+};
+
+uint64_t PlayerRecordRepositoryImpl::GetLastRecordId() {
+    auto conn = connection_pool_.GetConnection(acquire_timeout_);
+    pqxx::read_transaction read_transaction_{*conn};
+    return read_transaction_.exec_prepared1(RECORDS_LAST_ID)[0].as<uint64_t>();
+};
+
 Database::Database(const db_conn_settings::DbConnectrioSettings& db_settings)
     : connection_pool_{
         db_settings.number_of_connection,
-        [db_url = std::move(db_settings.db_url)]() {
-            return std::make_shared<pqxx::connection>(db_url);
+        [db_url = CreateRecordsTableAt(db_settings.db_url)]() {
+            auto conn = std::make_shared<pqxx::connection>(db_url);
+            PrepareRecordsStatements(*conn);
+            return conn;
         }
-    } {
-    auto conn = connection_pool_.GetConnection();
-    pqxx::work work_{*conn};
-    work_.exec(R"(
+    }
+    , player_records_{connection_pool_, db_settings.acquire_timeout} {
+}
+
+void CreateRecordsTable(pqxx::work& work) {
+    work.exec(R"(
 CREATE TABLE IF NOT EXISTS player_hall_of_fame (
-    id SERIAL PRIMARY KEY,
+    id BIGINT PRIMARY KEY,
     name varchar(40) NOT NULL,
     score integer CONSTRAINT score_positive CHECK (score >= 0),
     play_time integer NOT NULL CONSTRAINT play_time_positive CHECK (play_time >= 0)     
 );
-CREATE INDEX IF NOT EXISTS hall_of_fame_score ON player_hall_of_fame (score); 
+-- Номера выдает приложение (uint64_t), прежний столбец SERIAL был int4
+DO $$
+BEGIN
+    IF (SELECT data_type FROM information_schema.columns
+        WHERE table_name = 'player_hall_of_fame' AND column_name = 'id') <> 'bigint' THEN
+        ALTER TABLE player_hall_of_fame ALTER COLUMN id DROP DEFAULT, ALTER COLUMN id TYPE BIGINT;
+    END IF;
+END $$;
+DROP INDEX IF EXISTS hall_of_fame_score;
+DROP INDEX IF EXISTS hall_of_fame_order;
+CREATE INDEX IF NOT EXISTS hall_of_fame_keyset
+    ON player_hall_of_fame (score DESC, play_time ASC, name COLLATE "C" ASC, id ASC);
+)"_zv);
+}
+
+// Составной индекс hall_of_fame_keyset совпадает с ORDER BY, поэтому оба запроса читают
+// строки из индекса уже упорядоченными, а records_after сразу переходит к строкам после курсора.
+// Имена сравниваются с COLLATE "C" (побайтно, как domain::IsRecordBefore): с правилами локали БД
+// порядок в памяти и в БД расходится и на границе между ними строки пропускаются или повторяются
+void PrepareRecordsStatements(pqxx::connection& conn) {
+    {
+        // Временная таблица живет до закрытия соединения, строки из нее удаляются при фиксации
+        pqxx::nontransaction work_{conn};
+        work_.exec(R"(
+CREATE TEMP TABLE IF NOT EXISTS hall_of_fame_incoming
+    (LIKE player_hall_of_fame) ON COMMIT DELETE ROWS;
+)"_zv);
+    }
+    conn.prepare(RECORDS_PAGE, R"(
+SELECT id, name, score, play_time FROM player_hall_of_fame
+ORDER BY score DESC, play_time ASC, name COLLATE "C" ASC, id ASC
+LIMIT $1 OFFSET $2;
+)"_zv);
+    conn.prepare(RECORDS_AFTER, R"(
+SELECT id, name, score, play_time FROM player_hall_of_fame
+WHERE score <= $1
+    AND (score < $1 OR (score = $1 AND (play_time > $2 OR (play_time = $2
+        AND (name COLLATE "C" > $3 OR (name COLLATE "C" = $3 AND id > $4))))))
+ORDER BY score DESC, play_time ASC, name COLLATE "C" ASC, id ASC
+LIMIT $5 OFFSET $6;
+)"_zv);
+    // Без ON CONFLICT: строка с тем же номером и другим содержимым (в том числе вставленная
+    // параллельно другим экземпляром) нарушает первичный ключ, а не пропускается молча
+    conn.prepare(RECORDS_INSERT, R"(
+INSERT INTO player_hall_of_fame (id, name, score, play_time)
+SELECT i.id, i.name, i.score, i.play_time FROM hall_of_fame_incoming AS i
+WHERE NOT EXISTS (
+    SELECT 1 FROM player_hall_of_fame AS t
+    WHERE t.id = i.id AND t.name = i.name AND t.score = i.score AND t.play_time = i.play_time);
+)"_zv);
+    conn.prepare(RECORDS_LAST_ID, R"(
+SELECT COALESCE(MAX(id), 0) FROM player_hall_of_fame;
 )"_zv);
-    // коммитим изменения
-    work_.commit();
 }
 
 }  // namespace postgres
\ No newline at end of file
@@ -6,19 +6,41 @@
 #include <pqxx/connection>
 #include <pqxx/transaction>
 
+#include <chrono>
+
 namespace postgres {
 
+    // Наибольшее число записей, передаваемых в одной транзакции при сохранении рекордов
+    const size_t RECORDS_INSERT_CHUNK_SIZE = 10'000;
+
+    // Создаем таблицу рекордов и ее индексы, если их еще нет
+    void CreateRecordsTable(pqxx::work& work);
+    // Регистрируем на соединении подготовленные запросы к таблице рекордов.
+    // Таблица должна уже существовать: PostgreSQL разбирает запрос при подготовке
+    void PrepareRecordsStatements(pqxx::connection& conn);
+
     class PlayerRecordRepositoryImpl : public domain::PlayerRecordRepository {
     public:
-        explicit PlayerRecordRepositoryImpl(db::ConnectionPool& connection_pool)
-            : connection_pool_(connection_pool) {
+        explicit PlayerRecordRepositoryImpl(db::ConnectionPool& connection_pool
+                                          , std::chrono::milliseconds acquire_timeout = db::DEFAULT_ACQUIRE_TIMEOUT)
+            : connection_pool_(connection_pool)
+            , acquire_timeout_(acquire_timeout) {
         };
 
         void SaveRecordsTable(const std::vector<domain::PlayerRecord>& player_records) override;
         std::vector<domain::PlayerRecord> GetRecordsTable(size_t offset, size_t limit) override;
+        std::vector<domain::PlayerRecord> GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                            , size_t offset, size_t limit) override;
+        // Соединение ожидается асинхронно (db::ConnectionPool::AsyncGetConnection), запрос выполняется
+        // на потоке executor после получения соединения
+        void AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                     , const boost::asio::any_io_executor& executor
+                                     , domain::RecordsHandler handler) override;
+        uint64_t GetLastRecordId() override;
 
     private:
         db::ConnectionPool& connection_pool_;
+        std::chrono::milliseconds acquire_timeout_;
     };
 
     class Database {
@@ -31,6 +53,6 @@ namespace postgres {
 
     private:
         db::ConnectionPool connection_pool_;
-        PlayerRecordRepositoryImpl player_records_{connection_pool_};
+        PlayerRecordRepositoryImpl player_records_;
     };
 }  // namespace postgres
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include "records_write_behind.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string_view>
+
+namespace db_storage {
+
+    using namespace std::literals;
+
+    namespace {
+
+        // Запись журнала: "<id> <score> <play_time> <длина имени> <имя>\n". Длина позволяет хранить любые имена
+        void WriteJournalRecord(std::ostream& out, const domain::PlayerRecord& record) {
+            out << record.GetId() << ' ' << record.GetScore() << ' ' << record.GetPlayTime() << ' '
+                << record.GetName().size() << ' ' << record.GetName() << '\n';
+        }
+
+        std::vector<domain::PlayerRecord> ReadJournal(const std::filesystem::path& path) {
+            std::vector<domain::PlayerRecord> records;
+            std::ifstream in{path, std::ios::binary};
+            uint64_t id = 0;
+            size_t score = 0;
+            int64_t play_time = 0;
+            size_t name_size = 0;
+
+            while(in >> id >> score >> play_time >> name_size) {
+                std::string name(name_size, '\0');
+                in.get();
+
+                // Обрезанная запись в конце журнала (сбой во время дозаписи) пропускается
+                if(!in.read(name.data(), static_cast<std::streamsize>(name_size))) {
+                    break;
+                }
+
+                records.emplace_back(std::move(name), score, play_time, id);
+            }
+
+            return records;
+        }
+
+        std::filesystem::path ReplayingPath(const std::filesystem::path& journal) {
+            auto path = journal;
+            path += ".replaying";
+            return path;
+        }
+
+        std::filesystem::path ProgressPath(const std::filesystem::path& journal) {
+            auto path = journal;
+            path += ".replaying.done";
+            return path;
+        }
+
+        std::filesystem::path DirectoryOf(const std::filesystem::path& path) {
+            return path.has_parent_path() ? path.parent_path() : std::filesystem::path{"."};
+        }
+
+        // fsync файла или каталога (после создания, переименования или удаления файла в нем)
+        bool SyncPath(const std::filesystem::path& path) {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0) {
+                return false;
+            }
+
+            const int result = ::fsync(fd);
+            ::close(fd);
+            return result == 0;
+        }
+
+        bool WriteAll(int fd, std::string_view data) {
+            while(!data.empty()) {
+                const ssize_t written = ::write(fd, data.data(), data.size());
+                if(written < 0) {
+                    if(errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data.remove_prefix(static_cast<size_t>(written));
+            }
+            return true;
+        }
+
+        // Дописывает data в файл и дожидается записи на диск вместе с записью каталога
+        bool AppendDurably(const std::filesystem::path& path, std::string_view data) {
+            const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if(fd < 0) {
+                return false;
+            }
+
+            const bool written = WriteAll(fd, data) && ::fsync(fd) == 0;
+            ::close(fd);
+            return written && SyncPath(DirectoryOf(path));
+        }
+
+        // Заменяет файл целиком: запись во временный файл, fsync и переименование
+        bool ReplaceDurably(const std::filesystem::path& path, std::string_view data) {
+            auto temp = path;
+            temp += ".tmp";
+            const int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if(fd < 0) {
+                return false;
+            }
+
+            const bool written = WriteAll(fd, data) && ::fsync(fd) == 0;
+            ::close(fd);
+
+            std::error_code ec;
+            if(written) {
+                std::filesystem::rename(temp, path, ec);
+            }
+            return written && !ec && SyncPath(DirectoryOf(path));
+        }
+
+        // Число уже сохраненных в БД записей файла .replaying
+        size_t ReadProgress(const std::filesystem::path& path) {
+            std::ifstream in{path};
+            size_t saved = 0;
+            return in >> saved ? saved : 0;
+        }
+
+    } // namespace
+
+    RecordsWriteBehind::RecordsWriteBehind(UseCases& use_cases, WriteBehindSettings settings, ErrorHandler on_error)
+        : use_cases_{use_cases}
+        , settings_{std::move(settings)}
+        , on_error_{std::move(on_error)} {
+        settings_.batch_size = std::max<size_t>(settings_.batch_size, 1);
+        journal_has_records_ = !settings_.journal_path.empty() && std::filesystem::exists(settings_.journal_path);
+        replay_pending_ = !settings_.journal_path.empty() && std::filesystem::exists(ReplayingPath(settings_.journal_path));
+        // Дописываем то, что не успело попасть в БД при прошлом запуске, до начала работы:
+        // после этого БД содержит все известные рекорды и по ней можно строить таблицу лидеров
+        ReplayJournal();
+        worker_ = std::thread{[this] { Run(); }};
+    }
+
+    RecordsWriteBehind::~RecordsWriteBehind() {
+        Stop();
+    }
+
+    // Ставим записи в очередь. Если очередь переполнена (БД долго недоступна), остаток передается потоку
+    // записи для сброса в журнал: fsync журнала не должен задерживать тик
+    void RecordsWriteBehind::Enqueue(std::vector<domain::PlayerRecord>&& records) {
+        if(records.empty()) {
+            return;
+        }
+
+        bool wake_worker = false;
+        {
+            std::lock_guard lock{mutex_};
+            // После остановки потока записи очередь уже никто не разберет
+            const size_t free_space = !stopping_ && settings_.queue_capacity > queue_.size()
+                                    ? settings_.queue_capacity - queue_.size() : 0;
+            const size_t accepted = std::min(free_space, records.size());
+
+            queue_.insert(queue_.end(), std::make_move_iterator(records.begin())
+                                    , std::make_move_iterator(records.begin() + accepted));
+            overflow_.insert(overflow_.end(), std::make_move_iterator(records.begin() + accepted)
+                                            , std::make_move_iterator(records.end()));
+            wake_worker = queue_.size() >= settings_.batch_size || !overflow_.empty();
+        }
+
+        if(wake_worker) {
+            cond_var_.notify_one();
+        }
+    }
+
+    // Останавливаем поток записи. Перед выходом он сохраняет очередь (без повторных попыток)
+    void RecordsWriteBehind::Stop() {
+        {
+            std::lock_guard lock{mutex_};
+            stopping_ = true;
+        }
+
+        cond_var_.notify_all();
+
+        if(worker_.joinable()) {
+            worker_.join();
+        }
+
+        // Переполнение, пришедшее после выхода потока записи
+        std::vector<domain::PlayerRecord> overflow;
+        {
+            std::lock_guard lock{mutex_};
+            overflow.swap(overflow_);
+        }
+        if(!overflow.empty()) {
+            SpillToJournal(overflow);
+        }
+    }
+
+    // Номера записей журнала еще нет в БД, но они уже заняты: новые номера выдаются после них
+    uint64_t RecordsWriteBehind::GetLastJournalId() {
+        if(settings_.journal_path.empty()) {
+            return 0;
+        }
+
+        std::lock_guard lock{journal_mutex_};
+        uint64_t last_id = 0;
+
+        for(const auto& path : {settings_.journal_path, ReplayingPath(settings_.journal_path)}) {
+            for(const auto& record : ReadJournal(path)) {
+                last_id = std::max(last_id, record.GetId());
+            }
+        }
+
+        return last_id;
+    }
+
+    size_t RecordsWriteBehind::PendingCount() const {
+        std::lock_guard lock{mutex_};
+        return queue_.size();
+    }
+
+    void RecordsWriteBehind::Run() {
+        std::unique_lock lock{mutex_};
+
+        while(true) {
+            cond_var_.wait_for(lock, settings_.flush_interval, [this] {
+                return stopping_ || !overflow_.empty() || queue_.size() >= settings_.batch_size;
+            });
+
+            if(!overflow_.empty()) {
+                std::vector<domain::PlayerRecord> overflow;
+                overflow.swap(overflow_);
+                lock.unlock();
+                SpillToJournal(overflow);
+                lock.lock();
+                continue;
+            }
+
+            if(queue_.empty()) {
+                if(stopping_) {
+                    break;
+                }
+
+                continue;
+            }
+
+            const size_t batch_size = std::min(settings_.batch_size, queue_.size());
+            std::vector<domain::PlayerRecord> batch{std::make_move_iterator(queue_.begin())
+                                                , std::make_move_iterator(queue_.begin() + batch_size)};
+            queue_.erase(queue_.begin(), queue_.begin() + batch_size);
+            lock.unlock();
+
+            if(TrySave(batch)) {
+                // БД снова доступна - дописываем журнал
+                ReplayJournal();
+            } else {
+                SpillToJournal(batch);
+            }
+
+            lock.lock();
+        }
+    }
+
+    // Сохраняем пачку, при ошибке повторяем с увеличивающейся задержкой. При остановке - одна попытка
+    bool RecordsWriteBehind::TrySave(const std::vector<domain::PlayerRecord>& batch) {
+        auto delay = settings_.retry_delay;
+
+        for(size_t attempt = 0; ; ++attempt) {
+            try {
+                use_cases_.AddPlayerRecords(batch);
+                return true;
+            } catch(const std::exception& ex) {
+                ReportError("Failed to save player records: "s + ex.what());
+            }
+
+            std::unique_lock lock{mutex_};
+
+            if(stopping_ || attempt >= settings_.max_retries) {
+                return false;
+            }
+
+            if(cond_var_.wait_for(lock, delay, [this] { return stopping_; })) {
+                return false;
+            }
+
+            delay *= 2;
+        }
+    }
+
+    // Дописываем записи в журнал. Без журнала записи теряются - сообщаем об этом
+    void RecordsWriteBehind::SpillToJournal(const std::vector<domain::PlayerRecord>& records) {
+        if(settings_.journal_path.empty()) {
+            ReportError("Player records are lost: "s + std::to_string(records.size()) + " record(s)"s);
+            return;
+        }
+
+        std::ostringstream out;
+        for(const auto& record : records) {
+            WriteJournalRecord(out, record);
+        }
+
+        std::lock_guard lock{journal_mutex_};
+        // Запись считается сохраненной только после fsync файла и каталога
+        if(!AppendDurably(settings_.journal_path, out.view())) {
+            ReportError("Failed to write player records journal "s + settings_.journal_path.string());
+            return;
+        }
+
+        journal_has_records_ = true;
+    }
+
+    // Переносим записи журнала в БД. Сначала дописывается оставшийся файл .replaying, затем журнал
+    // переименовывается в .replaying и дописывается он; новые сбросы идут в новый файл журнала
+    void RecordsWriteBehind::ReplayJournal() {
+        if(settings_.journal_path.empty()) {
+            return;
+        }
+
+        const auto replaying = ReplayingPath(settings_.journal_path);
+        while(true) {
+            {
+                std::lock_guard lock{journal_mutex_};
+
+                if(!replay_pending_) {
+                    if(!journal_has_records_) {
+                        return;
+                    }
+
+                    // Прогресс относится к прежнему файлу .replaying - убираем его до появления нового
+                    std::error_code ec;
+                    std::filesystem::remove(ProgressPath(settings_.journal_path), ec);
+                    std::filesystem::rename(settings_.journal_path, replaying, ec);
+                    if(ec) {
+                        ReportError("Failed to take player records journal for replay: "s + ec.message());
+                        return;
+                    }
+                    SyncPath(DirectoryOf(replaying));
+                    journal_has_records_ = false;
+                    replay_pending_ = true;
+                }
+            }
+
+            if(!ReplayFile(replaying)) {
+                return;
+            }
+        }
+    }
+
+    // Сохраняем пачками записи файла .replaying, начиная с первой несохраненной. Файл удаляется
+    // только после сохранения всех пачек, при ошибке остается до следующей попытки
+    bool RecordsWriteBehind::ReplayFile(const std::filesystem::path& replaying) {
+        const auto progress = ProgressPath(settings_.journal_path);
+        const auto records = ReadJournal(replaying);
+
+        for(size_t begin = std::min(ReadProgress(progress), records.size()); begin < records.size()
+                                                                            ; begin += settings_.batch_size) {
+            const size_t end = std::min(begin + settings_.batch_size, records.size());
+            std::vector<domain::PlayerRecord> batch{records.begin() + begin, records.begin() + end};
+
+            try {
+                use_cases_.AddPlayerRecords(batch);
+            } catch(const std::exception& ex) {
+                ReportError("Failed to replay player records journal: "s + ex.what());
+                return false;
+            }
+
+            if(end < records.size() && !ReplaceDurably(progress, std::to_string(end))) {
+                // Без отметки прогресса сохраненные пачки после сбоя будут записаны повторно
+                ReportError("Failed to write player records replay progress "s + progress.string());
+            }
+        }
+
+        std::lock_guard lock{journal_mutex_};
+        std::error_code ec;
+        // Сначала удаляется сам файл: прогресс без файла безвреден, а наоборот - нет
+        std::filesystem::remove(replaying, ec);
+        SyncPath(DirectoryOf(replaying));
+        std::filesystem::remove(progress, ec);
+        replay_pending_ = false;
+        return true;
+    }
+
+    void RecordsWriteBehind::ReportError(const std::string& message) const {
+        if(on_error_) {
+            on_error_(message);
+        }
+    }
+
+} // namespace db_storage
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "player_record.h"
+#include "use_cases.h"
+
+namespace db_storage {
+
+    struct WriteBehindSettings {
+        // Наибольшее число записей в очереди. Сверх него записи передаются потоку записи для журнала
+        size_t queue_capacity = 100'000;
+        // Наибольшее число записей, сохраняемых за одно обращение к БД
+        size_t batch_size = 1'000;
+        // Наибольшая задержка записи в БД неполной пачки
+        std::chrono::milliseconds flush_interval{200};
+        // Число повторных попыток сохранения пачки и задержка перед первой из них (далее удваивается)
+        size_t max_retries = 3;
+        std::chrono::milliseconds retry_delay{100};
+        // Журнал для записей, которые не удалось сохранить в БД. Пустой путь - журнал не ведется
+        std::filesystem::path journal_path{};
+    };
+
+    // Отложенная запись рекордов игроков. Тик только ставит записи в очередь, сохранением в БД
+    // пачками занимается отдельный поток, поэтому задержки БД не влияют на длительность тика.
+    // Если БД недоступна, записи после нескольких попыток сбрасываются в журнал (с fsync) и дописываются
+    // в БД после первого успешного сохранения (в том числе при следующем запуске сервера).
+    // Перед дописыванием журнал переименовывается в <журнал>.replaying и удаляется только после
+    // сохранения всех его пачек; число сохраненных записей хранится в <журнал>.replaying.done.
+    // Сбой во время дописывания не теряет записей, повторно может быть отправлена не больше чем одна пачка
+    // (хранилище пропускает записи с уже сохраненными номерами)
+    class RecordsWriteBehind {
+    public:
+        using ErrorHandler = std::function<void(const std::string& message)>;
+
+        RecordsWriteBehind(UseCases& use_cases, WriteBehindSettings settings, ErrorHandler on_error = {});
+
+        RecordsWriteBehind(const RecordsWriteBehind&) = delete;
+        RecordsWriteBehind& operator=(const RecordsWriteBehind&) = delete;
+
+        ~RecordsWriteBehind();
+
+        // Ставим записи в очередь, не дожидаясь БД. Ввода-вывода здесь нет: переполнение очереди
+        // тоже уходит в журнал из потока записи
+        void Enqueue(std::vector<domain::PlayerRecord>&& records);
+        // Сохраняем (или сбрасываем в журнал) все накопленные записи и останавливаем поток записи.
+        // Записи, поставленные после остановки, сбрасываются в журнал при следующем вызове (в деструкторе)
+        void Stop();
+
+        // Наибольший номер записи в журнале (0 - журнал пуст)
+        uint64_t GetLastJournalId();
+        size_t PendingCount() const;
+
+    private:
+        void Run();
+        bool TrySave(const std::vector<domain::PlayerRecord>& batch);
+        void SpillToJournal(const std::vector<domain::PlayerRecord>& records);
+        void ReplayJournal();
+        bool ReplayFile(const std::filesystem::path& replaying);
+        void ReportError(const std::string& message) const;
+
+    private:
+        UseCases& use_cases_;
+        WriteBehindSettings settings_;
+        ErrorHandler on_error_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable cond_var_;
+        std::deque<domain::PlayerRecord> queue_;
+        // Записи сверх queue_capacity, ждущие сброса в журнал потоком записи
+        std::vector<domain::PlayerRecord> overflow_;
+        bool stopping_ = false;
+
+        // Журнал пишет поток записи, а после его остановки - Stop
+        std::mutex journal_mutex_;
+        bool journal_has_records_ = false;
+        // Есть недописанный файл .replaying (прошлый запуск или неудачная попытка)
+        bool replay_pending_ = false;
+
+        std::thread worker_;
+    };
+
+} // namespace db_storage
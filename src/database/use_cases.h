@@ -10,6 +10,12 @@ namespace db_storage {
     public:
         virtual void AddPlayerRecords(const std::vector<domain::PlayerRecord>& player_records) = 0;
         virtual std::vector<domain::PlayerRecord> GetRecordsTable(size_t offset, size_t limit) = 0;
+        virtual std::vector<domain::PlayerRecord> GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                                    , size_t offset, size_t limit) = 0;
+        virtual void AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                             , const boost::asio::any_io_executor& executor
+                                             , domain::RecordsHandler handler) = 0;
+        virtual uint64_t GetLastRecordId() = 0;
 
     protected:
         ~UseCases() = default;
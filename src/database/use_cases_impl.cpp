@@ -5,13 +5,38 @@
 #include <sstream>
 #include <optional>
 
+#include "../metrics/metrics.h"
+
 namespace db_storage {
 
     void UseCasesImpl::AddPlayerRecords(const std::vector<domain::PlayerRecord>& player_records) {
-        player_records_.SaveRecordsTable(player_records);
+        auto& server_metrics = metrics::GetServerMetrics();
+        metrics::ScopedTimer flush_timer{server_metrics.records_flush_duration};
+        try {
+            player_records_.SaveRecordsTable(player_records);
+        } catch(...) {
+            server_metrics.records_flush_failures.Add();
+            throw;
+        }
+        server_metrics.records_flushed.Add(player_records.size());
     };
 
     std::vector<domain::PlayerRecord> UseCasesImpl::GetRecordsTable(size_t offset, size_t limit) {
         return player_records_.GetRecordsTable(offset, limit);
     };
+
+    std::vector<domain::PlayerRecord> UseCasesImpl::GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                                        , size_t offset, size_t limit) {
+        return player_records_.GetRecordsTableAfter(after, offset, limit);
+    };
+
+    void UseCasesImpl::AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                               , const boost::asio::any_io_executor& executor
+                                               , domain::RecordsHandler handler) {
+        player_records_.AsyncGetRecordsTableAfter(after, offset, limit, executor, std::move(handler));
+    };
+
+    uint64_t UseCasesImpl::GetLastRecordId() {
+        return player_records_.GetLastRecordId();
+    };
 }  // namespace app
\ No newline at end of file
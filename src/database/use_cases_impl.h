@@ -11,6 +11,12 @@ namespace db_storage {
 
         void AddPlayerRecords(const std::vector<domain::PlayerRecord>& player_records) override;
         std::vector<domain::PlayerRecord> GetRecordsTable(size_t offset, size_t limit) override;
+        std::vector<domain::PlayerRecord> GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                            , size_t offset, size_t limit) override;
+        void AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                     , const boost::asio::any_io_executor& executor
+                                     , domain::RecordsHandler handler) override;
+        uint64_t GetLastRecordId() override;
 
     private:
         domain::PlayerRecordRepository& player_records_;
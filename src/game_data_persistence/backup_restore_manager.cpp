@@ -1,43 +1,106 @@
 #include "backup_restore_manager.h"
 
-#include <boost/archive/text_oarchive.hpp>
+#include <algorithm>
+
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/bind/bind.hpp>
 #include <boost/bind/placeholders.hpp>
 
 #include "../logging/logger.h"
+#include "../metrics/metrics.h"
 
 namespace data_persistence {
 
+    using serialization::SyncPath;
+
+    namespace {
+
+        void ReportSaveError(const std::exception& ex, const fs::path& path) {
+            logger::LogEntryToConsole(boost::json::object{{"error"s, ex.what()}, {"file"s, path.string()}}
+                                    , "Failed to save game state"s, boost::log::trivial::error);
+        }
+
+    } // namespace
+
     void BackupRestoreManager::Restore(app::GameManager &manager, const model::Game &game) {
         std::lock_guard lgr(mtx_rest_);
+        const auto start = std::chrono::steady_clock::now();
+        serialization::GameStateCapture state;
+        bool restored = false;
+
         // Проверяем существование директории и файла
-        if (!fs::exists(root_path_.parent_path()) || !fs::exists(root_path_)) {
-            return;
+        if (fs::exists(root_path_.parent_path()) && fs::exists(root_path_)) {
+            // Создаем объект файлового потока и сразу открываем файл для чтения
+            std::ifstream ifs(root_path_, std::ios::in | std::ios::binary);
+
+            // Проверяем открыт ли файл
+            if(!ifs.is_open()){
+                throw std::runtime_error("Couldn't open the file for writing"s);
+            }
+
+            // Сохранения в двоичном формате; текстовый архив boost читаем для файлов прежних версий
+            if(serialization::IsBinarySnapshot(ifs)) {
+                state = serialization::ReadState(ifs);
+                restored = true;
+            } else {
+                // Создаем архив boost
+                boost::archive::text_iarchive backup{ifs};
+
+                try{
+                    // Создаем объект для десериализации
+                    serialization::GameManagerRepr manager_repr;
+                    // Десериализуем данные
+                    backup >> manager_repr;
+                    // Восстанавливаем объекты
+                    manager = std::move(manager_repr.Restore(game));
+                } catch (const boost::archive::archive_exception& e) {
+                    throw std::runtime_error("Serialization error: " + std::string(e.what()));
+                }
+            }
         }
 
-        // Создаем объект файлового потока и сразу открываем файл для чтения
-        std::ifstream ifs(root_path_, std::ios::in);
+        // Применяем изменения, записанные в журнал после снимка
+        if(!journal_path_.empty() && fs::exists(journal_path_)) {
+            const uint64_t checkpoint_seq = state.journal_seq;
+            uint64_t journal_size = 0;
+            {
+                std::ifstream jfs(journal_path_, std::ios::in | std::ios::binary);
+                if(!jfs.is_open()) {
+                    throw std::runtime_error("Couldn't open the journal for reading"s);
+                }
+
+                journal_size = serialization::ReplayJournal(jfs, state);
+            }
+
+            // Запись, оборванная при сбое, отбрасывается: новые записи пойдут после целой части журнала
+            if(journal_size < fs::file_size(journal_path_)) {
+                logger::LogEntryToConsole(boost::json::object{{"file"s, journal_path_.string()}, {"size"s, journal_size}}
+                                        , "Torn game state journal tail dropped"s, boost::log::trivial::warning);
+                fs::resize_file(journal_path_, journal_size);
+            }
+
+            restored = restored || state.journal_seq != checkpoint_seq;
+        }
 
-        // Проверяем открыт ли файл
-        if(!ifs.is_open()){
-            throw std::runtime_error("Couldn't open the file for writing"s);
+        if(restored) {
+            manager = serialization::RestoreState(state, game, std::max(std::thread::hardware_concurrency(), 1u));
         }
 
-        // Создаем архив boost
-        boost::archive::text_iarchive backup{ifs};
-            
-        try{
-            // Создаем объект для десериализации
-            serialization::GameManagerRepr manager_repr;
-            // Десериализуем данные
-            backup >> manager_repr;
-            // Восстанавливаем объекты
-            manager = std::move(manager_repr.Restore(game));
-        } catch (const boost::archive::archive_exception& e) {
-            throw std::runtime_error("Serialization error: " + std::string(e.what()));
+        // Время восстановления входит во время от запуска до первого обслуженного запроса
+        if(!manager.GetPlayers().empty()) {
+            const auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+            logger::LogEntryToConsole(boost::json::object{{"sessions"s, manager.GetAllSessions().size()}
+                                                        , {"players"s, manager.GetPlayers().size()}
+                                                        , {"duration_ms"s, duration.count()}}
+                                    , "Game state restored"s, boost::log::trivial::info);
         }
 
+        if(!journal_path_.empty()) {
+            journal_seq_ = state.journal_seq;
+            // Восстановленное состояние уже на диске - журнал продолжается с изменений после него
+            static_cast<void>(journal_tracker_.Capture(manager, journal_seq_));
+        }
     }
 
     void BackupRestoreManager::Serialize(const app::GameManager &manager) {
@@ -60,52 +123,185 @@ namespace data_persistence {
     }
 
     void BackupRestoreManager::RenameBackupFile() {
-        std::lock_guard lgr(mtx_);
-        // Переименовываем файл
-        if (fs::exists(root_path_)) {
-            fs::remove(root_path_);
+        // rename заменяет существующий файл атомарно: при сбое на диске остается старое или новое сохранение целиком
+        fs::rename(temp_root_path_, root_path_);
+    }
+
+    void BackupRestoreManager::SaveGame(const app::GameManager& manager) {
+        const auto start = std::chrono::steady_clock::now();
+        milliseconds current_t = std::chrono::duration_cast<milliseconds>(start.time_since_epoch());
+        // Полное сохранение, если автосохранение выключено (завершение работы)
+        // или достигли необходимого временного интервала
+        const bool checkpoint = !auto_save_ || current_t - old_time_ >= period_;
+
+        // Изменения с прошлого тика
+        std::optional<serialization::JournalRecord> record;
+        if(!journal_path_.empty()) {
+            record = journal_tracker_.Capture(manager, journal_seq_ + 1);
+            if(record) {
+                ++journal_seq_;
+            }
         }
 
-        if(fs::exists(temp_root_path_)){
-            fs::rename(temp_root_path_, root_path_);
+        if(!checkpoint && !record) {
+            return;
         }
 
+        // На strand только копируем состояние, кодирование и работа с диском идут в потоке записи
+        std::optional<serialization::GameStateCapture> state;
+        if(checkpoint) {
+            state = serialization::CaptureState(manager);
+            state->journal_seq = journal_seq_;
+            // Записываем время сохранения
+            old_time_ = current_t;
+        }
+        auto& server_metrics = metrics::GetServerMetrics();
+        const auto stall = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        server_metrics.save_stall_duration.Record(static_cast<uint64_t>(stall.count()));
+
+        {
+            std::lock_guard lock(mtx_);
+            if(record) {
+                pending_records_.push_back(std::move(*record));
+            }
+            if(state) {
+                if(pending_) {
+                    server_metrics.save_captures_dropped.Add();
+                }
+                // Незаписанная копия уходит в state и освобождается вне блокировки
+                std::swap(pending_, state);
+            }
+        }
+        cv_.notify_all();
     }
 
-    void BackupRestoreManager::SaveGame(const app::GameManager& manager) {
-        milliseconds current_t = 
-                std::chrono::duration_cast<milliseconds>(std::chrono::steady_clock::now().time_since_epoch());
-        // Проверяем что включено автосохранение
-        if(auto_save_) {
-            // Проверяем что достигли необходимого временного интерала для сохранения
-            milliseconds time_diff = current_t - old_time_;
-            if(time_diff < period_){
+    void BackupRestoreManager::Flush() {
+        std::unique_lock lock(mtx_);
+        cv_.wait(lock, [this] { return !pending_ && pending_records_.empty() && !writing_; });
+
+        if(write_error_) {
+            std::rethrow_exception(std::exchange(write_error_, nullptr));
+        }
+    }
+
+    void BackupRestoreManager::WriteCaptures(std::stop_token stop) {
+        std::unique_lock lock(mtx_);
+
+        while(true) {
+            // После запроса остановки дописываем оставшиеся копию и записи журнала и выходим
+            cv_.wait(lock, stop, [this] { return pending_.has_value() || !pending_records_.empty(); });
+            if(!pending_ && pending_records_.empty()) {
                 return;
             }
+
+            std::optional<serialization::GameStateCapture> state = std::exchange(pending_, std::nullopt);
+            std::vector<serialization::JournalRecord> records = std::exchange(pending_records_, {});
+            writing_ = true;
+            lock.unlock();
+
+            auto& server_metrics = metrics::GetServerMetrics();
+            std::exception_ptr error;
+            bool journal_written = false;
+            bool checkpoint_written = false;
+
+            // Записи журнала пишутся раньше контрольной точки, снятой после них
+            if(!records.empty() && !journal_failed_) {
+                try {
+                    AppendJournal(records);
+                    journal_written = true;
+                } catch(const std::exception& ex) {
+                    // После пропуска записи журнал неполон: дописывать его можно только после контрольной точки
+                    journal_failed_ = true;
+                    error = std::current_exception();
+                    ReportSaveError(ex, journal_path_);
+                }
+            }
+
+            if(state) {
+                const auto start = std::chrono::steady_clock::now();
+                try {
+                    WriteBackupFile(*state);
+                    const auto elapsed = std::chrono::steady_clock::now() - start;
+                    server_metrics.save_write_duration.Record(
+                        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+                    checkpoint_written = true;
+
+                    if(!journal_path_.empty()) {
+                        CompactJournal(records, state->journal_seq);
+                        journal_failed_ = false;
+                    }
+                } catch(const std::exception& ex) {
+                    error = std::current_exception();
+                    ReportSaveError(ex, root_path_);
+                }
+            }
+
+            lock.lock();
+            writing_ = false;
+            if(error) {
+                server_metrics.save_failures.Add();
+                if(!write_error_) {
+                    write_error_ = error;
+                }
+            }
+
+            if(journal_written) {
+                server_metrics.save_journal_records.Add(records.size());
+                for(const auto& record : records) {
+                    server_metrics.save_journal_bytes.Add(record.data.size());
+                }
+            }
+
+            if(checkpoint_written) {
+                server_metrics.saves.Add();
+            }
+            cv_.notify_all();
         }
+    }
 
-        // Создаем объект файлового потока и сразу открываем файл на запись
-        std::ofstream ofs(temp_root_path_, std::ios::out | std::ios::binary);
+    void BackupRestoreManager::AppendJournal(const std::vector<serialization::JournalRecord>& records) {
+        if(!journal_file_) {
+            journal_file_.emplace(journal_path_);
+        }
 
-        // Проверяем открыт ли файл
-        if(!ofs.is_open()){
-            throw std::runtime_error("Couldn't open the file for writing"s);
+        for(const auto& record : records) {
+            journal_file_->Append(record);
         }
 
-        // Создаем архив boost
-        boost::archive::text_oarchive backup{ofs};
-        // Сериализуем данные
-        serialization::GameManagerRepr manager_repr{manager};
-            
-        try {
-            // Сериализуем и сохраняем данные в файл
-            backup << manager_repr;
-            // Записываем время сохранения
-            old_time_ = current_t;
-            ofs.close();
-            RenameBackupFile();
-        } catch (const boost::archive::archive_exception& e) {
-            throw std::runtime_error("Serialization error: " + std::string(e.what()));
+        // Один сброс на диск на все накопившиеся записи
+        journal_file_->Sync();
+    }
+
+    void BackupRestoreManager::CompactJournal(const std::vector<serialization::JournalRecord>& records
+                                            , uint64_t checkpoint_seq) {
+        // Более новые записи могли быть сняты только после последнего захвата очереди
+        std::vector<serialization::JournalRecord> newer;
+        std::copy_if(records.begin(), records.end(), std::back_inserter(newer)
+                    , [checkpoint_seq](const auto& record) { return record.seq > checkpoint_seq; });
+
+        if(!journal_file_) {
+            journal_file_.emplace(journal_path_);
         }
+
+        journal_file_->Rewrite(newer);
+    }
+
+    void BackupRestoreManager::WriteBackupFile(const serialization::GameStateCapture& state) {
+        {
+            // Создаем объект файлового потока и сразу открываем файл на запись
+            std::ofstream ofs(temp_root_path_, std::ios::out | std::ios::binary | std::ios::trunc);
+
+            // Проверяем открыт ли файл
+            if(!ofs.is_open()){
+                throw std::runtime_error("Couldn't open the file for writing"s);
+            }
+
+            serialization::WriteSnapshot(ofs, state);
+        }
+
+        // Данные должны оказаться на диске раньше, чем файл займет место прежнего сохранения
+        SyncPath(temp_root_path_);
+        RenameBackupFile();
+        SyncPath(root_path_.has_parent_path() ? root_path_.parent_path() : fs::path{"."});
     }
 } // namespace data_persistence
\ No newline at end of file
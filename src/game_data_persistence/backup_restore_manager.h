@@ -1,15 +1,22 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <future>
 #include <mutex>
+#include <optional>
+#include <thread>
 
 #include <boost/signals2.hpp>
 
 #include "../application/application.h"
 #include "../serialization_game/game_manager_serialization.h"
+#include "../serialization_game/binary_snapshot.h"
+#include "../serialization_game/state_journal.h"
 
 namespace data_persistence {
 
@@ -26,9 +33,12 @@ namespace data_persistence {
         using SerializeSignal = sig::signal<void(const app::GameManager& manager, double current_time)>;
         using RestoreSignal = sig::signal<void(app::GameManager& manager, const model::Game& game)>;
 
-        BackupRestoreManager (const fs::path& root_path, TimeType save_interval, bool auto_save)
+        // journal_path - журнал изменений между полными сохранениями (пустой путь - без журнала)
+        BackupRestoreManager (const fs::path& root_path, TimeType save_interval, bool auto_save
+                            , const fs::path& journal_path = {})
         : root_path_{root_path}
         , temp_root_path_{root_path_}
+        , journal_path_{journal_path}
         , save_interval_{save_interval}
         , auto_save_(auto_save)
         , old_time_{std::chrono::duration_cast<milliseconds>(
@@ -39,7 +49,9 @@ namespace data_persistence {
                 period_ = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::duration<double, std::milli>(save_interval_.value()));
             }
+            writer_ = std::jthread([this](std::stop_token stop) { WriteCaptures(stop); });
         }
+        // Поток записи дописывает уже снятую копию перед завершением
         ~BackupRestoreManager() = default;
 
         void ConnectionToSignals(SerializeSignal& s_signal, RestoreSignal& r_signal);
@@ -52,13 +64,30 @@ namespace data_persistence {
 
         void SetAutoSave(bool auto_save);
 
-        void RenameBackupFile();
-
+        // Вызывается на strand после каждого тика. Изменения с прошлого тика уходят в журнал,
+        // раз в период сохранения снимается полная копия состояния (контрольная точка).
+        // Запись на диск идет в потоке записи
         void SaveGame(const app::GameManager& manager);
 
+        // Ждет окончания переданных сохранений, пробрасывает ошибку записи, если она была
+        void Flush();
+
     private:
+        void WriteCaptures(std::stop_token stop);
+
+        void WriteBackupFile(const serialization::GameStateCapture& state);
+
+        void AppendJournal(const std::vector<serialization::JournalRecord>& records);
+
+        // После контрольной точки в журнале остаются только записи новее нее
+        void CompactJournal(const std::vector<serialization::JournalRecord>& records, uint64_t checkpoint_seq);
+
+        // Атомарно заменяет файл сохранения записанным временным файлом
+        void RenameBackupFile();
+
         const fs::path root_path_;
         fs::path temp_root_path_;
+        const fs::path journal_path_;
         TimeType save_interval_;
         bool auto_save_ = false;
         double old_save_time_ = 0;
@@ -69,7 +98,25 @@ namespace data_persistence {
 
         std::mutex mtx_save_;
         std::mutex mtx_rest_;
-        std::mutex mtx_rename_;
-        std::mutex mtx_;
+        mutable std::mutex mtx_;
+
+        // Изменения состояния ищутся на strand; номер последней записи журнала
+        serialization::JournalTracker journal_tracker_;
+        uint64_t journal_seq_ = 0;
+
+        // Очередь из одной копии: новая копия заменяет еще не записанную. Записи журнала
+        // не заменяются, а копятся до записи
+        std::condition_variable_any cv_;
+        std::optional<serialization::GameStateCapture> pending_;
+        std::vector<serialization::JournalRecord> pending_records_;
+        // Открывается потоком записи при первой записи журнала
+        std::optional<serialization::JournalFile> journal_file_;
+        // Запись в журнал не удалась: до следующей контрольной точки журнал не дописывается
+        bool journal_failed_ = false;
+        bool writing_ = false;
+        std::exception_ptr write_error_;
+
+        // Объявлен последним: поток завершается до разрушения остальных полей
+        std::jthread writer_;
     };
 } // namespace data_persistence
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "async_sink.h"
+
+#include <algorithm>
+#include <string>
+
+#include <boost/log/core/core.hpp>
+#include <boost/log/utility/formatting_ostream.hpp>
+#include <boost/make_shared.hpp>
+
+#include "../metrics/metrics.h"
+
+namespace logger {
+
+    namespace {
+
+        std::atomic<uint64_t> next_sink_id{1};
+
+    } // namespace
+
+//---------------------------------------------------------------------------------------------------- методы Ring
+    AsyncLogSink::Ring::Ring(size_t capacity)
+        : slots_(capacity) {
+    }
+
+    bool AsyncLogSink::Ring::TryPush(boost::log::record_view const& rec) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+            return false;
+        }
+        slots_[tail % slots_.size()] = rec;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t AsyncLogSink::Ring::PopAll(std::vector<boost::log::record_view>& out) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        // Перемещение освобождает ячейку: запись не живет в буфере дольше вывода
+        for (uint64_t i = head; i != tail; ++i) {
+            out.push_back(std::move(slots_[i % slots_.size()]));
+        }
+        head_.store(tail, std::memory_order_release);
+        return static_cast<size_t>(tail - head);
+    }
+
+//---------------------------------------------------------------------------------------------------- методы AsyncLogSink
+    AsyncLogSink::AsyncLogSink(std::ostream& out, boost::log::formatter formatter, size_t ring_capacity)
+        // Записи выводятся в другом потоке: Boost.Log отвязывает от потока их атрибуты
+        : boost::log::sinks::sink(true)
+        , out_{out}
+        , formatter_{std::move(formatter)}
+        , ring_capacity_{std::max<size_t>(ring_capacity, 1)}
+        , id_{next_sink_id.fetch_add(1, std::memory_order_relaxed)} {
+        writer_ = std::jthread([this] {
+            WriterLoop();
+        });
+    }
+
+    AsyncLogSink::~AsyncLogSink() {
+        Stop();
+    }
+
+    bool AsyncLogSink::will_consume([[maybe_unused]] boost::log::attribute_value_set const& attributes) {
+        return true;
+    }
+
+    void AsyncLogSink::consume(boost::log::record_view const& rec) {
+        if (!CurrentRing().TryPush(rec)) {
+            metrics::GetServerMetrics().log_records_dropped.Add();
+        }
+    }
+
+    void AsyncLogSink::flush() {
+        std::unique_lock lock{mutex_};
+        if (stop_) {
+            return;
+        }
+        // Нужен проход, начатый после вызова: он увидит все записи этого потока
+        const uint64_t pass = started_pass_ + 1;
+        wanted_pass_ = std::max(wanted_pass_, pass);
+        wake_cv_.notify_one();
+        done_cv_.wait(lock, [this, pass] {
+            return finished_pass_ >= pass || stop_;
+        });
+    }
+
+    void AsyncLogSink::Stop() {
+        {
+            std::lock_guard lock{mutex_};
+            if (stop_) {
+                return;
+            }
+            stop_ = true;
+        }
+        wake_cv_.notify_one();
+        writer_.join();
+        done_cv_.notify_all();
+    }
+
+    AsyncLogSink::Ring& AsyncLogSink::CurrentRing() {
+        struct CachedRing {
+            uint64_t sink_id = 0;
+            Ring* ring = nullptr;
+        };
+        // Буфер регистрируется при первой записи потока. Буферы живут до конца работы приемника,
+        // поэтому поток может завершиться, не оставив висячих указателей
+        thread_local CachedRing cached;
+        if (cached.sink_id != id_) {
+            std::lock_guard lock{mutex_};
+            cached.ring = rings_.emplace_back(std::make_unique<Ring>(ring_capacity_)).get();
+            cached.sink_id = id_;
+        }
+        return *cached.ring;
+    }
+
+    void AsyncLogSink::WriterLoop() {
+        std::vector<boost::log::record_view> batch;
+        std::string text;
+
+        while (true) {
+            uint64_t pass = 0;
+            bool stop = false;
+            {
+                std::lock_guard lock{mutex_};
+                pass = ++started_pass_;
+                stop = stop_;
+            }
+
+            const size_t written = WriteAvailable(batch, text);
+
+            std::unique_lock lock{mutex_};
+            finished_pass_ = pass;
+            done_cv_.notify_all();
+            // Остановка - после прохода, начатого уже при stop_ и не нашедшего записей
+            if (stop && written == 0) {
+                break;
+            }
+            if (written == 0) {
+                wake_cv_.wait_for(lock, IDLE_INTERVAL, [this] {
+                    return stop_ || wanted_pass_ > finished_pass_;
+                });
+            }
+        }
+    }
+
+    size_t AsyncLogSink::WriteAvailable(std::vector<boost::log::record_view>& batch, std::string& text) {
+        batch.clear();
+        {
+            // Новые буферы добавляются в конец, уже выданные потокам не перемещаются
+            std::lock_guard lock{mutex_};
+            for (const auto& ring : rings_) {
+                ring->PopAll(batch);
+            }
+        }
+        if (batch.empty()) {
+            return 0;
+        }
+
+        text.clear();
+        boost::log::formatting_ostream stream{text};
+        for (const auto& rec : batch) {
+            formatter_(rec, stream);
+            stream << '\n';
+        }
+        stream.flush();
+
+        // Одна запись в поток на пачку вместо записи со сбросом на каждое сообщение
+        out_.write(text.data(), static_cast<std::streamsize>(text.size()));
+        out_.flush();
+        metrics::GetServerMetrics().log_records_written.Add(batch.size());
+
+        const size_t written = batch.size();
+        batch.clear();
+        return written;
+    }
+
+//---------------------------------------------------------------------------------------------------- методы AsyncLogRegistration
+    AsyncLogRegistration::AsyncLogRegistration(std::ostream& out, boost::log::formatter formatter, size_t ring_capacity)
+        : sink_{boost::make_shared<AsyncLogSink>(out, std::move(formatter), ring_capacity)} {
+        boost::log::core::get()->add_sink(sink_);
+    }
+
+    AsyncLogRegistration::~AsyncLogRegistration() {
+        boost::log::core::get()->remove_sink(sink_);
+        sink_->Stop();
+    }
+
+//---------------------------------------------------------------------------------------------------- методы RequestSampler
+    bool RequestSampler::Sample() const noexcept {
+        if (rate_ <= 1) {
+            return rate_ == 1;
+        }
+        // Счетчик свой у каждого потока: выборка не требует общей памяти
+        thread_local uint64_t seen = 0;
+        return seen++ % rate_ == 0;
+    }
+
+} // namespace logger
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include <boost/log/core/record_view.hpp>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/log/expressions/formatter.hpp>
+#include <boost/log/sinks/sink.hpp>
+
+namespace logger {
+
+    // Асинхронный приемник Boost.Log. Записи (неизменяемые наборы значений атрибутов) складываются
+    // в кольцевой буфер своего потока без блокировок; форматирование и вывод выполняет отдельный
+    // поток пачками. Память ограничена: запись в заполненный буфер отбрасывается и учитывается
+    // в показателе log_records_dropped_total
+    class AsyncLogSink : public boost::log::sinks::sink {
+    public:
+        // Размер буфера одного потока в записях
+        static constexpr size_t DEFAULT_RING_CAPACITY = 8192;
+        // Наибольшая пауза потока вывода, когда записей нет
+        static constexpr std::chrono::milliseconds IDLE_INTERVAL{10};
+
+        AsyncLogSink(std::ostream& out, boost::log::formatter formatter, size_t ring_capacity = DEFAULT_RING_CAPACITY);
+        AsyncLogSink(const AsyncLogSink&) = delete;
+        AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+        ~AsyncLogSink() override;
+
+        bool will_consume(boost::log::attribute_value_set const& attributes) override;
+        void consume(boost::log::record_view const& rec) override;
+        // Дожидается вывода всех записей, принятых до вызова
+        void flush() override;
+
+        // Выводит оставшиеся записи и останавливает поток вывода. Перед вызовом приемник
+        // нужно убрать из ядра Boost.Log
+        void Stop();
+
+    private:
+        // Буфер одного потока: пишет только он, читает только поток вывода
+        class Ring {
+        public:
+            explicit Ring(size_t capacity);
+
+            bool TryPush(boost::log::record_view const& rec);
+            // Добавляет записи в out, возвращает их число
+            size_t PopAll(std::vector<boost::log::record_view>& out);
+
+        private:
+            std::vector<boost::log::record_view> slots_;
+            alignas(64) std::atomic<uint64_t> head_{0};
+            alignas(64) std::atomic<uint64_t> tail_{0};
+        };
+
+        Ring& CurrentRing();
+        void WriterLoop();
+        size_t WriteAvailable(std::vector<boost::log::record_view>& batch, std::string& text);
+
+        std::ostream& out_;
+        boost::log::formatter formatter_;
+        const size_t ring_capacity_;
+        // Отличает приемник от прежнего по тому же адресу в кэше буфера потока
+        const uint64_t id_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_cv_;
+        std::condition_variable done_cv_;
+        std::vector<std::unique_ptr<Ring>> rings_;
+        // Номер начатого и законченного проходов вывода, номер прохода, которого ждет flush
+        uint64_t started_pass_ = 0;
+        uint64_t finished_pass_ = 0;
+        uint64_t wanted_pass_ = 0;
+        bool stop_ = false;
+        std::jthread writer_;
+    };
+
+    // Подключает асинхронный приемник к ядру Boost.Log. При разрушении отключает его
+    // и дожидается вывода оставшихся записей
+    class AsyncLogRegistration {
+    public:
+        AsyncLogRegistration(std::ostream& out, boost::log::formatter formatter
+                           , size_t ring_capacity = AsyncLogSink::DEFAULT_RING_CAPACITY);
+        AsyncLogRegistration(const AsyncLogRegistration&) = delete;
+        AsyncLogRegistration& operator=(const AsyncLogRegistration&) = delete;
+        ~AsyncLogRegistration();
+
+        AsyncLogSink& GetSink() noexcept {
+            return *sink_;
+        }
+
+    private:
+        boost::shared_ptr<AsyncLogSink> sink_;
+    };
+
+    // Выборка журналирования запросов: журналируется каждый rate-й запрос потока (1 - все, 0 - ни одного)
+    class RequestSampler {
+    public:
+        explicit RequestSampler(size_t rate) noexcept
+            : rate_{rate} {
+        }
+
+        bool Sample() const noexcept;
+
+    private:
+        size_t rate_;
+    };
+
+} // namespace logger
@@ -1,8 +1,10 @@
 #include "sdk.h"
 
+#include <chrono>
 #include <functional>
 #include <filesystem>
 #include <iostream>
+#include <optional>
 #include <thread>
 
 #include <boost/asio/io_context.hpp>
@@ -13,13 +15,17 @@
 #include "application/application.h"
 #include "software_options/parser.h"
 #include "logging/logger.h"
+#include "logging/async_sink.h"
 #include "request/request_handler.h"
 #include "server/http_server.h"
+#include "server/io_context_pool.h"
+#include "response/static_asset_cache.h"
 #include "work_with_json/json_loader.h"
 #include "game_data_persistence/backup_restore_manager.h"
 #include "database/database_connection_settings.h"
 #include "database/database_invariants.h"
 #include "database/database_exceptions.h"
+#include "metrics/metrics.h"
 
 #define FOR_LOCAL
 
@@ -45,10 +51,54 @@ void RunWorkers(unsigned n, const Fn& fn) {
     fn();
 }
 
+// Ответ служебного порта: GET /metrics отдает показатели сервера, остальное - 404
+template <typename Request>
+http::response<http::string_body> MakeMetricsResponse(const Request& req) {
+    http::response<http::string_body> response;
+    response.version(req.version());
+    response.keep_alive(req.keep_alive());
+
+    const std::string_view target{req.target().data(), req.target().size()};
+    if (target == "/metrics"sv && (req.method() == http::verb::get || req.method() == http::verb::head)) {
+        response.result(http::status::ok);
+        response.set(http::field::content_type, metrics::PROMETHEUS_CONTENT_TYPE);
+        response.body() = metrics::SerializePrometheus(metrics::GetServerMetrics());
+        response.prepare_payload();
+        if (req.method() == http::verb::head) {
+            response.body().clear();
+        }
+    } else {
+        response.result(http::status::not_found);
+        response.set(http::field::content_type, "text/plain"sv);
+        response.body() = "Not found"s;
+        response.prepare_payload();
+    }
+    return response;
+}
+
+// Файл из кэша для запроса GET или HEAD вне /api/ или nullptr. Пути с %-последовательностями
+// декодирует и отдает обработчик запросов, как и файлы, которых нет в кэше
+template <typename Request>
+http_response::StaticAssetPtr FindCachedAsset(const http_response::StaticAssetCache& cache, const Request& req) {
+    if (req.method() != http::verb::get && req.method() != http::verb::head) {
+        return nullptr;
+    }
+
+    std::string_view target{req.target().data(), req.target().size()};
+    target = target.substr(0, target.find('?'));
+    if (target.starts_with("/api/"sv) || target.find('%') != std::string_view::npos) {
+        return nullptr;
+    }
+
+    return cache.Find(target);
+}
+
 }  // namespace
 
 int main(int argc, const char* argv[]) {
     prog_opt::Args args = prog_opt::ParseCommandLine(argc, argv);
+    // Фоновый вывод журнала, живет до последней записи main
+    std::optional<logger::AsyncLogRegistration> async_log;
     std::shared_ptr<data_persistence::BackupRestoreManager> backup_restore_manager;
     auto save_game = [&backup_restore_manager](const app::GameManager& manager) {
                                                 backup_restore_manager->SaveGame(manager);
@@ -60,32 +110,44 @@ int main(int argc, const char* argv[]) {
         using RequestHandlerType = http_handler::RequestHandler;
         using LoggingHandlerType = logger::LogRequestHandler<RequestHandlerType>;
 
-        // 0. Устанавливаем логирование в консоль
+        // 0. Устанавливаем логирование в консоль. По умолчанию записи форматирует и выводит
+        // фоновый поток, обработчики запросов только кладут их в буфер
         boost::log::add_common_attributes();
 
-        boost::log::add_console_log(
-            std::clog,
-            keywords::format = &logger::JsonFormatter,
-            boost::log::keywords::auto_flush = true
-        );
+        if (args.sync_log) {
+            boost::log::add_console_log(
+                std::clog,
+                keywords::format = &logger::JsonFormatter,
+                boost::log::keywords::auto_flush = true
+            );
+        } else {
+            async_log.emplace(std::clog, &logger::JsonFormatter);
+        }
 
-        // 1. Прочитать из переменной среды url базы данных
+        // 1. Прочитать из переменной среды url базы данных (не нужен, если рекорды хранятся в локальном файле)
         const unsigned num_threads = std::thread::hardware_concurrency();
+        const bool embedded_records = args.records_storage == prog_opt::EMBEDDED_RECORDS_STORAGE;
         const char* db_url = std::getenv(db_invariants::DB_URL.c_str());
-        if (!db_url) {
+        if (!db_url && !embedded_records) {
             throw db_ex::EmptyDatabaseUrl();
         }
 
         #ifndef FOR_LOCAL
             const unsigned num_connections = 10u;
-            db_conn_settings::DbConnectrioSettings db_settings{num_connections, std::move(db_url)};
+            db_conn_settings::DbConnectrioSettings db_settings{num_connections, db_url ? db_url : "", args.records_journal};
         #else
             const unsigned num_connections = 5u;
-            db_conn_settings::DbConnectrioSettings db_settings{num_connections, std::move(db_url)};
+            db_conn_settings::DbConnectrioSettings db_settings{num_connections, db_url ? db_url : "", args.records_journal};
         #endif
+        if (embedded_records) {
+            db_settings.records_storage = db_conn_settings::RecordsStorage::EMBEDDED;
+            db_settings.records_log = args.records_log;
+        }
 
         // 2. Устанавливаем путь до статического контента
         fs::path root_path = args.www_root;
+        // 2.1 Загружаем статический контент в кэш, дальше он следит за изменениями каталога сам
+        auto asset_cache = std::make_shared<http_response::StaticAssetCache>(root_path);
         // 3. Инициализируем io_context
         net::io_context ioc(num_threads);
         // 4. Устанавливаем флаг начальной позиции персонажей
@@ -132,10 +194,15 @@ int main(int argc, const char* argv[]) {
             app::Application application(ioc, strand, std::move(game), tick_period, save_interval, db_settings);
             // 6.5 Устанавливаем параметры сохранения экземпляру приложения
             application.SetSaveNeeded(auto_save_needed);
+            // 6.6 Задаем число потоков поиска столкновений внутри сессии
+            application.SetCollisionThreads(args.collision_threads);
+            // 6.7 Задаем наибольшую длину шага автоматического тика
+            application.SetTickMaxStep(args.tick_max_step);
 
         // 7. Создаем экземпляр backup_restore_manager
         if(needed_save) {
-            backup_restore_manager = std::make_shared<data_persistence::BackupRestoreManager>(root_save_path, save_interval, auto_save_needed);
+            backup_restore_manager = std::make_shared<data_persistence::BackupRestoreManager>(root_save_path, save_interval
+                                                                                            , auto_save_needed, args.state_journal);
             // 7.1 Связываем сигналы в Application с слотами BackupRestoreManager
             backup_restore_manager->ConnectionToSignals(application.GetSerializeSignal(), application.GetRestoreSignal());
             // 7.2 Задаем восстановление
@@ -145,13 +212,25 @@ int main(int argc, const char* argv[]) {
             }
         }
 
-        // 8. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
+        // 8. В режиме per-core соединения обслуживают отдельные io_context, по одному на поток.
+        // Общий ioc остается за игрой: strand приложения, таймеры, сохранения. Без перехода между
+        // потоками отдаются только файлы из кэша: запрос API выполняется в strand игры и его ответ
+        // возвращается в поток соединения
+        std::optional<http_server::IoContextPool> io_pool;
+        if (args.per_core_io) {
+            io_pool.emplace(std::max(1u, num_threads), args.pin_io_threads);
+        }
+
+        // 8.1 Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc, &application](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        signals.async_wait([&ioc, &io_pool](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
             if (!ec) {
                 std::string message("Signal "s + std::to_string(signal_number) + " signal_number"s);
                 logger::LogEntryToConsole(boost::json::object{}, message);
                 ioc.stop();
+                if (io_pool) {
+                    io_pool->Stop();
+                }
             }   
         });
 
@@ -162,12 +241,56 @@ int main(int argc, const char* argv[]) {
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
 
-        http_server::ServeHttp(ioc, {address, port}, [logging_handler](auto&& endp, auto&& req, auto&& send) {
+        const logger::RequestSampler request_sampler{args.log_requests_sample};
+
+        auto serve = [handler, logging_handler, request_sampler, asset_cache](auto&& endp, auto&& req, auto&& send) {
+            // Время обработки считается до передачи ответа сессии, по обработчику API
+            auto& api_metrics = metrics::GetServerMetrics().Api(
+                metrics::ClassifyTarget(std::string_view{req.target().data(), req.target().size()}));
+            auto measured_send = [&api_metrics, start = std::chrono::steady_clock::now()
+                                , send = std::forward<decltype(send)>(send)](auto&& response) mutable {
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                api_metrics.duration.Record(
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+                if (response.result_int() >= 400) {
+                    api_metrics.errors.Add();
+                }
+                send(std::forward<decltype(response)>(response));
+            };
+            // Файл из кэша отдается сразу в потоке соединения, без обработчика и журнала запросов
+            if (const auto asset = FindCachedAsset(*asset_cache, req)) {
+                measured_send(http_response::MakeAssetResponse(*asset, http_response::MakeAssetRequest(req)));
+                return;
+            }
+            // Запросы вне выборки обрабатываются без журналирования
+            if (!request_sampler.Sample()) {
+                metrics::GetServerMetrics().requests_not_logged.Add();
+                handler->operator()(std::forward<decltype(req)>(req), std::move(measured_send));
+                return;
+            }
             logging_handler->operator()(std::forward<decltype(endp)>(endp)
                             , std::forward<decltype(req)>(req)
-                            , std::forward<decltype(send)>(send)
+                            , std::move(measured_send)
                         );
-        });
+        };
+
+        if (io_pool) {
+            // Listener на каждом io_context слушает тот же порт, ядро распределяет соединения между ними
+            for (size_t i = 0; i < io_pool->Size(); ++i) {
+                http_server::ServeHttp(io_pool->GetContext(i), {address, port}, serve, true);
+            }
+        } else {
+            http_server::ServeHttp(ioc, {address, port}, serve);
+        }
+
+        // 10.1 Служебный порт показателей слушает только локальный адрес
+        if (args.metrics_port != 0) {
+            const auto metrics_port = static_cast<net::ip::port_type>(args.metrics_port);
+            http_server::ServeHttp(ioc, {net::ip::make_address("127.0.0.1"), metrics_port}
+                                 , []([[maybe_unused]] auto&& endp, auto&& req, auto&& send) {
+                                       send(MakeMetricsResponse(req));
+                                   });
+        }
 
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         logger::LogEntryToConsole(
@@ -177,8 +300,12 @@ int main(int argc, const char* argv[]) {
             }
             , "Server has started"s);
 
-        // 11. Запускаем обработку асинхронных операций
-        RunWorkers(std::max(1u, num_threads), [&ioc] {
+        // 11. Запускаем обработку асинхронных операций. В режиме per-core игре хватает одного потока:
+        // ее обработчики все равно выполняются последовательно в strand
+        if (io_pool) {
+            io_pool->Run();
+        }
+        RunWorkers(io_pool ? 1u : std::max(1u, num_threads), [&ioc] {
             //ioc.run();
             try {
                 // Ваш код с Boost.Asio
@@ -189,12 +316,22 @@ int main(int argc, const char* argv[]) {
             } 
         });
 
+        if (io_pool) {
+            io_pool->Stop();
+            io_pool->Join();
+        }
+
         // 12 Сохранения состояния сервера
         if(!root_save_path.empty()) {
             backup_restore_manager->SetAutoSave(false);
-            application.EmitSerializeSignal();            
+            application.EmitSerializeSignal();
+            // Дожидаемся записи последнего сохранения фоновым потоком
+            backup_restore_manager->Flush();
         }
 
+        // 13 Дописываем в БД рекорды, оставшиеся в очереди
+        application.DrainRecords();
+
     } catch (const std::exception& ex) {    
         logger::LogEntryToConsole(boost::json::object{  {"exeption"s, ex.what()},
                                                         {"exit_code", EXIT_FAILURE}
@@ -204,10 +341,6 @@ int main(int argc, const char* argv[]) {
         net::io_context ioc;
         ioc.stop();
 
-        if(needed_save) {
-            backup_restore_manager->RenameBackupFile();
-        }
-
         return EXIT_FAILURE;
     }
 
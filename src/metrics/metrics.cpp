@@ -0,0 +1,248 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace metrics {
+
+    using namespace std::literals;
+
+    namespace {
+
+        // Границы le гистограмм: 1 мкс, 4 мкс, 16 мкс ... 4^12 мкс (около 16.8 с)
+        constexpr unsigned LE_BOUNDS_COUNT = 13;
+
+        struct EndpointTarget {
+            std::string_view target;
+            ApiEndpoint endpoint;
+        };
+
+        constexpr EndpointTarget API_TARGETS[] = {
+            {"/api/v1/maps"sv, ApiEndpoint::MAPS},
+            {"/api/v1/game/join"sv, ApiEndpoint::JOIN},
+            {"/api/v1/game/players"sv, ApiEndpoint::PLAYERS},
+            {"/api/v1/game/state"sv, ApiEndpoint::STATE},
+            {"/api/v1/game/player/action"sv, ApiEndpoint::ACTION},
+            {"/api/v1/game/tick"sv, ApiEndpoint::TICK},
+            {"/api/v1/game/records"sv, ApiEndpoint::RECORDS},
+        };
+
+        constexpr std::string_view ENDPOINT_NAMES[API_ENDPOINTS_COUNT] = {
+            "maps"sv, "map"sv, "join"sv, "players"sv, "state"sv, "action"sv, "tick"sv, "records"sv, "other_api"sv, "static"sv
+        };
+
+        // Микросекунды в секундах для значений le и _sum
+        std::string FormatSeconds(uint64_t microseconds) {
+            char buffer[32];
+            const int size = std::snprintf(buffer, sizeof(buffer), "%.6f", static_cast<double>(microseconds) / 1e6);
+            return std::string(buffer, static_cast<size_t>(size));
+        }
+
+        class PrometheusWriter {
+        public:
+            void Family(std::string_view name, std::string_view type, std::string_view help) {
+                out_.append("# HELP "sv).append(name).append(" "sv).append(help).append("\n"sv);
+                out_.append("# TYPE "sv).append(name).append(" "sv).append(type).append("\n"sv);
+            }
+
+            void Sample(std::string_view name, std::string_view labels, std::string_view value) {
+                out_.append(name);
+                if(!labels.empty()) {
+                    out_.append("{"sv).append(labels).append("}"sv);
+                }
+                out_.append(" "sv).append(value).append("\n"sv);
+            }
+
+            void WriteCounter(std::string_view name, std::string_view help, const Counter& counter) {
+                Family(name, "counter"sv, help);
+                Sample(name, {}, std::to_string(counter.Value()));
+            }
+
+            // Гистограмма без семейства: несколько наборов с разными метками пишутся под одним заголовком
+            void WriteHistogramSamples(std::string_view name, const std::string& labels, const Histogram& histogram) {
+                const Histogram::Snapshot snapshot = histogram.Collect();
+                const std::string bucket_name = std::string(name) + "_bucket"s;
+                const std::string prefix = labels.empty() ? ""s : labels + ","s;
+
+                for(unsigned i = 0; i < LE_BOUNDS_COUNT; ++i) {
+                    const uint64_t bound = uint64_t{1} << (2 * i);
+                    Sample(bucket_name, prefix + "le=\""s + FormatSeconds(bound) + "\""s
+                         , std::to_string(snapshot.CountBelow(bound)));
+                }
+                Sample(bucket_name, prefix + "le=\"+Inf\""s, std::to_string(snapshot.count));
+                Sample(std::string(name) + "_sum"s, labels, FormatSeconds(snapshot.sum));
+                Sample(std::string(name) + "_count"s, labels, std::to_string(snapshot.count));
+            }
+
+            void WriteHistogram(std::string_view name, std::string_view help, const Histogram& histogram) {
+                Family(name, "histogram"sv, help);
+                WriteHistogramSamples(name, {}, histogram);
+            }
+
+            std::string Release() {
+                return std::move(out_);
+            }
+
+        private:
+            std::string out_;
+        };
+
+    } // namespace
+
+    uint64_t Counter::Value() const noexcept {
+        uint64_t value = 0;
+        for(const auto& shard : shards_) {
+            value += shard.value.load(std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    Histogram::Snapshot Histogram::Collect() const noexcept {
+        Snapshot snapshot;
+        for(const auto& shard : shards_) {
+            for(size_t i = 0; i < BUCKETS_COUNT; ++i) {
+                snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            }
+            snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        for(const uint64_t bucket : snapshot.buckets) {
+            snapshot.count += bucket;
+        }
+        return snapshot;
+    }
+
+    uint64_t Histogram::BucketUpperBound(size_t index) noexcept {
+        if(index < SUB_BUCKETS) {
+            return index;
+        }
+
+        const unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+        const uint64_t lower = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + (uint64_t{1} << shift) - 1;
+    }
+
+    uint64_t Histogram::Snapshot::CountBelow(uint64_t bound) const noexcept {
+        // Степень двойки - нижняя граница своего интервала, поэтому для таких bound счет точный
+        uint64_t result = 0;
+        for(size_t i = 0; i < BUCKETS_COUNT && BucketUpperBound(i) < bound; ++i) {
+            result += buckets[i];
+        }
+        return result;
+    }
+
+    uint64_t Histogram::Snapshot::ValueAtQuantile(double q) const noexcept {
+        if(count == 0) {
+            return 0;
+        }
+
+        const auto rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+        uint64_t seen = 0;
+        for(size_t i = 0; i < BUCKETS_COUNT; ++i) {
+            seen += buckets[i];
+            if(seen >= std::max<uint64_t>(rank, 1)) {
+                return BucketUpperBound(i);
+            }
+        }
+        return BucketUpperBound(BUCKETS_COUNT - 1);
+    }
+
+    ApiEndpoint ClassifyTarget(std::string_view target) noexcept {
+        if(const size_t query = target.find('?'); query != std::string_view::npos) {
+            target.remove_suffix(target.size() - query);
+        }
+        if(target.size() > 1 && target.back() == '/') {
+            target.remove_suffix(1);
+        }
+
+        if(!target.starts_with("/api/"sv)) {
+            return ApiEndpoint::STATIC;
+        }
+        for(const auto& [api_target, endpoint] : API_TARGETS) {
+            if(target == api_target) {
+                return endpoint;
+            }
+        }
+        if(target.starts_with("/api/v1/maps/"sv)) {
+            return ApiEndpoint::MAP;
+        }
+        return ApiEndpoint::OTHER_API;
+    }
+
+    std::string_view EndpointName(ApiEndpoint endpoint) noexcept {
+        return ENDPOINT_NAMES[static_cast<size_t>(endpoint)];
+    }
+
+    ServerMetrics& GetServerMetrics() noexcept {
+        static ServerMetrics server_metrics;
+        return server_metrics;
+    }
+
+    std::string SerializePrometheus(const ServerMetrics& server_metrics) {
+        PrometheusWriter writer;
+
+        writer.WriteHistogram("game_tick_duration_seconds"sv, "Duration of a game tick"sv, server_metrics.tick_duration);
+        writer.WriteCounter("game_ticks_total"sv, "Game ticks"sv, server_metrics.ticks);
+        writer.WriteCounter("game_sessions_ticked_total"sv, "Game sessions updated by ticks"sv, server_metrics.sessions_ticked);
+        writer.WriteHistogram("game_tick_jitter_seconds"sv, "Delay of a scheduled tick past its deadline"sv
+                        , server_metrics.tick_jitter);
+        writer.WriteCounter("game_tick_overruns_total"sv, "Ticks late by a whole period or more"sv
+                      , server_metrics.tick_overruns);
+        writer.WriteCounter("game_ticks_skipped_total"sv, "Ticks merged into a late tick"sv, server_metrics.ticks_skipped);
+        writer.WriteCounter("game_tick_substeps_total"sv, "Sub-steps of split long ticks"sv, server_metrics.tick_substeps);
+
+        writer.WriteHistogram("game_collision_duration_seconds"sv, "Collision handling of one session"sv
+                        , server_metrics.collision_duration);
+        writer.WriteCounter("game_collision_pairs_tested_total"sv, "Gatherer-item pairs tested for collision"sv
+                      , server_metrics.collision_pairs_tested);
+        writer.WriteCounter("game_collision_events_total"sv, "Gathering events found"sv, server_metrics.collision_events);
+
+        writer.WriteHistogram("game_save_stall_duration_seconds"sv, "Time a save holds the tick strand"sv
+                        , server_metrics.save_stall_duration);
+        writer.WriteHistogram("game_save_write_duration_seconds"sv, "Writing a state file in the background"sv
+                        , server_metrics.save_write_duration);
+        writer.WriteCounter("game_saves_total"sv, "State checkpoints written"sv, server_metrics.saves);
+        writer.WriteCounter("game_save_failures_total"sv, "Failed state or journal writes"sv, server_metrics.save_failures);
+        writer.WriteCounter("game_save_captures_dropped_total"sv, "State copies replaced before they were written"sv
+                      , server_metrics.save_captures_dropped);
+        writer.WriteCounter("game_save_journal_records_total"sv, "Change journal records written"sv
+                      , server_metrics.save_journal_records);
+        writer.WriteCounter("game_save_journal_bytes_total"sv, "Change journal bytes written"sv
+                      , server_metrics.save_journal_bytes);
+
+        writer.WriteHistogram("records_flush_duration_seconds"sv, "Saving a batch of player records"sv
+                        , server_metrics.records_flush_duration);
+        writer.WriteCounter("records_flushed_total"sv, "Player records saved"sv, server_metrics.records_flushed);
+        writer.WriteCounter("records_flush_failures_total"sv, "Failed player record batches"sv
+                      , server_metrics.records_flush_failures);
+
+        writer.WriteHistogram("db_pool_wait_seconds"sv, "Wait for a free database connection"sv
+                        , server_metrics.db_pool_wait);
+        writer.WriteCounter("db_pool_timeouts_total"sv, "Database connection waits that timed out"sv
+                      , server_metrics.db_pool_timeouts);
+        writer.WriteCounter("db_reconnects_total"sv, "Closed database connections opened again"sv
+                      , server_metrics.db_reconnects);
+
+        writer.Family("http_request_duration_seconds"sv, "histogram"sv, "HTTP request handling until the response is sent"sv);
+        for(size_t i = 0; i < API_ENDPOINTS_COUNT; ++i) {
+            const std::string labels = "endpoint=\""s + std::string(EndpointName(static_cast<ApiEndpoint>(i))) + "\""s;
+            writer.WriteHistogramSamples("http_request_duration_seconds"sv, labels, server_metrics.api[i].duration);
+        }
+        writer.Family("http_request_errors_total"sv, "counter"sv, "HTTP responses with 4xx or 5xx status"sv);
+        for(size_t i = 0; i < API_ENDPOINTS_COUNT; ++i) {
+            const std::string labels = "endpoint=\""s + std::string(EndpointName(static_cast<ApiEndpoint>(i))) + "\""s;
+            writer.Sample("http_request_errors_total"sv, labels, std::to_string(server_metrics.api[i].errors.Value()));
+        }
+
+        writer.WriteCounter("http_requests_not_logged_total"sv, "HTTP requests left out of the request log sample"sv
+                      , server_metrics.requests_not_logged);
+
+        writer.WriteCounter("log_records_written_total"sv, "Log records written by the background writer"sv
+                      , server_metrics.log_records_written);
+        writer.WriteCounter("log_records_dropped_total"sv, "Log records dropped because a buffer was full"sv
+                      , server_metrics.log_records_dropped);
+
+        return writer.Release();
+    }
+
+} // namespace metrics
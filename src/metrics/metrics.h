@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace metrics {
+
+    // Число ячеек каждого счетчика. Поток пишет только в свою ячейку (потоки раскладываются по ячейкам
+    // по кругу), поэтому запись - одна атомарная операция без блокировок и без общей с другими
+    // потоками кэш-линии. Ячейки суммируются при чтении
+    inline constexpr size_t SHARDS_COUNT = 8;
+
+    // Запись показателей. Выключается, чтобы замерить их стоимость (tick_bench): счетчики
+    // и гистограммы тогда не меняются, а ScopedTimer не читает часы
+    inline std::atomic<bool> recording_enabled{true};
+
+    inline bool IsRecording() noexcept {
+        return recording_enabled.load(std::memory_order_relaxed);
+    }
+
+    inline void SetRecording(bool enabled) noexcept {
+        recording_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    // Ячейка текущего потока
+    inline size_t CurrentShard() noexcept {
+        static std::atomic<size_t> next_shard{0};
+        thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS_COUNT;
+        return shard;
+    }
+
+    class Counter {
+    public:
+        void Add(uint64_t value = 1) noexcept {
+            if(!IsRecording()) {
+                return;
+            }
+            shards_[CurrentShard()].value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        uint64_t Value() const noexcept;
+
+    private:
+        struct alignas(64) Shard {
+            std::atomic<uint64_t> value{0};
+        };
+
+        std::array<Shard, SHARDS_COUNT> shards_{};
+    };
+
+    // Гистограмма в духе HDR: каждая степень двойки делится на 8 равных интервалов, поэтому
+    // относительная погрешность значения не больше 12.5% во всем диапазоне. Значения - целые
+    // (длительности - в микросекундах), значения от 2^40 попадают в последний интервал
+    class Histogram {
+    public:
+        static constexpr unsigned SUB_BUCKET_BITS = 3;
+        static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+        static constexpr unsigned MAX_EXPONENT = 40;
+        static constexpr size_t BUCKETS_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        // Сумма ячеек на момент чтения
+        struct Snapshot {
+            std::array<uint64_t, BUCKETS_COUNT> buckets{};
+            uint64_t count = 0;
+            uint64_t sum = 0;
+
+            // Число значений меньше bound
+            uint64_t CountBelow(uint64_t bound) const noexcept;
+            // Верхняя граница интервала, в который попадает квантиль q (0 - нет значений)
+            uint64_t ValueAtQuantile(double q) const noexcept;
+        };
+
+        void Record(uint64_t value) noexcept {
+            if(!IsRecording()) {
+                return;
+            }
+            Shard& shard = shards_[CurrentShard()];
+            shard.buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+            shard.sum.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        Snapshot Collect() const noexcept;
+
+        static size_t BucketIndex(uint64_t value) noexcept {
+            if(value < SUB_BUCKETS) {
+                return static_cast<size_t>(value);
+            }
+
+            const unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+            if(exponent >= MAX_EXPONENT) {
+                return BUCKETS_COUNT - 1;
+            }
+
+            const unsigned shift = exponent - SUB_BUCKET_BITS;
+            return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) & (SUB_BUCKETS - 1));
+        }
+
+        // Наибольшее значение, попадающее в интервал index
+        static uint64_t BucketUpperBound(size_t index) noexcept;
+
+    private:
+        struct alignas(64) Shard {
+            std::array<std::atomic<uint64_t>, BUCKETS_COUNT> buckets{};
+            std::atomic<uint64_t> sum{0};
+        };
+
+        std::array<Shard, SHARDS_COUNT> shards_{};
+    };
+
+    // Записывает в гистограмму время своей жизни в микросекундах
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Histogram& histogram) noexcept
+            : histogram_{histogram}
+            , recording_{IsRecording()} {
+            if(recording_) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        ~ScopedTimer() {
+            if(!recording_) {
+                return;
+            }
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            histogram_.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+        }
+
+    private:
+        Histogram& histogram_;
+        bool recording_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    // Обработчики API, у каждого свои задержки и ошибки
+    enum class ApiEndpoint {
+        MAPS,
+        MAP,
+        JOIN,
+        PLAYERS,
+        STATE,
+        ACTION,
+        TICK,
+        RECORDS,
+        // Неизвестный адрес внутри /api/
+        OTHER_API,
+        // Статические файлы
+        STATIC,
+        COUNT
+    };
+
+    inline constexpr size_t API_ENDPOINTS_COUNT = static_cast<size_t>(ApiEndpoint::COUNT);
+
+    // Обработчик по цели запроса (параметры запроса после '?' не учитываются)
+    ApiEndpoint ClassifyTarget(std::string_view target) noexcept;
+    // Значение метки endpoint
+    std::string_view EndpointName(ApiEndpoint endpoint) noexcept;
+
+    struct ApiMetrics {
+        Histogram duration;
+        // Ответы со статусом 4xx и 5xx
+        Counter errors;
+    };
+
+    // Показатели сервера. Длительности - в микросекундах
+    struct ServerMetrics {
+        // Тик: Application::UpdateGameSessions
+        Histogram tick_duration;
+        Counter ticks;
+        Counter sessions_ticked;
+
+        // Автоматический тик (time_m::Ticker): опоздание срабатывания таймера относительно расписания,
+        // тики, опоздавшие на период и больше, объединенные с ними пропущенные тики и подшаги
+        Histogram tick_jitter;
+        Counter tick_overruns;
+        Counter ticks_skipped;
+        Counter tick_substeps;
+
+        // Столкновения: CollisionManager::HandlerCollision
+        Histogram collision_duration;
+        Counter collision_pairs_tested;
+        Counter collision_events;
+
+        // Сохранение: копия состояния на strand тика и запись файла в фоновом потоке, записанные
+        // контрольные точки, неудачные записи, копии, замененные более свежими до начала записи,
+        // и записи журнала изменений, сброшенные на диск
+        Histogram save_stall_duration;
+        Histogram save_write_duration;
+        Counter saves;
+        Counter save_failures;
+        Counter save_captures_dropped;
+        Counter save_journal_records;
+        Counter save_journal_bytes;
+
+        // Запись рекордов в хранилище (SaveRecordsTable)
+        Histogram records_flush_duration;
+        Counter records_flushed;
+        Counter records_flush_failures;
+
+        // Пул соединений с БД (db::BasicConnectionPool): ожидание свободного соединения,
+        // истекшие ожидания и пересозданные соединения
+        Histogram db_pool_wait;
+        Counter db_pool_timeouts;
+        Counter db_reconnects;
+
+        std::array<ApiMetrics, API_ENDPOINTS_COUNT> api;
+        // Запросы, не попавшие в выборку журналирования
+        Counter requests_not_logged;
+
+        // Асинхронный журнал (logger::AsyncLogSink): выведенные записи и отброшенные из-за заполненного буфера
+        Counter log_records_written;
+        Counter log_records_dropped;
+
+        ApiMetrics& Api(ApiEndpoint endpoint) noexcept {
+            return api[static_cast<size_t>(endpoint)];
+        }
+    };
+
+    // Показатели процесса
+    ServerMetrics& GetServerMetrics() noexcept;
+
+    // Показатели в текстовом формате Prometheus (версия 0.0.4)
+    std::string SerializePrometheus(const ServerMetrics& server_metrics);
+
+    inline constexpr std::string_view PROMETHEUS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+} // namespace metrics
@@ -1,5 +1,6 @@
 #include "map.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include "application/game_manager.h"
@@ -70,8 +71,59 @@ namespace model {
         }
     }
 
-    void Map::AddLootType(LootType loot_types) {
+    void Map::AddLootType(LootType loot_types, double width) {
+        if (width < 0.0) {
+            throw std::invalid_argument("Loot width must be non-negative");
+        }
+
         loot_types_.emplace_back(loot_types);
+        loot_widths_.emplace_back(width);
+        max_loot_width_ = std::max(max_loot_width_, width);
+    }
+
+    std::optional<double> Map::GetOfficeWidth() const noexcept {
+        return office_width_;
+    }
+
+    std::optional<double> Map::GetDogWidth() const noexcept {
+        return dog_width_;
+    }
+
+    // Радиус подбора трофея. Для неизвестного типа - точка (0)
+    double Map::GetLootWidth(size_t loot_type) const noexcept {
+        return loot_type < loot_widths_.size() ? loot_widths_[loot_type] : 0.0;
+    }
+
+    double Map::GetMaxLootWidth() const noexcept {
+        return max_loot_width_;
+    }
+
+    std::optional<double> Map::GetCollisionCellSize() const noexcept {
+        return collision_cell_size_;
+    }
+
+    void Map::SetOfficeWidth(double width) {
+        if (width < 0.0) {
+            throw std::invalid_argument("Office width must be non-negative");
+        }
+
+        office_width_ = width;
+    }
+
+    void Map::SetDogWidth(double width) {
+        if (width < 0.0) {
+            throw std::invalid_argument("Dog width must be non-negative");
+        }
+
+        dog_width_ = width;
+    }
+
+    void Map::SetCollisionCellSize(double cell_size) {
+        if (cell_size <= 0.0) {
+            throw std::invalid_argument("Collision cell size must be positive");
+        }
+
+        collision_cell_size_ = cell_size;
     }
 
     void Map::SetBagCapacity(size_t bag_capacity) {
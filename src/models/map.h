@@ -6,6 +6,9 @@
 #include "office.h"
 #include "loot_types.h"
 
+#include <optional>
+#include <vector>
+
 
 
 namespace model {
@@ -19,6 +22,8 @@ namespace model {
         using Buildings = std::vector<Building>;
         using Offices = std::vector<Office>;
         using LootTypes = std::vector<LootType>;
+        // Радиусы подбора по типам трофеев (индекс совпадает с индексом в LootTypes)
+        using LootWidths = std::vector<double>;
 
         Map(Id id, std::string name) noexcept
             : id_(std::move(id))
@@ -34,13 +39,24 @@ namespace model {
         size_t GetBagCapacity() const noexcept;
         double GetSpeed_characters() const noexcept;
 
+        // Параметры столкновений карты. Если ширина не задана в конфигурации карты,
+        // используется значение игры по умолчанию
+        std::optional<double> GetOfficeWidth() const noexcept;
+        std::optional<double> GetDogWidth() const noexcept;
+        double GetLootWidth(size_t loot_type) const noexcept;
+        double GetMaxLootWidth() const noexcept;
+        std::optional<double> GetCollisionCellSize() const noexcept;
+
         void SetSpeedCharacters(double speed);
         void SetBagCapacity(size_t bag_capacity);
+        void SetOfficeWidth(double width);
+        void SetDogWidth(double width);
+        void SetCollisionCellSize(double cell_size);
 
         void AddRoad(const Road& road);
         void AddBuilding(const Building& building);
         void AddOffice(Office office);
-        void AddLootType(LootType loot_types);
+        void AddLootType(LootType loot_types, double width = 0.0);
 
     private:
         using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
@@ -52,6 +68,11 @@ namespace model {
         OfficeIdToIndex warehouse_id_to_index_;
         Offices offices_;
         LootTypes loot_types_;
+        LootWidths loot_widths_;
+        double max_loot_width_ = 0.0;
+        std::optional<double> office_width_;
+        std::optional<double> dog_width_;
+        std::optional<double> collision_cell_size_;
         double speed_characters_ = DEFAULT_SPEED_ON_MAP;
         size_t bag_capacity_ = 0;
         size_t road_id_ = 0;
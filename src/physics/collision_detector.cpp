@@ -1,6 +1,8 @@
 #include "collision_detector.h"
 
 #include <cassert>
+#include <cmath>
+#include <tuple>
 
 namespace collision_detector {
 
@@ -22,45 +24,166 @@ namespace collision_detector {
         return CollectionResult(sq_distance, proj_ratio);
     }
 
-    // Ищем события (доставка игрок пришел на базу или игрок собрал потерянный предмет)
-    std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
-        std::vector<GatheringEvent> detected_events;
+    // По умолчанию кандидатами считаются все предметы
+    void ItemGathererProvider::FindCandidateItems([[maybe_unused]] const Gatherer& gatherer
+                                                , std::pmr::vector<size_t>& candidates) const {
+        candidates.clear();
 
-        static auto PointsEqual = [](geom::Point2D p1, geom::Point2D p2) {
-            return p1.x == p2.x && p1.y == p2.y;
-        };
+        for(size_t i = 0; i < ItemsCount(); ++i) {
+            candidates.emplace_back(i);
+        }
+    }
+
+    namespace detail {
+
+        // Ищем события собирателей с номерами [gatherers_begin, gatherers_end). События каждого собирателя
+        // добавляются в events подряд и упорядочиваются по времени, их границы - в runs
+        size_t CollectGatherersEvents(const ItemGathererProvider& provider, size_t gatherers_begin, size_t gatherers_end
+                                , std::pmr::vector<GatheringEvent>& events, std::pmr::vector<EventsRun>& runs
+                                , std::pmr::vector<size_t>& candidates) {
+            static auto PointsEqual = [](geom::Point2D p1, geom::Point2D p2) {
+                return p1.x == p2.x && p1.y == p2.y;
+            };
+
+            size_t tested_pairs = 0;
+
+            for(size_t g = gatherers_begin; g < gatherers_end; ++g){
+                Gatherer gatherer = provider.GetGatherer(g);
 
-        for(size_t g = 0; g < provider.GatherersCount(); ++g){
-            Gatherer gatherer = provider.GetGatherer(g);
+                if(PointsEqual(gatherer.start_pos, gatherer.end_pos)){
+                    continue;
+                }
+
+                // Отбираем только предметы из ячеек, через которые проходит собиратель
+                provider.FindCandidateItems(gatherer, candidates);
+                tested_pairs += candidates.size();
+
+                const size_t run_begin = events.size();
+                const size_t gatherer_id = provider.GetGathererId(g);
+
+                for (size_t i : candidates) {
+                    Item item = provider.GetItem(i);
+                    auto collect_result
+                        = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
+
+                    if (collect_result.IsCollected(gatherer.width + item.width)) {
+                        GatheringEvent evt{.item_id = provider.GetItemId(i),
+                                        .gatherer_id = gatherer_id,
+                                        .sq_distance = collect_result.sq_distance,
+                                        .time = collect_result.proj_ratio,
+                                        .actor = item.type == LOST_OBJ ? MOVE_BAG : MOVE_BASE};
+                        events.emplace_back(evt);
+                    }
+                }
 
-            if(PointsEqual(gatherer.start_pos, gatherer.end_pos)){
-                continue;
+                if(run_begin == events.size()) {
+                    continue;
+                }
+
+                // Отрезок собирателя независим от остальных - достаточно упорядочить только его события
+                std::sort(events.begin() + run_begin, events.end()
+                            , [](const GatheringEvent& e_l, const GatheringEvent& e_r){
+                                return e_l.time < e_r.time;
+                });
+
+                runs.emplace_back(EventsRun{run_begin, events.size()});
             }
 
-            for (size_t i = 0; i < provider.ItemsCount(); ++i) {
-                Item item = provider.GetItem(i);
-                auto collect_result
-                    = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
-
-                if (collect_result.IsCollected(gatherer.width + item.width)) {
-                    GatheringEvent evt{.item_id = provider.GetItemId(i),
-                                    .gatherer_id = provider.GetGathererId(g),
-                                    .sq_distance = collect_result.sq_distance,
-                                    .time = collect_result.proj_ratio,
-                                    .actor = item.type == LOST_OBJ ? MOVE_BAG : MOVE_BASE};
-                    detected_events.emplace_back(evt);
+            return tested_pairs;
+        }
+
+        // Независимые собиратели переносятся в результат как есть, события собирателей, претендующих
+        // на один потерянный предмет, сливаются (k-way merge) в порядке (time, gatherer_id),
+        // чтобы предмет достался первому
+        std::pmr::vector<GatheringEvent> OrderGatherEvents(std::pmr::vector<GatheringEvent>&& events
+                                                        , std::pmr::vector<EventsRun>& runs
+                                                        , std::pmr::memory_resource* resource) {
+            // Потерянный предмет -> первый собиратель (номер в runs), который его задел
+            std::pmr::unordered_map<size_t, size_t> item_to_run{resource};
+            bool has_contested = false;
+
+            for(size_t r = 0; r < runs.size(); ++r) {
+                for(size_t e = runs[r].begin; e < runs[r].end; ++e) {
+                    // Офисы не исчезают после доставки, поэтому спорными могут быть только потерянные предметы
+                    if(events[e].actor != MOVE_BAG) {
+                        continue;
+                    }
+
+                    auto [found, inserted] = item_to_run.try_emplace(events[e].item_id, r);
+
+                    if(!inserted && found->second != r) {
+                        runs[found->second].contested = true;
+                        runs[r].contested = true;
+                        has_contested = true;
+                    }
                 }
             }
-            
+
+            if(!has_contested) {
+                return std::move(events);
+            }
+
+            std::pmr::vector<GatheringEvent> result{resource};
+            // Куча из текущих позиций спорных собирателей
+            std::pmr::vector<EventsRun*> heap{resource};
+
+            result.reserve(events.size());
+
+            for(auto& run : runs) {
+                if(run.contested) {
+                    heap.emplace_back(&run);
+                    continue;
+                }
+
+                result.insert(result.end(), events.begin() + run.begin, events.begin() + run.end);
+            }
+
+            // std::*_heap строят кучу с максимумом в вершине, поэтому сравнение обратное
+            auto later = [&events](const EventsRun* lhs, const EventsRun* rhs) {
+                const GatheringEvent& l = events[lhs->begin];
+                const GatheringEvent& r = events[rhs->begin];
+                return std::tie(l.time, l.gatherer_id) > std::tie(r.time, r.gatherer_id);
+            };
+
+            std::make_heap(heap.begin(), heap.end(), later);
+
+            while(!heap.empty()) {
+                std::pop_heap(heap.begin(), heap.end(), later);
+                EventsRun* run = heap.back();
+                result.emplace_back(events[run->begin++]);
+
+                if(run->begin == run->end) {
+                    heap.pop_back();
+                    continue;
+                }
+
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+
+            return result;
         }
 
-        std::sort(detected_events.begin(), detected_events.end()
-                    , [](const GatheringEvent& e_l, const GatheringEvent& e_r){
-                        return e_l.time < e_r.time;
+    } // namespace detail
+
+    // Ищем события (доставка игрок пришел на базу или игрок собрал потерянный предмет).
+    // События каждого собирателя идут подряд и упорядочены по времени. Общий порядок по (time, gatherer_id)
+    // строится слиянием только для собирателей, претендующих на один и тот же потерянный предмет
+    std::pmr::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider
+                                                    , std::pmr::memory_resource* resource, size_t* tested_pairs) {
+        std::pmr::vector<GatheringEvent> detected_events{resource};
+        // Границы событий каждого собирателя в detected_events
+        std::pmr::vector<detail::EventsRun> runs{resource};
+        // Индексы предметов, которые может задеть текущий собиратель
+        std::pmr::vector<size_t> candidates{resource};
 
-        });
+        runs.reserve(provider.GatherersCount());
+        const size_t pairs = detail::CollectGatherersEvents(provider, 0, provider.GatherersCount()
+                                                        , detected_events, runs, candidates);
+        if(tested_pairs) {
+            *tested_pairs += pairs;
+        }
 
-        return detected_events;
+        return detail::OrderGatherEvents(std::move(detected_events), runs, resource);
     }
 
     // Возвращаем количество предметов
@@ -70,8 +193,7 @@ namespace collision_detector {
 
     // Возвращаем предмет по индексу
     Item ItemGathererProviderImpl::GetItem(size_t idx) const {
-        ItemId id = items_id_.at(idx);
-        return items_.at(id);
+        return items_.at(idx);
     }
 
     // Возвращаем id предмета по индексу
@@ -79,10 +201,80 @@ namespace collision_detector {
         return items_id_.at(idx);
     }
 
-    // Добавляем предмет в индекс
+    // Отбираем предметы из ячеек сетки, которые пересекает отрезок движения собирателя
+    void ItemGathererProviderImpl::FindCandidateItems(const Gatherer& gatherer, std::pmr::vector<size_t>& candidates) const {
+        candidates.clear();
+        // Расширяем область поиска на максимальный радиус сбора
+        const double reach = gatherer.width + max_item_width_;
+        const int64_t min_x = GetCellCoord(std::min(gatherer.start_pos.x, gatherer.end_pos.x) - reach);
+        const int64_t max_x = GetCellCoord(std::max(gatherer.start_pos.x, gatherer.end_pos.x) + reach);
+        const int64_t min_y = GetCellCoord(std::min(gatherer.start_pos.y, gatherer.end_pos.y) - reach);
+        const int64_t max_y = GetCellCoord(std::max(gatherer.start_pos.y, gatherer.end_pos.y) + reach);
+        const uint64_t cells_count = static_cast<uint64_t>(max_x - min_x + 1) * static_cast<uint64_t>(max_y - min_y + 1);
+
+        // Если отрезок накрывает больше ячеек, чем есть предметов, быстрее проверить все предметы
+        if(cells_count > items_.size()) {
+            ItemGathererProvider::FindCandidateItems(gatherer, candidates);
+            return;
+        }
+
+        for(int64_t x = min_x; x <= max_x; ++x) {
+            for(int64_t y = min_y; y <= max_y; ++y) {
+                if(auto cell = grid_.find(GetCellKey(x, y)); cell != grid_.end()) {
+                    candidates.insert(candidates.end(), cell->second.begin(), cell->second.end());
+                }
+            }
+        }
+    }
+
+    // Добавляем предмет в индекс. Если предмет с таким id уже есть - обновляем его
     void ItemGathererProviderImpl::AddItem(ItemId item_id, Item item)  {
+        if(auto found = item_id_to_index_.find(item_id); found != item_id_to_index_.end()) {
+            const size_t idx = found->second;
+            RemoveItemFromGrid(items_[idx], idx);
+            items_[idx] = item;
+            AddItemInGrid(item, idx);
+            max_item_width_ = std::max(max_item_width_, item.width);
+            return;
+        }
+
+        const size_t idx = items_.size();
+        items_.emplace_back(item);
         items_id_.emplace_back(item_id);
-        items_.emplace(item_id,item);
+        item_id_to_index_.emplace(item_id, idx);
+        AddItemInGrid(item, idx);
+        max_item_width_ = std::max(max_item_width_, item.width);
+    }
+
+    // Удаляем предмет из индекса, на его место переставляем последний предмет
+    bool ItemGathererProviderImpl::RemoveItem(ItemId item_id) {
+        auto found = item_id_to_index_.find(item_id);
+
+        if(found == item_id_to_index_.end()) {
+            return false;
+        }
+
+        const size_t idx = found->second;
+        const size_t last_idx = items_.size() - 1;
+        item_id_to_index_.erase(found);
+        RemoveItemFromGrid(items_[idx], idx);
+
+        if(idx != last_idx) {
+            ReplaceItemIndexInGrid(items_[last_idx], last_idx, idx);
+            items_[idx] = items_[last_idx];
+            items_id_[idx] = items_id_[last_idx];
+            item_id_to_index_[items_id_[idx]] = idx;
+        }
+
+        items_.pop_back();
+        items_id_.pop_back();
+
+        return true;
+    }
+
+    // Проверяем наличие предмета в индексе
+    bool ItemGathererProviderImpl::ContainsItem(ItemId item_id) const {
+        return item_id_to_index_.contains(item_id);
     }
 
     // Возвращаем количество собирателей
@@ -92,9 +284,7 @@ namespace collision_detector {
 
     // Возвращаем соискателя по индексу
     Gatherer ItemGathererProviderImpl::GetGatherer(size_t idx) const{
-        GathererId id = gatherers_id_.at(idx);
-
-        return gatherers_.at(id);
+        return gatherers_.at(idx);
     }
 
     // Возвращаем id соискателя по индексу
@@ -105,16 +295,38 @@ namespace collision_detector {
     // Добавляем соискателя в индекс
     void ItemGathererProviderImpl::AddGatherer(GathererId gatherer_id,  Gatherer gatherer)  {
         gatherers_id_.emplace_back(gatherer_id);
-        gatherers_.emplace(gatherer_id, std::move(gatherer));
+        gatherers_.emplace_back(std::move(gatherer));
+    }
+
+    // Резервируем место в индексах, чтобы избежать перестроений при заполнении
+    void ItemGathererProviderImpl::Reserve(size_t items_count, size_t gatherers_count) {
+        items_.reserve(items_count);
+        items_id_.reserve(items_count);
+        item_id_to_index_.reserve(items_count);
+        gatherers_.reserve(gatherers_count);
+        gatherers_id_.reserve(gatherers_count);
     }
    
-    // Очищаем индекс соискателей
+    // Меняем размер ячейки сетки и перераскладываем предметы
+    void ItemGathererProviderImpl::SetCellSize(double cell_size) {
+        cell_size_ = std::max(cell_size, MIN_GRID_CELL_SIZE);
+        grid_.clear();
+
+        for(size_t i = 0; i < items_.size(); ++i) {
+            AddItemInGrid(items_[i], i);
+        }
+    }
+   
+    // Очищаем индекс предметов
     void ItemGathererProviderImpl::ResetItemList() noexcept {
-        items_id_.clear();
         items_.clear();
+        items_id_.clear();
+        item_id_to_index_.clear();
+        grid_.clear();
+        max_item_width_ = 0.0;
     }
    
-    // Очищаем индекс предметов
+    // Очищаем индекс соискателей
     void ItemGathererProviderImpl::ResetGathererList() noexcept {
         gatherers_id_.clear();
         gatherers_.clear();
@@ -126,4 +338,47 @@ namespace collision_detector {
         ResetItemList();
     };
 
+    // Упаковываем координаты ячейки в один ключ
+    ItemGathererProviderImpl::CellKey ItemGathererProviderImpl::GetCellKey(int64_t cell_x, int64_t cell_y) const noexcept {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cell_x)) << 32) | static_cast<uint32_t>(cell_y);
+    }
+
+    // Получаем номер ячейки по координате
+    int64_t ItemGathererProviderImpl::GetCellCoord(double coord) const noexcept {
+        return static_cast<int64_t>(std::floor(coord / cell_size_));
+    }
+
+    // Добавляем индекс предмета в ячейку сетки
+    void ItemGathererProviderImpl::AddItemInGrid(const Item& item, size_t idx) {
+        // Вектор ячейки создается в том же ресурсе памяти, что и сетка
+        grid_[GetCellKey(GetCellCoord(item.position.x), GetCellCoord(item.position.y))].emplace_back(idx);
+    }
+
+    // Удаляем индекс предмета из ячейки сетки
+    void ItemGathererProviderImpl::RemoveItemFromGrid(const Item& item, size_t idx) {
+        auto cell = grid_.find(GetCellKey(GetCellCoord(item.position.x), GetCellCoord(item.position.y)));
+
+        if(cell == grid_.end()) {
+            return;
+        }
+
+        auto& indexes = cell->second;
+
+        if(auto it = std::find(indexes.begin(), indexes.end(), idx); it != indexes.end()) {
+            *it = indexes.back();
+            indexes.pop_back();
+        }
+    }
+
+    // Заменяем индекс переставленного предмета в ячейке сетки
+    void ItemGathererProviderImpl::ReplaceItemIndexInGrid(const Item& item, size_t old_idx, size_t new_idx) {
+        auto cell = grid_.find(GetCellKey(GetCellCoord(item.position.x), GetCellCoord(item.position.y)));
+
+        if(cell == grid_.end()) {
+            return;
+        }
+
+        std::replace(cell->second.begin(), cell->second.end(), old_idx, new_idx);
+    }
+
 } // namespace collision_detector
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <memory_resource>
 #include <vector>
 #include <unordered_map>
 
@@ -61,8 +63,17 @@ namespace collision_detector {
         virtual Gatherer GetGatherer(size_t idx) const = 0;
         virtual size_t GetItemId(size_t idx) const = 0;
         virtual size_t GetGathererId(size_t idx) const = 0;
+
+        // Заполняет candidates индексами предметов, которые может задеть собиратель.
+        // По умолчанию кандидатами считаются все предметы
+        virtual void FindCandidateItems(const Gatherer& gatherer, std::pmr::vector<size_t>& candidates) const;
     };
 
+    // Размер ячейки равномерной сетки, по которой раскладываются предметы, по умолчанию
+    const double DEFAULT_GRID_CELL_SIZE = 4.0;
+    // Минимальный размер ячейки: при меньших ячейках обход сетки дороже проверки лишних предметов
+    const double MIN_GRID_CELL_SIZE = 1.0;
+
     struct GatheringEvent {
         size_t item_id;
         size_t gatherer_id;
@@ -77,9 +88,21 @@ namespace collision_detector {
         using ItemId = size_t;
         using GathererId = size_t;
 
+        // Все индексы размещаются в переданном ресурсе памяти (например, в арене тика)
+        explicit ItemGathererProviderImpl(std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+                                        , double cell_size = DEFAULT_GRID_CELL_SIZE)
+            : items_{resource}
+            , items_id_{resource}
+            , item_id_to_index_{resource}
+            , grid_{resource}
+            , gatherers_{resource}
+            , gatherers_id_{resource}
+            , cell_size_{cell_size} {
+        }
+
         virtual ~ItemGathererProviderImpl() = default;
         
-        size_t ItemsCount() const;
+        size_t ItemsCount() const override;
 
         Item GetItem(size_t idx) const override;
         ItemId GetItemId(size_t idx) const override;
@@ -87,23 +110,74 @@ namespace collision_detector {
         Gatherer GetGatherer(size_t idx) const override;
         GathererId GetGathererId(size_t idx) const override;
 
+        void FindCandidateItems(const Gatherer& gatherer, std::pmr::vector<size_t>& candidates) const override;
+
         void AddItem(ItemId item_id, Item item);
+        bool RemoveItem(ItemId item_id);
+        bool ContainsItem(ItemId item_id) const;
         void AddGatherer(GathererId gatherer_id, Gatherer gatherer);
 
+        void Reserve(size_t items_count, size_t gatherers_count);
+        void SetCellSize(double cell_size);
+
         void ResetItemList() noexcept;
         void ResetGathererList() noexcept;
 
         void FullResetLists() noexcept;
         
     private:
-        std::vector<ItemId> items_id_;
-        std::unordered_map<ItemId, Item> items_;
-        std::vector<GathererId> gatherers_id_;
-        std::unordered_map<ItemId, Gatherer> gatherers_;
+        using CellKey = uint64_t;
+
+        CellKey GetCellKey(int64_t cell_x, int64_t cell_y) const noexcept;
+        int64_t GetCellCoord(double coord) const noexcept;
+        void AddItemInGrid(const Item& item, size_t idx);
+        void RemoveItemFromGrid(const Item& item, size_t idx);
+        void ReplaceItemIndexInGrid(const Item& item, size_t old_idx, size_t new_idx);
+
+    private:
+        // Предметы хранятся в непрерывных массивах, удаление - перестановкой последнего элемента на место удаленного
+        std::pmr::vector<Item> items_;
+        std::pmr::vector<ItemId> items_id_;
+        std::pmr::unordered_map<ItemId, size_t> item_id_to_index_;
+        // Равномерная сетка: ячейка -> индексы предметов в ней
+        std::pmr::unordered_map<CellKey, std::pmr::vector<size_t>> grid_;
+        std::pmr::vector<Gatherer> gatherers_;
+        std::pmr::vector<GathererId> gatherers_id_;
+        double cell_size_ = DEFAULT_GRID_CELL_SIZE;
+        // Наибольшая ширина предмета - на нее расширяется область поиска в сетке
+        double max_item_width_ = 0.0;
     };
 
     // Эту функцию вам нужно будет реализовать в соответствующем задании.
     // При проверке ваших тестов она не нужна - функция будет линковаться снаружи.
-    std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
+    // Вектор событий размещается в resource, что позволяет обойтись без обращений к куче в течение тика.
+    // События одного собирателя идут подряд по возрастанию time; собиратели, претендующие на один
+    // потерянный предмет, слиты в общем порядке (time, gatherer_id).
+    // В tested_pairs (если задан) прибавляется число проверенных пар собиратель-предмет
+    std::pmr::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider
+                                        , std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+                                        , size_t* tested_pairs = nullptr);
+
+    // Этапы поиска событий, общие для однопоточного и многопоточного поиска
+    namespace detail {
+
+        // События одного собирателя: полуинтервал [begin, end) в общем списке
+        struct EventsRun {
+            size_t begin = 0;
+            size_t end = 0;
+            // Собиратель претендует на предмет, который задевают и другие собиратели
+            bool contested = false;
+        };
+
+        // Возвращает число проверенных пар собиратель-предмет
+        size_t CollectGatherersEvents(const ItemGathererProvider& provider, size_t gatherers_begin, size_t gatherers_end
+                                , std::pmr::vector<GatheringEvent>& events, std::pmr::vector<EventsRun>& runs
+                                , std::pmr::vector<size_t>& candidates);
+
+        std::pmr::vector<GatheringEvent> OrderGatherEvents(std::pmr::vector<GatheringEvent>&& events
+                                                        , std::pmr::vector<EventsRun>& runs
+                                                        , std::pmr::memory_resource* resource);
+
+    } // namespace detail
 
 }  // namespace collision_detector
\ No newline at end of file
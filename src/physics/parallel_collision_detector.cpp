@@ -0,0 +1,103 @@
+#include "parallel_collision_detector.h"
+
+#include <algorithm>
+#include <latch>
+
+#include <boost/asio/post.hpp>
+
+namespace collision_detector {
+
+    ParallelGatherEventsFinder::ParallelGatherEventsFinder(size_t threads_count, size_t min_gatherers_per_thread)
+        : threads_count_{std::max<size_t>(threads_count, 1)}
+        , min_gatherers_per_thread_{std::max<size_t>(min_gatherers_per_thread, 1)}
+        , pool_{std::max<size_t>(threads_count_ - 1, 1)}
+        , chunks_(threads_count_) {
+    }
+
+    ParallelGatherEventsFinder::~ParallelGatherEventsFinder() {
+        pool_.join();
+    }
+
+    size_t ParallelGatherEventsFinder::ThreadsCount() const noexcept {
+        return threads_count_;
+    }
+
+    // Ищем события, распределяя собирателей между потоками
+    std::pmr::vector<GatheringEvent> ParallelGatherEventsFinder::FindGatherEvents(const ItemGathererProvider& provider
+                                                                            , std::pmr::memory_resource* resource
+                                                                            , size_t* tested_pairs) {
+        const size_t gatherers_count = provider.GatherersCount();
+        const size_t chunks_count = std::min(threads_count_, gatherers_count / min_gatherers_per_thread_);
+
+        // Собирателей слишком мало, чтобы делить их между потоками
+        if(chunks_count <= 1) {
+            return collision_detector::FindGatherEvents(provider, resource, tested_pairs);
+        }
+
+        const size_t chunk_size = (gatherers_count + chunks_count - 1) / chunks_count;
+        std::latch done{static_cast<std::ptrdiff_t>(chunks_count - 1)};
+
+        // Первую часть обрабатывает вызывающий поток, остальные - пул
+        for(size_t c = 1; c < chunks_count; ++c) {
+            const size_t begin = std::min(c * chunk_size, gatherers_count);
+            const size_t end = std::min(begin + chunk_size, gatherers_count);
+
+            boost::asio::post(pool_, [this, &provider, &done, begin, end, c] {
+                ProcessChunk(provider, begin, end, chunks_[c]);
+                done.count_down();
+            });
+        }
+
+        ProcessChunk(provider, 0, std::min(chunk_size, gatherers_count), chunks_[0]);
+        done.wait();
+
+        size_t events_count = 0;
+        size_t runs_count = 0;
+
+        for(size_t c = 0; c < chunks_count; ++c) {
+            if(chunks_[c].error) {
+                std::rethrow_exception(chunks_[c].error);
+            }
+
+            events_count += chunks_[c].events.size();
+            runs_count += chunks_[c].runs.size();
+            if(tested_pairs) {
+                *tested_pairs += chunks_[c].tested_pairs;
+            }
+        }
+
+        // Склеиваем части в порядке собирателей, сдвигая границы их событий
+        std::pmr::vector<GatheringEvent> detected_events{resource};
+        std::pmr::vector<detail::EventsRun> runs{resource};
+        detected_events.reserve(events_count);
+        runs.reserve(runs_count);
+
+        for(size_t c = 0; c < chunks_count; ++c) {
+            const size_t offset = detected_events.size();
+            detected_events.insert(detected_events.end(), chunks_[c].events.begin(), chunks_[c].events.end());
+
+            for(const auto& run : chunks_[c].runs) {
+                runs.emplace_back(detail::EventsRun{run.begin + offset, run.end + offset});
+            }
+        }
+
+        return detail::OrderGatherEvents(std::move(detected_events), runs, resource);
+    }
+
+    // Ищем события части собирателей в буферы этой части
+    void ParallelGatherEventsFinder::ProcessChunk(const ItemGathererProvider& provider, size_t gatherers_begin
+                                                , size_t gatherers_end, ChunkBuffers& chunk) noexcept {
+        chunk.events.clear();
+        chunk.runs.clear();
+        chunk.tested_pairs = 0;
+        chunk.error = nullptr;
+
+        try {
+            chunk.tested_pairs = detail::CollectGatherersEvents(provider, gatherers_begin, gatherers_end
+                                                            , chunk.events, chunk.runs, chunk.candidates);
+        } catch(...) {
+            chunk.error = std::current_exception();
+        }
+    }
+
+} // namespace collision_detector
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "collision_detector.h"
+
+#include <exception>
+#include <memory_resource>
+#include <vector>
+
+#include <boost/asio/thread_pool.hpp>
+
+namespace collision_detector {
+
+    // Минимальное число собирателей на поток: на маленьких сессиях раздача задач дороже самого поиска
+    const size_t MIN_GATHERERS_PER_THREAD = 32;
+
+    // Многопоточный поиск событий. Собиратели делятся на непрерывные части, события каждой части ищутся
+    // в своем потоке (одна часть - в вызывающем), затем части склеиваются в исходном порядке собирателей
+    // и упорядочиваются так же, как в однопоточном FindGatherEvents, поэтому результаты совпадают.
+    // Провайдер должен допускать одновременные константные обращения из нескольких потоков.
+    // Вызовы FindGatherEvents одного экземпляра не должны пересекаться (в игре они идут в strand тика)
+    class ParallelGatherEventsFinder {
+    public:
+        explicit ParallelGatherEventsFinder(size_t threads_count
+                                        , size_t min_gatherers_per_thread = MIN_GATHERERS_PER_THREAD);
+
+        ParallelGatherEventsFinder(const ParallelGatherEventsFinder&) = delete;
+        ParallelGatherEventsFinder& operator=(const ParallelGatherEventsFinder&) = delete;
+
+        ~ParallelGatherEventsFinder();
+
+        // tested_pairs - как у collision_detector::FindGatherEvents
+        std::pmr::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider
+                                            , std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+                                            , size_t* tested_pairs = nullptr);
+
+        size_t ThreadsCount() const noexcept;
+
+    private:
+        // Буферы части собирателей. Живут между вызовами, поэтому после прогрева
+        // потоки не обращаются к куче
+        struct ChunkBuffers {
+            std::pmr::vector<GatheringEvent> events;
+            std::pmr::vector<detail::EventsRun> runs;
+            std::pmr::vector<size_t> candidates;
+            size_t tested_pairs = 0;
+            std::exception_ptr error;
+        };
+
+        void ProcessChunk(const ItemGathererProvider& provider, size_t gatherers_begin, size_t gatherers_end
+                        , ChunkBuffers& chunk) noexcept;
+
+    private:
+        size_t threads_count_;
+        size_t min_gatherers_per_thread_;
+        // Вызывающий поток тоже обрабатывает часть, поэтому рабочих потоков в пуле на один меньше
+        boost::asio::thread_pool pool_;
+        std::vector<ChunkBuffers> chunks_;
+    };
+
+} // namespace collision_detector
@@ -2,8 +2,6 @@
 
 
 namespace http_response {
-    std::mutex http_response::Response::mtx_for_file_;
-    std::mutex http_response::Response::mtx_for_string_;
 
     StringResponse Response::CreateStringResponse(http::status status
                                             , unsigned http_version
@@ -13,7 +11,17 @@ namespace http_response {
                                             , std::string_view cache_control
                                             , std::string_view allow) {
 
-        std::lock_guard lgd(mtx_for_string_);
+        return MakeStringResponse(status, http_version, std::string{body}, keep_alive, content_type, cache_control, allow);
+    }
+
+    StringResponse Response::MakeStringResponse(http::status status
+                                            , unsigned http_version
+                                            , std::string body
+                                            , bool keep_alive
+                                            , std::string_view content_type
+                                            , std::string_view cache_control
+                                            , std::string_view allow) {
+
         // Формирую ответ со статусом и версией равной версии запроса
         StringResponse response(status, http_version);
         // Добавляю заголовок Content-Type: application/json
@@ -27,12 +35,9 @@ namespace http_response {
             response.set(http::field::allow, allow);
         }
 
-        if(!body.empty()){
-            response.body() = std::move(body);
-        }
-
         // Формирую заголовок Content-Length, сообщающий длину тела ответа
         response.content_length(body.size());
+        response.body() = std::move(body);
         // Формирую заголовок поддержания соединения (Connection) в зависимости от значения заголовка в запросе
         response.keep_alive(keep_alive);
 
@@ -46,7 +51,6 @@ namespace http_response {
                                                     , std::string_view content_type
                                                     , std::string_view cache_control)  {
 
-        std::lock_guard lgd(mtx_for_file_);
         FileResponse response(status, http_version);
         response.set(http::field::content_type, content_type);
         response.body() = std::move(file);
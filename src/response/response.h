@@ -1,8 +1,9 @@
 #pragma once
 
+#include <concepts>
 #include <functional>
 #include <string>
-#include <mutex>
+#include <utility>
 
 #include <boost/beast/http.hpp>
 
@@ -30,7 +31,21 @@ namespace http_response {
     }
     ~Response() = default;
 
-    // Создание ответа
+    // Создание ответа. Ответ собирается только из аргументов, поэтому вызывается из любого потока без блокировок.
+    // Готовое тело (std::string) перемещается в ответ без копирования
+    template <typename Body>
+        requires std::same_as<Body, std::string>
+    static StringResponse CreateStringResponse(http::status status
+                                        , unsigned http_version
+                                        , Body&& body
+                                        , bool keep_alive
+                                        , std::string_view content_type
+                                        , std::string_view cache_control
+                                        , std::string_view allow) {
+        return MakeStringResponse(status, http_version, std::move(body), keep_alive, content_type, cache_control, allow);
+    }
+
+    // Тело из string_view копируется в ответ
     static StringResponse CreateStringResponse(http::status status
                                         , unsigned http_version
                                         , std::string_view body
@@ -47,13 +62,19 @@ namespace http_response {
                                             , std::string_view cache_control) ;
 
     private:    
+    static StringResponse MakeStringResponse(http::status status
+                                        , unsigned http_version
+                                        , std::string body
+                                        , bool keep_alive
+                                        , std::string_view content_type
+                                        , std::string_view cache_control
+                                        , std::string_view allow);
+
     static string GetBody(const string& body, const model::Game& game);
 
     private:
     app::Application& application_;
     SendFunction send_;
-    static std::mutex mtx_for_file_;
-    static std::mutex mtx_for_string_;
     };
     
 } // http_response
\ No newline at end of file
@@ -0,0 +1,602 @@
+#include "static_asset_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <optional>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace http_response {
+
+    using namespace std::literals;
+
+    namespace {
+
+        const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE | IN_ONLYDIR;
+        // Как часто поток наблюдения проверяет запрос на остановку
+        const int WATCH_POLL_TIMEOUT_MS = 100;
+
+        // Содержимое файла с отпечатком в имени не меняется, такой файл клиент хранит год без проверки.
+        // Остальные файлы клиент проверяет при каждом обращении (обычно это ответ 304 без тела)
+        const std::string_view IMMUTABLE_CACHE_CONTROL = "public, max-age=31536000, immutable"sv;
+        const std::string_view REVALIDATE_CACHE_CONTROL = "no-cache"sv;
+        // Минимальная длина отпечатка содержимого в имени файла (шестнадцатеричные цифры)
+        const size_t MIN_FINGERPRINT_LENGTH = 8;
+
+        std::string ToLower(std::string_view str) {
+            std::string result(str);
+            for(auto& c : result) {
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+            return result;
+        }
+
+        std::string_view GetContentType(const fs::path& path) {
+            static const std::unordered_map<std::string_view, std::string_view> content_types{
+                {".htm"sv, "text/html"sv}, {".html"sv, "text/html"sv}, {".css"sv, "text/css"sv}
+                , {".txt"sv, "text/plain"sv}, {".js"sv, "text/javascript"sv}, {".json"sv, "application/json"sv}
+                , {".xml"sv, "application/xml"sv}, {".png"sv, "image/png"sv}, {".jpg"sv, "image/jpeg"sv}
+                , {".jpe"sv, "image/jpeg"sv}, {".jpeg"sv, "image/jpeg"sv}, {".gif"sv, "image/gif"sv}
+                , {".bmp"sv, "image/bmp"sv}, {".ico"sv, "image/vnd.microsoft.icon"sv}, {".tiff"sv, "image/tiff"sv}
+                , {".tif"sv, "image/tiff"sv}, {".svg"sv, "image/svg+xml"sv}, {".svgz"sv, "image/svg+xml"sv}
+                , {".mp3"sv, "audio/mpeg"sv}, {".gz"sv, "application/gzip"sv}
+            };
+
+            const auto it = content_types.find(ToLower(path.extension().string()));
+            return it != content_types.end() ? it->second : "application/octet-stream"sv;
+        }
+
+        // Время изменения в наносекундах: две записи файла за одну секунду с тем же размером
+        // дают разные ETag (на файловых системах с точностью до секунды остается только размер)
+        std::string MakeEtag(const AssetData& data) {
+            std::array<char, 48> buffer;
+            const int size = std::snprintf(buffer.data(), buffer.size(), "\"%llx-%llx\""
+                                        , static_cast<unsigned long long>(data.ModifiedTimeNs())
+                                        , static_cast<unsigned long long>(data.Size()));
+            return std::string(buffer.data(), static_cast<size_t>(size));
+        }
+
+        // Дата в формате HTTP: "Sun, 06 Nov 1994 08:49:37 GMT"
+        std::string MakeHttpDate(int64_t time) {
+            const std::time_t t = static_cast<std::time_t>(time);
+            std::tm tm{};
+            gmtime_r(&t, &tm);
+
+            std::array<char, 32> buffer;
+            const size_t size = std::strftime(buffer.data(), buffer.size(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+            return std::string(buffer.data(), size);
+        }
+
+        // Разбирает дату в формате HTTP, std::nullopt для некорректной даты
+        std::optional<int64_t> ParseHttpDate(std::string_view date) {
+            const std::string str(date);
+            std::tm tm{};
+            const char* end = strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+            if(end == nullptr || *end != '\0') {
+                return std::nullopt;
+            }
+
+            return static_cast<int64_t>(timegm(&tm));
+        }
+
+        // Отпечаток - часть имени из шестнадцатеричных цифр между '.', '-' или '_' ("game.3f9a1c2e.js")
+        bool IsFingerprinted(const fs::path& path) {
+            const std::string stem = path.stem().string();
+            size_t begin = 0;
+
+            while(begin <= stem.size()) {
+                size_t end = stem.find_first_of(".-_"sv, begin);
+                if(end == std::string::npos) {
+                    end = stem.size();
+                }
+
+                const std::string_view part = std::string_view{stem}.substr(begin, end - begin);
+                const bool hex = std::all_of(part.begin(), part.end(), [](char c) {
+                    return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+                });
+                const bool has_digit = std::any_of(part.begin(), part.end(), [](char c) {
+                    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+                });
+
+                if(part.size() >= MIN_FINGERPRINT_LENGTH && hex && has_digit) {
+                    return true;
+                }
+
+                begin = end + 1;
+            }
+
+            return false;
+        }
+
+        AssetRepresentation LoadVariant(const fs::path& path, std::string_view extension, uint64_t max_loaded_size) {
+            fs::path variant = path;
+            variant += extension;
+
+            std::error_code ec;
+            if(!fs::is_regular_file(variant, ec)) {
+                return {};
+            }
+
+            auto data = std::make_shared<const AssetData>(variant, max_loaded_size);
+            std::string etag = MakeEtag(*data);
+            return {std::move(data), std::move(etag)};
+        }
+
+        // Читает до size байт, возвращает число прочитанных (меньше size, если файл укоротили)
+        size_t ReadFile(int fd, char* data, size_t size) {
+            size_t offset = 0;
+            while(offset < size) {
+                const ssize_t count = ::read(fd, data + offset, size - offset);
+                if(count <= 0) {
+                    break;
+                }
+                offset += static_cast<size_t>(count);
+            }
+            return offset;
+        }
+
+        bool HasSuffix(std::string_view str, std::string_view suffix) {
+            return str.size() >= suffix.size() && str.substr(str.size() - suffix.size()) == suffix;
+        }
+
+        std::string_view Trim(std::string_view str) {
+            const auto begin = str.find_first_not_of(" \t"sv);
+            if(begin == std::string_view::npos) {
+                return {};
+            }
+            return str.substr(begin, str.find_last_not_of(" \t"sv) - begin + 1);
+        }
+
+        // Кодировки из Accept-Encoding, разрешенные клиентом (q=0 запрещает кодировку)
+        struct AcceptedEncodings {
+            bool brotli = false;
+            bool gzip = false;
+        };
+
+        AcceptedEncodings ParseAcceptEncoding(std::string_view header) {
+            AcceptedEncodings accepted;
+
+            while(!header.empty()) {
+                const auto comma = header.find(',');
+                std::string_view item = header.substr(0, comma);
+                header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+                const auto semicolon = item.find(';');
+                const std::string name = ToLower(Trim(item.substr(0, semicolon)));
+                if(semicolon != std::string_view::npos) {
+                    const std::string_view params = Trim(item.substr(semicolon + 1));
+                    if(params.starts_with("q=0"sv) && params.find_first_of("123456789"sv) == std::string_view::npos) {
+                        continue;
+                    }
+                }
+
+                if(name == "br"sv || name == "*"sv) {
+                    accepted.brotli = true;
+                }
+                if(name == "gzip"sv || name == "*"sv) {
+                    accepted.gzip = true;
+                }
+            }
+
+            return accepted;
+        }
+
+        // Значение ETag без признака слабого сравнения
+        std::string_view OpaqueTag(std::string_view etag) {
+            return etag.starts_with("W/"sv) ? etag.substr(2) : etag;
+        }
+
+        // If-None-Match: список ETag или "*", сравнение слабое
+        bool MatchesAnyEtag(std::string_view header, std::string_view etag) {
+            while(!header.empty()) {
+                const auto comma = header.find(',');
+                const std::string_view item = Trim(header.substr(0, comma));
+                header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+                if(item == "*"sv || OpaqueTag(item) == OpaqueTag(etag)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool IsNotModified(const AssetRequest& request, std::string_view etag, int64_t modified_time) {
+            // If-Modified-Since учитывается, только если клиент не прислал If-None-Match
+            if(!request.if_none_match.empty()) {
+                return MatchesAnyEtag(request.if_none_match, etag);
+            }
+
+            if(!request.if_modified_since.empty()) {
+                const auto since = ParseHttpDate(request.if_modified_since);
+                return since && modified_time <= *since;
+            }
+
+            return false;
+        }
+
+        // If-Range: диапазон отдается, только если у клиента та же версия файла (сравнение строгое)
+        bool IsRangeAllowed(const AssetRequest& request, std::string_view etag, int64_t modified_time) {
+            if(request.if_range.empty()) {
+                return true;
+            }
+
+            if(request.if_range.front() == '"') {
+                return request.if_range == etag;
+            }
+
+            const auto date = ParseHttpDate(request.if_range);
+            return date && modified_time == *date;
+        }
+
+        bool ParseNumber(std::string_view str, uint64_t& value) {
+            const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+            return ec == std::errc{} && ptr == str.data() + str.size();
+        }
+
+        enum class RangeResult {
+            FULL,           // заголовка нет, он некорректен или содержит несколько диапазонов - отдаем файл целиком
+            PARTIAL,
+            UNSATISFIABLE
+        };
+
+        // Разбирает единственный диапазон "bytes=first-last", "bytes=first-" или "bytes=-suffix"
+        RangeResult ParseRange(std::string_view header, uint64_t size, uint64_t& offset, uint64_t& length) {
+            if(!header.starts_with("bytes="sv)) {
+                return RangeResult::FULL;
+            }
+
+            const std::string_view spec = Trim(header.substr(6));
+            const auto dash = spec.find('-');
+            if(spec.find(',') != std::string_view::npos || dash == std::string_view::npos) {
+                return RangeResult::FULL;
+            }
+
+            const std::string_view first_str = Trim(spec.substr(0, dash));
+            const std::string_view last_str = Trim(spec.substr(dash + 1));
+            uint64_t first = 0;
+            uint64_t last = 0;
+
+            if(first_str.empty()) {
+                // Последние suffix байт файла
+                if(!ParseNumber(last_str, last)) {
+                    return RangeResult::FULL;
+                }
+                if(last == 0 || size == 0) {
+                    return RangeResult::UNSATISFIABLE;
+                }
+
+                length = std::min(last, size);
+                offset = size - length;
+                return RangeResult::PARTIAL;
+            }
+
+            if(!ParseNumber(first_str, first) || (!last_str.empty() && !ParseNumber(last_str, last))) {
+                return RangeResult::FULL;
+            }
+            if(!last_str.empty() && last < first) {
+                return RangeResult::FULL;
+            }
+            if(first >= size) {
+                return RangeResult::UNSATISFIABLE;
+            }
+
+            offset = first;
+            length = (last_str.empty() ? size - 1 : std::min(last, size - 1)) - first + 1;
+            return RangeResult::PARTIAL;
+        }
+
+    } // namespace
+
+    AssetData::AssetData(const fs::path& path, uint64_t max_loaded_size) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            throw std::runtime_error("Failed to open static file "s + path.string());
+        }
+
+        struct stat st{};
+        if(::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat static file "s + path.string());
+        }
+
+        size_ = static_cast<uint64_t>(st.st_size);
+        modified_time_ = static_cast<int64_t>(st.st_mtim.tv_sec);
+        modified_time_ns_ = modified_time_ * 1'000'000'000 + static_cast<int64_t>(st.st_mtim.tv_nsec);
+
+        if(size_ > max_loaded_size) {
+            mapping_size_ = static_cast<size_t>(size_);
+            mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(mapping_ == MAP_FAILED) {
+                mapping_ = nullptr;
+                ::close(fd);
+                throw std::runtime_error("Failed to allocate memory for static file "s + path.string());
+            }
+            // Файл укоротили во время чтения - отдаем прочитанное
+            size_ = ReadFile(fd, static_cast<char*>(mapping_), mapping_size_);
+            ::close(fd);
+            ::mprotect(mapping_, mapping_size_, PROT_READ);
+            data_ = static_cast<const char*>(mapping_);
+            return;
+        }
+
+        loaded_.resize(size_);
+        const size_t read = ReadFile(fd, loaded_.data(), loaded_.size());
+        ::close(fd);
+
+        // Файл укоротили во время чтения
+        loaded_.resize(read);
+        size_ = read;
+        data_ = loaded_.data();
+    }
+
+    AssetData::~AssetData() {
+        if(mapping_) {
+            ::munmap(mapping_, mapping_size_);
+        }
+    }
+
+    StaticAssetCache::StaticAssetCache(fs::path root, uint64_t max_loaded_size)
+        : root_(fs::weakly_canonical(root))
+        , max_loaded_size_(max_loaded_size) {
+        if(!fs::is_directory(root_)) {
+            throw std::invalid_argument("Static files root is not a directory: "s + root_.string());
+        }
+
+        inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(inotify_fd_ < 0) {
+            throw std::runtime_error("Failed to start watching static files"s);
+        }
+
+        // Наблюдение ставится до загрузки: изменение во время загрузки не потеряется
+        try {
+            AddWatch(root_);
+            LoadDirectory(root_);
+        } catch(...) {
+            ::close(inotify_fd_);
+            throw;
+        }
+
+        watcher_ = std::jthread([this](std::stop_token stop) {
+            Watch(stop);
+        });
+    }
+
+    StaticAssetCache::~StaticAssetCache() {
+        // Поток наблюдения останавливается до закрытия дескриптора inotify
+        watcher_.request_stop();
+        if(watcher_.joinable()) {
+            watcher_.join();
+        }
+
+        ::close(inotify_fd_);
+    }
+
+    StaticAssetPtr StaticAssetCache::Find(std::string_view target) const {
+        std::shared_lock lock(mtx_);
+
+        if(target.empty() || target.back() == '/') {
+            std::string key(target.empty() ? "/"sv : target);
+            key += "index.html"sv;
+            const auto it = assets_.find(key);
+            return it != assets_.end() ? it->second : nullptr;
+        }
+
+        const auto it = assets_.find(target);
+        return it != assets_.end() ? it->second : nullptr;
+    }
+
+    size_t StaticAssetCache::Size() const {
+        std::shared_lock lock(mtx_);
+        return assets_.size();
+    }
+
+    std::string StaticAssetCache::MakeKey(const fs::path& path) const {
+        return "/"s + path.lexically_relative(root_).generic_string();
+    }
+
+    void StaticAssetCache::LoadDirectory(const fs::path& dir) {
+        for(const auto& entry : fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied)) {
+            if(entry.is_directory()) {
+                AddWatch(entry.path());
+            } else if(entry.is_regular_file()) {
+                LoadFile(entry.path());
+            }
+        }
+    }
+
+    void StaticAssetCache::LoadFile(const fs::path& path) {
+        auto asset = std::make_shared<StaticAsset>();
+        asset->identity = LoadVariant(path, ""sv, max_loaded_size_);
+        if(!asset->identity.data) {
+            throw std::runtime_error("Static file is not a regular file "s + path.string());
+        }
+        asset->brotli = LoadVariant(path, ".br"sv, max_loaded_size_);
+        asset->gzip = LoadVariant(path, ".gz"sv, max_loaded_size_);
+        asset->content_type = GetContentType(path);
+        asset->modified_time = asset->identity.data->ModifiedTime();
+        asset->last_modified = MakeHttpDate(asset->modified_time);
+        asset->cache_control = IsFingerprinted(path) ? IMMUTABLE_CACHE_CONTROL : REVALIDATE_CACHE_CONTROL;
+
+        std::string key = MakeKey(path);
+        std::unique_lock lock(mtx_);
+        assets_.insert_or_assign(std::move(key), std::move(asset));
+    }
+
+    void StaticAssetCache::AddWatch(const fs::path& dir) {
+        const int wd = ::inotify_add_watch(inotify_fd_, dir.c_str(), WATCH_MASK);
+        if(wd < 0) {
+            throw std::runtime_error("Failed to watch static files directory "s + dir.string());
+        }
+
+        watched_dirs_.insert_or_assign(wd, dir);
+    }
+
+    void StaticAssetCache::Watch(std::stop_token stop) {
+        alignas(inotify_event) std::array<char, 64 * 1024> buffer;
+        pollfd pfd{inotify_fd_, POLLIN, 0};
+
+        while(!stop.stop_requested()) {
+            if(::poll(&pfd, 1, WATCH_POLL_TIMEOUT_MS) <= 0) {
+                continue;
+            }
+
+            const ssize_t length = ::read(inotify_fd_, buffer.data(), buffer.size());
+            if(length <= 0) {
+                continue;
+            }
+
+            for(ssize_t offset = 0; offset < length; ) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                // Часть событий потеряна - перечитываем каталог целиком
+                if(event->mask & IN_Q_OVERFLOW) {
+                    {
+                        std::unique_lock lock(mtx_);
+                        assets_.clear();
+                    }
+                    try {
+                        LoadDirectory(root_);
+                    } catch(const std::exception&) {
+                        // Недоступные файлы просто отсутствуют в кэше
+                    }
+                    continue;
+                }
+
+                if(event->mask & IN_IGNORED) {
+                    watched_dirs_.erase(event->wd);
+                    continue;
+                }
+
+                const auto dir = watched_dirs_.find(event->wd);
+                if(dir == watched_dirs_.end() || event->len == 0) {
+                    continue;
+                }
+
+                const fs::path path = dir->second / event->name;
+                if(event->mask & IN_ISDIR) {
+                    if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        OnChange(path);
+                    } else if(event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                        // Каталог убран - убираем все его файлы
+                        const std::string prefix = MakeKey(path) + "/"s;
+                        std::unique_lock lock(mtx_);
+                        std::erase_if(assets_, [&prefix](const auto& item) {
+                            return item.first.starts_with(prefix);
+                        });
+                    }
+                } else if(!(event->mask & IN_CREATE)) {
+                    // Созданный файл загружается после закрытия на запись (IN_CLOSE_WRITE)
+                    OnChange(path);
+                }
+            }
+        }
+    }
+
+    void StaticAssetCache::OnChange(const fs::path& path) {
+        std::error_code ec;
+
+        try {
+            if(fs::is_directory(path, ec)) {
+                AddWatch(path);
+                LoadDirectory(path);
+            } else if(fs::is_regular_file(path, ec)) {
+                LoadFile(path);
+            } else {
+                std::unique_lock lock(mtx_);
+                assets_.erase(MakeKey(path));
+            }
+        } catch(const std::exception&) {
+            // Файл удалили или он недоступен
+            std::unique_lock lock(mtx_);
+            assets_.erase(MakeKey(path));
+        }
+
+        // Изменился сжатый вариант - обновляем исходный файл, к которому он прикреплен
+        const std::string name = path.filename().string();
+        if(HasSuffix(name, ".br"sv) || HasSuffix(name, ".gz"sv)) {
+            const fs::path source = path.parent_path() / name.substr(0, name.size() - 3);
+            if(fs::is_regular_file(source, ec)) {
+                OnChange(source);
+            }
+        }
+    }
+
+    AssetResponse MakeAssetResponse(const StaticAsset& asset, const AssetRequest& request) {
+        // Выбираем представление: его ETag участвует во всех проверках ниже
+        const AssetRepresentation* representation = &asset.identity;
+        std::string_view content_encoding;
+        if(asset.brotli.data || asset.gzip.data) {
+            const auto accepted = ParseAcceptEncoding(request.accept_encoding);
+            if(asset.brotli.data && accepted.brotli) {
+                representation = &asset.brotli;
+                content_encoding = "br"sv;
+            } else if(asset.gzip.data && accepted.gzip) {
+                representation = &asset.gzip;
+                content_encoding = "gzip"sv;
+            }
+        }
+
+        const uint64_t size = representation->data->Size();
+        AssetResponse response(http::status::ok, request.http_version);
+        response.set(http::field::etag, representation->etag);
+        response.set(http::field::last_modified, asset.last_modified);
+        response.set(http::field::cache_control, asset.cache_control);
+        if(asset.brotli.data || asset.gzip.data) {
+            response.set(http::field::vary, "Accept-Encoding"sv);
+        }
+        response.keep_alive(request.keep_alive);
+
+        if(IsNotModified(request, representation->etag, asset.modified_time)) {
+            response.result(http::status::not_modified);
+            return response;
+        }
+
+        response.set(http::field::content_type, asset.content_type);
+        response.set(http::field::accept_ranges, "bytes"sv);
+        if(!content_encoding.empty()) {
+            response.set(http::field::content_encoding, content_encoding);
+        }
+
+        AssetSlice body{representation->data, 0, size};
+        if(!request.range.empty() && IsRangeAllowed(request, representation->etag, asset.modified_time)) {
+            switch(ParseRange(request.range, size, body.offset, body.length)) {
+            case RangeResult::PARTIAL:
+                response.result(http::status::partial_content);
+                response.set(http::field::content_range, "bytes "s + std::to_string(body.offset) + "-"s
+                                                        + std::to_string(body.offset + body.length - 1)
+                                                        + "/"s + std::to_string(size));
+                break;
+            case RangeResult::UNSATISFIABLE:
+                response.result(http::status::range_not_satisfiable);
+                response.set(http::field::content_range, "bytes */"s + std::to_string(size));
+                response.content_length(0);
+                return response;
+            case RangeResult::FULL:
+                body = {representation->data, 0, size};
+                break;
+            }
+        }
+
+        response.content_length(body.length);
+        // На HEAD отдаются только заголовки ответа на GET
+        if(request.head) {
+            body.length = 0;
+        }
+        response.body() = std::move(body);
+
+        return response;
+    }
+
+} // http_response
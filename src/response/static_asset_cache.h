@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+namespace http_response {
+
+    namespace fs = std::filesystem;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+
+    // Копия содержимого файла в памяти. Файлы не больше порога читаются в строку, файлы больше
+    // порога - в анонимное отображение, которое отдается системе сразу при освобождении.
+    // Файл на диске после чтения не используется, поэтому перезапись на месте не меняет уже
+    // отдаваемые байты (новое содержимое загрузится по событию inotify)
+    class AssetData {
+    public:
+        AssetData(const fs::path& path, uint64_t max_loaded_size);
+        ~AssetData();
+
+        AssetData(const AssetData&) = delete;
+        AssetData& operator=(const AssetData&) = delete;
+
+        const char* Data() const noexcept {
+            return data_;
+        }
+
+        uint64_t Size() const noexcept {
+            return size_;
+        }
+
+        // Время последнего изменения файла (секунды от эпохи)
+        int64_t ModifiedTime() const noexcept {
+            return modified_time_;
+        }
+
+        // Время последнего изменения файла с точностью файловой системы (наносекунды от эпохи)
+        int64_t ModifiedTimeNs() const noexcept {
+            return modified_time_ns_;
+        }
+
+        bool IsMapped() const noexcept {
+            return mapping_ != nullptr;
+        }
+
+    private:
+        std::string loaded_;
+        void* mapping_ = nullptr;
+        size_t mapping_size_ = 0;
+        const char* data_ = nullptr;
+        uint64_t size_ = 0;
+        int64_t modified_time_ = 0;
+        int64_t modified_time_ns_ = 0;
+    };
+
+    using AssetDataPtr = std::shared_ptr<const AssetData>;
+
+    // Представление файла: исходное или сжатое. У каждого представления свой ETag,
+    // поэтому проверка кэша и диапазоны относятся именно к отданным байтам
+    struct AssetRepresentation {
+        AssetDataPtr data;
+        std::string etag;
+    };
+
+    // Файл из кэша: содержимое, заранее вычисленные заголовки и сжатые варианты
+    // (лежащие рядом файлы <имя>.br и <имя>.gz)
+    struct StaticAsset {
+        AssetRepresentation identity;
+        AssetRepresentation brotli;
+        AssetRepresentation gzip;
+        std::string content_type;
+        std::string last_modified;
+        int64_t modified_time = 0;
+        // Файлы с отпечатком содержимого в имени кэшируются клиентом без проверки
+        std::string cache_control;
+    };
+
+    using StaticAssetPtr = std::shared_ptr<const StaticAsset>;
+
+    // Отдаваемая часть содержимого (весь файл или диапазон из Range)
+    struct AssetSlice {
+        AssetDataPtr data;
+        uint64_t offset = 0;
+        uint64_t length = 0;
+    };
+
+    // Тело ответа из кэша: буфер отдается в сокет как есть, без копирования в ответ.
+    // Ответ держит содержимое, поэтому замена файла в кэше не мешает уже идущей отправке
+    struct AssetBody {
+        using value_type = AssetSlice;
+
+        static uint64_t size(const value_type& body) noexcept {
+            return body.length;
+        }
+
+        class writer {
+        public:
+            using const_buffers_type = boost::asio::const_buffer;
+
+            template <bool isRequest, class Fields>
+            writer(const http::header<isRequest, Fields>&, const value_type& body) : body_(body) {
+            }
+
+            void init(beast::error_code& ec) {
+                ec = {};
+            }
+
+            boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+                ec = {};
+                if(!body_.data || body_.length == 0) {
+                    return boost::none;
+                }
+
+                return {{const_buffers_type{body_.data->Data() + body_.offset, static_cast<size_t>(body_.length)}, false}};
+            }
+
+        private:
+            const value_type& body_;
+        };
+    };
+
+    using AssetResponse = http::response<AssetBody>;
+
+    // Кэш статических файлов каталога --www-root. Все файлы загружаются при создании,
+    // изменения каталога отслеживаются через inotify в отдельном потоке
+    class StaticAssetCache {
+    public:
+        // Файлы больше порога читаются в анонимное отображение памяти
+        static constexpr uint64_t DEFAULT_MAX_LOADED_SIZE = 1024 * 1024;
+
+        explicit StaticAssetCache(fs::path root, uint64_t max_loaded_size = DEFAULT_MAX_LOADED_SIZE);
+        ~StaticAssetCache();
+
+        StaticAssetCache(const StaticAssetCache&) = delete;
+        StaticAssetCache& operator=(const StaticAssetCache&) = delete;
+
+        // Файл по пути запроса относительно корня ("/js/three.js"; путь на '/' - index.html каталога)
+        // или nullptr. Путь должен быть уже декодирован из URL
+        [[nodiscard]] StaticAssetPtr Find(std::string_view target) const;
+
+        size_t Size() const;
+
+    private:
+        struct StringHasher {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const noexcept {
+                return std::hash<std::string_view>{}(str);
+            }
+        };
+
+        std::string MakeKey(const fs::path& path) const;
+        void LoadDirectory(const fs::path& dir);
+        void LoadFile(const fs::path& path);
+        void AddWatch(const fs::path& dir);
+        void Watch(std::stop_token stop);
+        void OnChange(const fs::path& path);
+
+        fs::path root_;
+        uint64_t max_loaded_size_;
+
+        mutable std::shared_mutex mtx_;
+        std::unordered_map<std::string, StaticAssetPtr, StringHasher, std::equal_to<>> assets_;
+
+        int inotify_fd_ = -1;
+        // Каталог по дескриптору наблюдения inotify (только поток наблюдения)
+        std::unordered_map<int, fs::path> watched_dirs_;
+        std::jthread watcher_;
+    };
+
+    // Заголовки запроса, от которых зависит ответ с файлом из кэша
+    struct AssetRequest {
+        unsigned http_version = 11;
+        bool keep_alive = true;
+        bool head = false;
+        std::string_view accept_encoding;
+        std::string_view if_none_match;
+        std::string_view if_modified_since;
+        std::string_view range;
+        std::string_view if_range;
+    };
+
+    template <typename Body, typename Fields>
+    AssetRequest MakeAssetRequest(const http::request<Body, Fields>& request) {
+        return AssetRequest{request.version(), request.keep_alive(), request.method() == http::verb::head
+                            , request[http::field::accept_encoding], request[http::field::if_none_match]
+                            , request[http::field::if_modified_since], request[http::field::range]
+                            , request[http::field::if_range]};
+    }
+
+    // Ответ с файлом из кэша. Сжатый вариант выбирается по Accept-Encoding, затем проверяются
+    // If-None-Match и If-Modified-Since (304 Not Modified) и Range с If-Range
+    // (206 Partial Content или 416 Range Not Satisfiable; несколько диапазонов отдаются целым файлом)
+    [[nodiscard]] AssetResponse MakeAssetResponse(const StaticAsset& asset, const AssetRequest& request);
+
+} // http_response
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <boost/crc.hpp>
+
+namespace serialization {
+
+    using namespace std::literals;
+
+    // Формат рассчитан на 64-битный size_t: все размеры пишутся восемью байтами
+    static_assert(sizeof(size_t) == sizeof(uint64_t));
+
+    class SnapshotError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Наибольший размер блока секции: писатель держит в памяти только текущий блок
+    const size_t SNAPSHOT_CHUNK_SIZE = 1 << 20;
+
+    // Секции снимка пишутся потоком блоков: <длина u32><crc32 u32><данные>, конец секции - блок нулевой длины.
+    // Заголовок секции: <тег u32><число элементов u64>. Числа little-endian
+    class SnapshotWriter {
+    public:
+        // reserve - начальный размер буфера блока (для маленьких секций меньше SNAPSHOT_CHUNK_SIZE)
+        explicit SnapshotWriter(std::ostream& out, size_t reserve = SNAPSHOT_CHUNK_SIZE)
+            : out_{out} {
+            chunk_.reserve(std::min(reserve, SNAPSHOT_CHUNK_SIZE));
+        }
+
+        void WriteRaw(const void* data, size_t size) {
+            out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        }
+
+        void BeginSection(uint32_t tag, uint64_t count) {
+            std::array<char, sizeof(tag) + sizeof(count)> header;
+            StoreLittleEndian(header.data(), tag, sizeof(tag));
+            StoreLittleEndian(header.data() + sizeof(tag), count, sizeof(count));
+            WriteRaw(header.data(), header.size());
+        }
+
+        void Write(const void* data, size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+
+            while(size > 0) {
+                const size_t part = std::min(size, SNAPSHOT_CHUNK_SIZE - chunk_.size());
+                chunk_.insert(chunk_.end(), bytes, bytes + part);
+                bytes += part;
+                size -= part;
+
+                if(chunk_.size() == SNAPSHOT_CHUNK_SIZE) {
+                    FlushChunk();
+                }
+            }
+        }
+
+        void EndSection() {
+            FlushChunk();
+            // Блок нулевой длины
+            FlushChunk();
+
+            if(!out_) {
+                throw SnapshotError("Failed to write snapshot"s);
+            }
+        }
+
+        static void StoreLittleEndian(char* out, uint64_t value, size_t size) {
+            for(size_t i = 0; i < size; ++i) {
+                out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+            }
+        }
+
+    private:
+        void FlushChunk() {
+            boost::crc_32_type crc;
+            crc.process_bytes(chunk_.data(), chunk_.size());
+
+            std::array<char, 2 * sizeof(uint32_t)> header;
+            StoreLittleEndian(header.data(), chunk_.size(), sizeof(uint32_t));
+            StoreLittleEndian(header.data() + sizeof(uint32_t), crc.checksum(), sizeof(uint32_t));
+            WriteRaw(header.data(), header.size());
+            WriteRaw(chunk_.data(), chunk_.size());
+            chunk_.clear();
+        }
+
+        std::ostream& out_;
+        std::vector<char> chunk_;
+    };
+
+    // Читает секции, записанные SnapshotWriter, проверяя контрольную сумму каждого блока
+    class SnapshotReader {
+    public:
+        explicit SnapshotReader(std::istream& in)
+            : in_{in} {
+        }
+
+        void ReadRaw(void* data, size_t size) {
+            if(!in_.read(static_cast<char*>(data), static_cast<std::streamsize>(size))) {
+                throw SnapshotError("Unexpected end of snapshot"s);
+            }
+        }
+
+        // Возвращает число элементов секции
+        uint64_t BeginSection(uint32_t expected_tag) {
+            std::array<char, sizeof(uint32_t) + sizeof(uint64_t)> header;
+            ReadRaw(header.data(), header.size());
+
+            if(LoadLittleEndian(header.data(), sizeof(uint32_t)) != expected_tag) {
+                throw SnapshotError("Unexpected snapshot section"s);
+            }
+
+            chunk_.clear();
+            pos_ = 0;
+            section_end_ = false;
+            return LoadLittleEndian(header.data() + sizeof(uint32_t), sizeof(uint64_t));
+        }
+
+        void Read(void* data, size_t size) {
+            char* bytes = static_cast<char*>(data);
+
+            while(size > 0) {
+                if(pos_ == chunk_.size()) {
+                    LoadChunk();
+                    if(section_end_) {
+                        throw SnapshotError("Snapshot section is shorter than expected"s);
+                    }
+                }
+
+                const size_t part = std::min(size, chunk_.size() - pos_);
+                std::memcpy(bytes, chunk_.data() + pos_, part);
+                pos_ += part;
+                bytes += part;
+                size -= part;
+            }
+        }
+
+        void EndSection() {
+            if(pos_ != chunk_.size()) {
+                throw SnapshotError("Snapshot section is longer than expected"s);
+            }
+
+            if(!section_end_) {
+                LoadChunk();
+            }
+
+            if(!section_end_) {
+                throw SnapshotError("Snapshot section is longer than expected"s);
+            }
+        }
+
+        static uint64_t LoadLittleEndian(const char* data, size_t size) {
+            uint64_t value = 0;
+
+            for(size_t i = 0; i < size; ++i) {
+                value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+            }
+
+            return value;
+        }
+
+    private:
+        void LoadChunk() {
+            std::array<char, 2 * sizeof(uint32_t)> header;
+            ReadRaw(header.data(), header.size());
+
+            const size_t size = LoadLittleEndian(header.data(), sizeof(uint32_t));
+            const auto expected_crc = static_cast<uint32_t>(LoadLittleEndian(header.data() + sizeof(uint32_t), sizeof(uint32_t)));
+
+            if(size > SNAPSHOT_CHUNK_SIZE) {
+                throw SnapshotError("Snapshot chunk is too large"s);
+            }
+
+            chunk_.resize(size);
+            ReadRaw(chunk_.data(), size);
+            pos_ = 0;
+
+            boost::crc_32_type crc;
+            crc.process_bytes(chunk_.data(), chunk_.size());
+            if(crc.checksum() != expected_crc) {
+                throw SnapshotError("Snapshot checksum mismatch"s);
+            }
+
+            section_end_ = size == 0;
+        }
+
+        std::istream& in_;
+        std::vector<char> chunk_;
+        size_t pos_ = 0;
+        bool section_end_ = false;
+    };
+
+    namespace detail {
+
+        template <typename T>
+        struct IsSequence : std::false_type {};
+        template <typename T, typename A>
+        struct IsSequence<std::vector<T, A>> : std::true_type {};
+        template <typename T, typename A>
+        struct IsSequence<std::deque<T, A>> : std::true_type {};
+
+        template <typename T>
+        struct IsAssociative : std::false_type {};
+        template <typename K, typename V, typename H, typename E, typename A>
+        struct IsAssociative<std::unordered_map<K, V, H, E, A>> : std::true_type {};
+        template <typename K, typename H, typename E, typename A>
+        struct IsAssociative<std::unordered_set<K, H, E, A>> : std::true_type {};
+
+        template <typename T>
+        struct IsPair : std::false_type {};
+        template <typename F, typename S>
+        struct IsPair<std::pair<F, S>> : std::true_type {};
+
+        // Числа с плавающей точкой хранятся своим двоичным представлением
+        template <typename T>
+        auto ToBits(T value) {
+            if constexpr (std::is_same_v<T, double>) {
+                return std::bit_cast<uint64_t>(value);
+            } else if constexpr (std::is_same_v<T, float>) {
+                return std::bit_cast<uint32_t>(value);
+            } else if constexpr (std::is_enum_v<T>) {
+                return static_cast<std::make_unsigned_t<std::underlying_type_t<T>>>(value);
+            } else {
+                return static_cast<std::make_unsigned_t<T>>(value);
+            }
+        }
+
+    } // namespace detail
+
+    // Двоичный архив с интерфейсом архивов boost (ar & value), поэтому подходят те же функции
+    // serialize, что и для текстового архива. Числа пишутся фиксированной ширины little-endian,
+    // строки и контейнеры - с префиксом длины. Перечисления пишутся своим значением
+    class BinaryOArchive {
+    public:
+        using is_saving = std::true_type;
+        using is_loading = std::false_type;
+
+        explicit BinaryOArchive(SnapshotWriter& writer)
+            : writer_{writer} {
+        }
+
+        template <typename T>
+        BinaryOArchive& operator&(const T& value) {
+            Save(value);
+            return *this;
+        }
+
+        template <typename T>
+        BinaryOArchive& operator<<(const T& value) {
+            Save(value);
+            return *this;
+        }
+
+    private:
+        template <typename T>
+        void Save(const T& value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                const char byte = value ? 1 : 0;
+                writer_.Write(&byte, 1);
+            } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+                const auto bits = detail::ToBits(value);
+                std::array<char, sizeof(bits)> bytes;
+                SnapshotWriter::StoreLittleEndian(bytes.data(), bits, sizeof(bits));
+                writer_.Write(bytes.data(), bytes.size());
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                Save(static_cast<uint32_t>(value.size()));
+                writer_.Write(value.data(), value.size());
+            } else if constexpr (detail::IsPair<T>::value) {
+                Save(value.first);
+                Save(value.second);
+            } else if constexpr (detail::IsSequence<T>::value || detail::IsAssociative<T>::value) {
+                Save(static_cast<uint64_t>(value.size()));
+                for(const auto& item : value) {
+                    Save(item);
+                }
+            } else if constexpr (requires(T& t, BinaryOArchive& ar) { t.serialize(ar, 0u); }) {
+                // Функции serialize boost не константны, хотя при сохранении объект не меняют
+                const_cast<T&>(value).serialize(*this, 0u);
+            } else {
+                serialize(*this, const_cast<T&>(value), 0u);
+            }
+        }
+
+        SnapshotWriter& writer_;
+    };
+
+    class BinaryIArchive {
+    public:
+        using is_saving = std::false_type;
+        using is_loading = std::true_type;
+
+        explicit BinaryIArchive(SnapshotReader& reader)
+            : reader_{reader} {
+        }
+
+        template <typename T>
+        BinaryIArchive& operator&(T& value) {
+            Load(value);
+            return *this;
+        }
+
+        template <typename T>
+        BinaryIArchive& operator>>(T& value) {
+            Load(value);
+            return *this;
+        }
+
+    private:
+        template <typename T>
+        void Load(T& value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                char byte = 0;
+                reader_.Read(&byte, 1);
+                value = byte != 0;
+            } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+                using Bits = decltype(detail::ToBits(value));
+                std::array<char, sizeof(Bits)> bytes;
+                reader_.Read(bytes.data(), bytes.size());
+                const auto bits = static_cast<Bits>(SnapshotReader::LoadLittleEndian(bytes.data(), bytes.size()));
+
+                if constexpr (std::is_floating_point_v<T>) {
+                    value = std::bit_cast<T>(bits);
+                } else {
+                    value = static_cast<T>(bits);
+                }
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                uint32_t size = 0;
+                Load(size);
+                value.resize(size);
+                reader_.Read(value.data(), size);
+            } else if constexpr (detail::IsPair<T>::value) {
+                Load(const_cast<std::remove_const_t<typename T::first_type>&>(value.first));
+                Load(value.second);
+            } else if constexpr (detail::IsSequence<T>::value) {
+                uint64_t size = 0;
+                Load(size);
+                value.clear();
+                value.resize(size);
+                for(auto& item : value) {
+                    Load(item);
+                }
+            } else if constexpr (detail::IsAssociative<T>::value) {
+                uint64_t size = 0;
+                Load(size);
+                value.clear();
+                value.reserve(size);
+                for(uint64_t i = 0; i < size; ++i) {
+                    std::remove_const_t<typename T::key_type> key{};
+                    if constexpr (requires { typename T::mapped_type; }) {
+                        typename T::mapped_type mapped{};
+                        Load(key);
+                        Load(mapped);
+                        value.emplace(std::move(key), std::move(mapped));
+                    } else {
+                        Load(key);
+                        value.emplace(std::move(key));
+                    }
+                }
+            } else if constexpr (requires(T& t, BinaryIArchive& ar) { t.serialize(ar, 0u); }) {
+                value.serialize(*this, 0u);
+            } else {
+                serialize(*this, value, 0u);
+            }
+        }
+
+        SnapshotReader& reader_;
+    };
+
+} // namespace serialization
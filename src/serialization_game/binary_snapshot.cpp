@@ -0,0 +1,284 @@
+#include "binary_snapshot.h"
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <latch>
+#include <memory>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+namespace serialization {
+
+    namespace {
+
+        void WriteHeader(SnapshotWriter& writer) {
+            std::array<char, sizeof(SNAPSHOT_VERSION)> version;
+            SnapshotWriter::StoreLittleEndian(version.data(), SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION));
+            writer.WriteRaw(SNAPSHOT_MAGIC.data(), SNAPSHOT_MAGIC.size());
+            writer.WriteRaw(version.data(), version.size());
+        }
+
+        // Возвращает версию формата снимка
+        uint32_t ReadHeader(SnapshotReader& reader) {
+            std::string magic(SNAPSHOT_MAGIC.size(), '\0');
+            std::array<char, sizeof(SNAPSHOT_VERSION)> version;
+            reader.ReadRaw(magic.data(), magic.size());
+            reader.ReadRaw(version.data(), version.size());
+
+            if(magic != SNAPSHOT_MAGIC) {
+                throw SnapshotError("Not a game state snapshot"s);
+            }
+
+            const auto format_version = static_cast<uint32_t>(SnapshotReader::LoadLittleEndian(version.data(), version.size()));
+            if(format_version == 0 || format_version > SNAPSHOT_VERSION) {
+                throw SnapshotError("Unsupported game state snapshot version"s);
+            }
+
+            return format_version;
+        }
+
+        // Секция из всех элементов range, каждый пишется представлением to_repr(item)
+        template <typename Range, typename ToRepr>
+        void WriteSection(SnapshotWriter& writer, BinaryOArchive& ar, SnapshotSection tag
+                        , const Range& range, ToRepr&& to_repr) {
+            writer.BeginSection(tag, range.size());
+            for(const auto& item : range) {
+                ar << to_repr(item);
+            }
+            writer.EndSection();
+        }
+
+        void WriteManagerSection(SnapshotWriter& writer, BinaryOArchive& ar
+                                , uint64_t id_session, uint64_t dog_id, uint64_t journal_seq) {
+            writer.BeginSection(MANAGER_SECTION, 1);
+            ar << id_session << dog_id << journal_seq;
+            writer.EndSection();
+        }
+
+        void WriteFooter(std::ostream& out, SnapshotWriter& writer) {
+            // Пустая последняя секция отличает полный снимок от оборванного
+            writer.BeginSection(END_SECTION, 0);
+            writer.EndSection();
+            out.flush();
+
+            if(!out) {
+                throw SnapshotError("Failed to write snapshot"s);
+            }
+        }
+
+        std::pair<uint64_t, GameSessionRepr> MakeSessionRepr(const app::AllGameSessionsList::value_type& item) {
+            return {static_cast<uint64_t>(item.first), GameSessionRepr{*item.second}};
+        }
+
+        SessionKeyRepr MakeSessionKeyRepr(const app::GameSessionsType::value_type& item) {
+            const auto& [key, session] = item;
+            return {static_cast<uint64_t>(key.first), *key.second, session->GetGameSessionId()};
+        }
+
+        PlayerRepr MakePlayerRepr(const app::PlayerPtr& player) {
+            return PlayerRepr{*player};
+        }
+
+        using SessionPtr = std::shared_ptr<model::GameSession>;
+
+        void RestoreSessionsChunk(const GameStateCapture& state, const model::Game& game, size_t begin, size_t end
+                                , std::vector<SessionPtr>& sessions, std::exception_ptr& error) noexcept {
+            try {
+                for(size_t i = begin; i < end; ++i) {
+                    sessions[i] = std::make_shared<model::GameSession>(state.sessions[i].second.Restore(game));
+                }
+            } catch(...) {
+                error = std::current_exception();
+            }
+        }
+
+        // Сессии не зависят друг от друга: их части восстанавливаются в пуле потоков,
+        // первую часть восстанавливает вызывающий поток
+        std::vector<SessionPtr> RestoreSessions(const GameStateCapture& state, const model::Game& game
+                                                , size_t threads_count) {
+            const size_t sessions_count = state.sessions.size();
+            const size_t chunks_count = std::min(std::max<size_t>(threads_count, 1), sessions_count);
+            std::vector<SessionPtr> sessions(sessions_count);
+            std::vector<std::exception_ptr> errors(std::max<size_t>(chunks_count, 1));
+
+            if(chunks_count <= 1) {
+                RestoreSessionsChunk(state, game, 0, sessions_count, sessions, errors[0]);
+            } else {
+                const size_t chunk_size = (sessions_count + chunks_count - 1) / chunks_count;
+                boost::asio::thread_pool pool{chunks_count - 1};
+                std::latch done{static_cast<std::ptrdiff_t>(chunks_count - 1)};
+
+                for(size_t c = 1; c < chunks_count; ++c) {
+                    const size_t begin = std::min(c * chunk_size, sessions_count);
+                    const size_t end = std::min(begin + chunk_size, sessions_count);
+
+                    boost::asio::post(pool, [&, begin, end, c] {
+                        RestoreSessionsChunk(state, game, begin, end, sessions, errors[c]);
+                        done.count_down();
+                    });
+                }
+
+                RestoreSessionsChunk(state, game, 0, std::min(chunk_size, sessions_count), sessions, errors[0]);
+                done.wait();
+                pool.join();
+            }
+
+            for(const auto& error : errors) {
+                if(error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+            return sessions;
+        }
+
+    } // namespace
+
+    GameStateCapture CaptureState(const app::GameManager& manager) {
+        GameStateCapture state;
+        state.id_session = manager.GetCurrentValueSessionId();
+        state.dog_id = manager.GetDogId();
+
+        const auto& all_sessions = manager.GetAllSessions();
+        state.sessions.reserve(all_sessions.size());
+        for(const auto& item : all_sessions) {
+            state.sessions.push_back(MakeSessionRepr(item));
+        }
+
+        state.session_keys = CaptureSessionKeys(manager);
+
+        const auto& players = manager.GetPlayers();
+        state.players.reserve(players.size());
+        for(const auto& player : players) {
+            state.players.push_back(MakePlayerRepr(player));
+        }
+
+        return state;
+    }
+
+    std::vector<SessionKeyRepr> CaptureSessionKeys(const app::GameManager& manager) {
+        const auto& game_sessions = manager.GetGameSessions();
+        std::vector<SessionKeyRepr> keys;
+        keys.reserve(game_sessions.size());
+        for(const auto& item : game_sessions) {
+            keys.push_back(MakeSessionKeyRepr(item));
+        }
+
+        return keys;
+    }
+
+    void WriteSnapshot(std::ostream& out, const app::GameManager& manager) {
+        SnapshotWriter writer{out};
+        BinaryOArchive ar{writer};
+        WriteHeader(writer);
+
+        WriteManagerSection(writer, ar, manager.GetCurrentValueSessionId(), manager.GetDogId(), 0);
+        WriteSection(writer, ar, SESSIONS_SECTION, manager.GetAllSessions(), MakeSessionRepr);
+        WriteSection(writer, ar, SESSION_KEYS_SECTION, manager.GetGameSessions(), MakeSessionKeyRepr);
+        WriteSection(writer, ar, PLAYERS_SECTION, manager.GetPlayers(), MakePlayerRepr);
+        WriteFooter(out, writer);
+    }
+
+    void WriteSnapshot(std::ostream& out, const GameStateCapture& state) {
+        SnapshotWriter writer{out};
+        BinaryOArchive ar{writer};
+        WriteHeader(writer);
+
+        const auto same = [](const auto& repr) -> const auto& { return repr; };
+        WriteManagerSection(writer, ar, state.id_session, state.dog_id, state.journal_seq);
+        WriteSection(writer, ar, SESSIONS_SECTION, state.sessions, same);
+        WriteSection(writer, ar, SESSION_KEYS_SECTION, state.session_keys, same);
+        WriteSection(writer, ar, PLAYERS_SECTION, state.players, same);
+        WriteFooter(out, writer);
+    }
+
+    GameStateCapture ReadState(std::istream& in) {
+        SnapshotReader reader{in};
+        BinaryIArchive ar{reader};
+        const uint32_t format_version = ReadHeader(reader);
+        GameStateCapture state;
+
+        reader.BeginSection(MANAGER_SECTION);
+        ar >> state.id_session >> state.dog_id;
+        if(format_version >= 2) {
+            ar >> state.journal_seq;
+        }
+        reader.EndSection();
+
+        state.sessions.resize(reader.BeginSection(SESSIONS_SECTION));
+        for(auto& [id, session] : state.sessions) {
+            ar >> id >> session;
+        }
+        reader.EndSection();
+
+        state.session_keys.resize(reader.BeginSection(SESSION_KEYS_SECTION));
+        for(auto& key : state.session_keys) {
+            ar >> key;
+        }
+        reader.EndSection();
+
+        state.players.resize(reader.BeginSection(PLAYERS_SECTION));
+        for(auto& player : state.players) {
+            ar >> player;
+        }
+        reader.EndSection();
+
+        reader.BeginSection(END_SECTION);
+        reader.EndSection();
+
+        return state;
+    }
+
+    app::GameManager RestoreState(const GameStateCapture& state, const model::Game& game, size_t threads_count) {
+        app::GameManager manager{game};
+        manager.SetDogId(state.dog_id);
+        manager.Reserve(state.session_keys.size(), state.players.size());
+
+        // Сессии восстанавливаются до игроков: игроки ссылаются на сессии и псов в них
+        auto restored = RestoreSessions(state, game, threads_count);
+        app::AllGameSessionsList sessions;
+        sessions.reserve(restored.size());
+        for(size_t i = 0; i < restored.size(); ++i) {
+            sessions.emplace(state.sessions[i].first, std::move(restored[i]));
+        }
+
+        for(const auto& key : state.session_keys) {
+            auto session = sessions.find(key.session_id);
+            if(session == sessions.end()) {
+                throw SnapshotError("Session with ID "s + std::to_string(key.session_id) + " not found"s);
+            }
+
+            manager.AddGameSessionInMaps({static_cast<app::SessionStatus>(key.session_status), model::Map::Id{key.map_id}}
+                                        , session->first, session->second);
+        }
+
+        const auto& restored_sessions = manager.GetAllSessions();
+        for(const auto& player : state.players) {
+            app::PlayerPtr player_rest = std::make_shared<domain::Player>(player.Restore(restored_sessions));
+            manager.AddPlayerInPlayerList(player_rest);
+            manager.AddTokenIndex(player_rest->GetToken(), player_rest);
+            manager.AddDogMapIndexList(std::make_pair(player_rest->GetDogId(), app::Stoi(*player_rest->GetMapId()))
+                                    , player_rest);
+            manager.AddListPlayerInSessionList(player_rest->GetCurrentSession()->GetGameSessionId(), player_rest);
+        }
+
+        return manager;
+    }
+
+    app::GameManager ReadSnapshot(std::istream& in, const model::Game& game, size_t threads_count) {
+        return RestoreState(ReadState(in), game, threads_count);
+    }
+
+    bool IsBinarySnapshot(std::istream& in) {
+        const auto start = in.tellg();
+        std::string magic(SNAPSHOT_MAGIC.size(), '\0');
+        const bool has_magic = in.read(magic.data(), static_cast<std::streamsize>(magic.size())) && magic == SNAPSHOT_MAGIC;
+
+        in.clear();
+        in.seekg(start);
+        return has_magic;
+    }
+
+} // namespace serialization
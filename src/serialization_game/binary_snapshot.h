@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../application/game_manager.h"
+#include "binary_archive.h"
+#include "game_session_serialization.h"
+#include "player_serialization.h"
+
+namespace serialization {
+
+    // Первые байты файла двоичного снимка и версия формата.
+    // Версия 2 добавила в MANAGER_SECTION номер последней записи журнала, вошедшей в снимок
+    const std::string SNAPSHOT_MAGIC = "DOGSNAP"s;
+    const uint32_t SNAPSHOT_VERSION = 2;
+
+    // Теги секций снимка в порядке записи
+    enum SnapshotSection : uint32_t {
+        MANAGER_SECTION = 1,
+        SESSIONS_SECTION = 2,
+        SESSION_KEYS_SECTION = 3,
+        PLAYERS_SECTION = 4,
+        // Запись журнала изменений (state_journal.h)
+        JOURNAL_RECORD_SECTION = 5,
+        END_SECTION = 0xFFFF'FFFF
+    };
+
+    // Сессия из карты сессий по типу: ключ и id сессии из основного набора
+    struct SessionKeyRepr {
+        uint64_t session_status = 0;
+        std::string map_id;
+        uint64_t session_id = 0;
+
+        template <typename Archive>
+        void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
+            ar& session_status;
+            ar& map_id;
+            ar& session_id;
+        }
+    };
+
+    // Копия состояния GameManager из представлений объектов. Снимается за один проход без кодирования
+    // и ввода-вывода, поэтому ее можно взять на strand, а записать в файл в другом потоке
+    struct GameStateCapture {
+        uint64_t id_session = 0;
+        uint64_t dog_id = 0;
+        // Номер последней записи журнала, изменения которой уже есть в копии
+        uint64_t journal_seq = 0;
+        std::vector<std::pair<uint64_t, GameSessionRepr>> sessions;
+        std::vector<SessionKeyRepr> session_keys;
+        std::vector<PlayerRepr> players;
+    };
+
+    [[nodiscard]] GameStateCapture CaptureState(const app::GameManager& manager);
+
+    [[nodiscard]] std::vector<SessionKeyRepr> CaptureSessionKeys(const app::GameManager& manager);
+
+    // Двоичный снимок состояния GameManager. Писатель проходит по живому состоянию и пишет
+    // представление каждого объекта сразу в поток, не собирая копию всего GameManager.
+    // Сессии из карты сессий по типу хранятся только ключом и id (сами сессии лежат в SESSIONS_SECTION)
+    void WriteSnapshot(std::ostream& out, const app::GameManager& manager);
+
+    // Тот же формат из заранее снятой копии состояния
+    void WriteSnapshot(std::ostream& out, const GameStateCapture& state);
+
+    // Читает снимок в копию состояния (к ней еще можно применить журнал)
+    [[nodiscard]] GameStateCapture ReadState(std::istream& in);
+
+    // Восстанавливает сессии (при threads_count > 1 - параллельно), затем за один проход по игрокам
+    // заполняет все индексы, заранее выделив в них место
+    [[nodiscard]] app::GameManager RestoreState(const GameStateCapture& state, const model::Game& game
+                                                , size_t threads_count = 1);
+
+    [[nodiscard]] app::GameManager ReadSnapshot(std::istream& in, const model::Game& game, size_t threads_count = 1);
+
+    // Проверяем по первым байтам, что поток содержит двоичный снимок (позиция потока не меняется)
+    bool IsBinarySnapshot(std::istream& in);
+
+} // namespace serialization
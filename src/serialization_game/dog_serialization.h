@@ -29,6 +29,10 @@ namespace serialization {
         // Восстанавливаем данные пса
         [[nodiscard]] model::Dog Restore() const;
 
+        uint64_t GetId() const noexcept {
+            return id_;
+        }
+
         template <typename Archive>
         void serialize(Archive& ar, [[maybe_unused]] const unsigned version);
 
@@ -6,6 +6,7 @@ namespace serialization {
         // Создаем объект GameManager
         app::GameManager manager_rest(game);
         manager_rest.SetDogId(dog_id_);
+        manager_rest.Reserve(all_sessions_list_.size(), players_.size());
         try {
         // Сначала восстанавливаем сессии
         RestoreMapsSessions(manager_rest, game);
@@ -21,6 +22,7 @@ namespace serialization {
     void GameManagerRepr::RestoreMapsSessions(app::GameManager &manager, const model::Game &game) const {
         // Восстанавливаем основную карту с сессиями
         app::AllGameSessionsList all_sessions_list;
+        all_sessions_list.reserve(all_sessions_list_.size());
         for(const auto& [key, session] : all_sessions_list_) {
             
             all_sessions_list.emplace(key, std::make_shared<model::GameSession>(session.Restore(game)));
@@ -28,9 +30,8 @@ namespace serialization {
 
         // Восстанавливаем карты с сессиями GameManager
         for(const auto& [key, session] : game_session_) {
-            // Получаем восстановлеваемую сессию
-            auto game_session = session.Restore(game);
-            auto game_session_rest = all_sessions_list.find(game_session.GetGameSessionId());
+            // Сессия уже восстановлена в основной карте - находим ее по id
+            auto game_session_rest = all_sessions_list.find(session.GetSessionId());
 
             if(game_session_rest == all_sessions_list.end()){
                 throw std::runtime_error("Session with ID "s + std::to_string(id_session_) + " not found"s 
@@ -50,6 +50,19 @@ namespace serialization {
             return id_map_;
         }
 
+        size_t GetSessionId() const noexcept {
+            return id_session_;
+        }
+
+        // Заменяем (или добавляем) пса при применении журнала изменений
+        void SetDog(const DogRepr& dog) {
+            dogs_list_.insert_or_assign(dog.GetId(), dog);
+        }
+
+        void RemoveDog(size_t dog_id) {
+            dogs_list_.erase(dog_id);
+        }
+
     private:
     model::DogsList GetRestoreDogsList() const;
     model::LostObjectType GetRestoreLostObjectsList() const;
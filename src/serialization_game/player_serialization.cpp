@@ -11,8 +11,8 @@ namespace serialization {
             throw std::runtime_error("Session is null during player restoration. \nRecovery is not possible!");
         }
 
-        // Получаем список псов в сессии
-        auto dog_list = it_session->second->GetDogsList();
+        // Получаем список псов в сессии (без копирования: игроков в сессии может быть много)
+        const auto& dog_list = it_session->second->GetDogsList();
         // Получаем итератор на нужного пса
         auto it_dog = dog_list.find(dog_id_);
 
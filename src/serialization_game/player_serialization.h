@@ -26,6 +26,10 @@ namespace serialization {
         template <typename Archive>
         void serialize(Archive& ar, [[maybe_unused]] const unsigned version);
 
+        const std::string& GetToken() const noexcept {
+            return token_;
+        }
+
     private:
         size_t dog_id_;
         size_t session_id_;
@@ -0,0 +1,461 @@
+#include "state_journal.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+
+namespace serialization {
+
+    namespace {
+
+        // Начальный буфер записи журнала: за тик обычно меняется немного объектов
+        const size_t JOURNAL_RECORD_RESERVE = 4 * 1024;
+
+        // Изменение из прочитанной записи журнала
+        struct JournalChange {
+            JournalOp op = JournalOp::END;
+            uint64_t session_id = 0;
+            uint64_t dog_id = 0;
+            GameSessionRepr session;
+            DogRepr dog;
+            PlayerRepr player;
+            std::string token;
+            std::vector<SessionKeyRepr> keys;
+        };
+
+        struct ParsedRecord {
+            uint64_t seq = 0;
+            uint64_t id_session = 0;
+            uint64_t dog_id = 0;
+            std::vector<JournalChange> changes;
+        };
+
+        std::string JournalHeader() {
+            std::array<char, sizeof(JOURNAL_VERSION)> version;
+            SnapshotWriter::StoreLittleEndian(version.data(), JOURNAL_VERSION, sizeof(JOURNAL_VERSION));
+            return JOURNAL_MAGIC + std::string{version.data(), version.size()};
+        }
+
+        void WriteAll(int fd, const std::string& data, const fs::path& path) {
+            const char* bytes = data.data();
+            size_t size = data.size();
+
+            while(size > 0) {
+                const ssize_t written = ::write(fd, bytes, size);
+                if(written < 0) {
+                    if(errno == EINTR) {
+                        continue;
+                    }
+                    throw SnapshotError("Failed to write journal "s + path.string());
+                }
+
+                bytes += written;
+                size -= static_cast<size_t>(written);
+            }
+        }
+
+        // Запись читается целиком до применения: оборванная запись не должна изменить состояние
+        ParsedRecord ReadRecord(SnapshotReader& reader, BinaryIArchive& ar) {
+            ParsedRecord record;
+            reader.BeginSection(JOURNAL_RECORD_SECTION);
+            ar >> record.seq >> record.id_session >> record.dog_id;
+
+            while(true) {
+                JournalChange change;
+                ar >> change.op;
+
+                switch(change.op) {
+                    case JournalOp::END:
+                        reader.EndSection();
+                        return record;
+                    case JournalOp::SESSION:
+                        ar >> change.session_id >> change.session;
+                        break;
+                    case JournalOp::DOG:
+                        ar >> change.session_id >> change.dog;
+                        break;
+                    case JournalOp::DOG_REMOVE:
+                        ar >> change.session_id >> change.dog_id;
+                        break;
+                    case JournalOp::PLAYER:
+                        ar >> change.player;
+                        break;
+                    case JournalOp::PLAYER_REMOVE:
+                        ar >> change.token;
+                        break;
+                    case JournalOp::SESSION_KEYS:
+                        ar >> change.keys;
+                        break;
+                    default:
+                        throw SnapshotError("Unknown journal change"s);
+                }
+
+                record.changes.push_back(std::move(change));
+            }
+        }
+
+        // Применяет записи журнала к копии состояния, находя сессии и игроков по индексам
+        class JournalApplier {
+        public:
+            explicit JournalApplier(GameStateCapture& state)
+                : state_{state} {
+                for(size_t i = 0; i < state_.sessions.size(); ++i) {
+                    sessions_.emplace(state_.sessions[i].first, i);
+                }
+
+                for(size_t i = 0; i < state_.players.size(); ++i) {
+                    players_.emplace(state_.players[i].GetToken(), i);
+                }
+            }
+
+            void Apply(ParsedRecord& record) {
+                for(auto& change : record.changes) {
+                    ApplyChange(change);
+                }
+
+                state_.journal_seq = record.seq;
+                state_.id_session = record.id_session;
+                state_.dog_id = record.dog_id;
+            }
+
+        private:
+            void ApplyChange(JournalChange& change) {
+                switch(change.op) {
+                    case JournalOp::SESSION: {
+                        auto [it, inserted] = sessions_.try_emplace(change.session_id, state_.sessions.size());
+                        if(inserted) {
+                            state_.sessions.emplace_back(change.session_id, std::move(change.session));
+                        } else {
+                            state_.sessions[it->second].second = std::move(change.session);
+                        }
+                        break;
+                    }
+                    case JournalOp::DOG:
+                        FindSession(change.session_id).SetDog(change.dog);
+                        break;
+                    case JournalOp::DOG_REMOVE:
+                        if(auto it = sessions_.find(change.session_id); it != sessions_.end()) {
+                            state_.sessions[it->second].second.RemoveDog(change.dog_id);
+                        }
+                        break;
+                    case JournalOp::PLAYER: {
+                        auto [it, inserted] = players_.try_emplace(change.player.GetToken(), state_.players.size());
+                        if(inserted) {
+                            state_.players.push_back(std::move(change.player));
+                        } else {
+                            state_.players[it->second] = std::move(change.player);
+                        }
+                        break;
+                    }
+                    case JournalOp::PLAYER_REMOVE:
+                        RemovePlayer(change.token);
+                        break;
+                    case JournalOp::SESSION_KEYS:
+                        state_.session_keys = std::move(change.keys);
+                        break;
+                    case JournalOp::END:
+                        break;
+                }
+            }
+
+            GameSessionRepr& FindSession(uint64_t session_id) {
+                auto it = sessions_.find(session_id);
+                if(it == sessions_.end()) {
+                    throw std::runtime_error("Journal refers to unknown session "s + std::to_string(session_id));
+                }
+
+                return state_.sessions[it->second].second;
+            }
+
+            // Последний игрок переносится на место удаленного
+            void RemovePlayer(const std::string& token) {
+                auto it = players_.find(token);
+                if(it == players_.end()) {
+                    return;
+                }
+
+                const size_t pos = it->second;
+                players_.erase(it);
+
+                if(pos + 1 != state_.players.size()) {
+                    state_.players[pos] = std::move(state_.players.back());
+                    players_[state_.players[pos].GetToken()] = pos;
+                }
+
+                state_.players.pop_back();
+            }
+
+            GameStateCapture& state_;
+            std::unordered_map<uint64_t, size_t> sessions_;
+            std::unordered_map<std::string, size_t> players_;
+        };
+
+    } // namespace
+
+    void SyncPath(const fs::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            throw std::runtime_error("Couldn't open "s + path.string() + " for fsync"s);
+        }
+
+        const int result = ::fsync(fd);
+        ::close(fd);
+
+        if(result != 0) {
+            throw std::runtime_error("fsync failed for "s + path.string());
+        }
+    }
+
+    JournalRecordBuilder::JournalRecordBuilder(uint64_t seq, uint64_t id_session, uint64_t dog_id)
+        : seq_{seq}
+        , writer_{out_, JOURNAL_RECORD_RESERVE}
+        , ar_{writer_} {
+        writer_.BeginSection(JOURNAL_RECORD_SECTION, 1);
+        ar_ << seq << id_session << dog_id;
+    }
+
+    void JournalRecordBuilder::AddSession(uint64_t session_id, const GameSessionRepr& session) {
+        ar_ << JournalOp::SESSION << session_id << session;
+        ++changes_;
+    }
+
+    void JournalRecordBuilder::AddDog(uint64_t session_id, const DogRepr& dog) {
+        ar_ << JournalOp::DOG << session_id << dog;
+        ++changes_;
+    }
+
+    void JournalRecordBuilder::RemoveDog(uint64_t session_id, uint64_t dog_id) {
+        ar_ << JournalOp::DOG_REMOVE << session_id << dog_id;
+        ++changes_;
+    }
+
+    void JournalRecordBuilder::AddPlayer(const PlayerRepr& player) {
+        ar_ << JournalOp::PLAYER << player;
+        ++changes_;
+    }
+
+    void JournalRecordBuilder::RemovePlayer(const std::string& token) {
+        ar_ << JournalOp::PLAYER_REMOVE << token;
+        ++changes_;
+    }
+
+    void JournalRecordBuilder::SetSessionKeys(const std::vector<SessionKeyRepr>& keys) {
+        ar_ << JournalOp::SESSION_KEYS << keys;
+        ++changes_;
+    }
+
+    bool JournalRecordBuilder::Empty() const noexcept {
+        return changes_ == 0;
+    }
+
+    JournalRecord JournalRecordBuilder::Finish() {
+        ar_ << JournalOp::END;
+        writer_.EndSection();
+        return {seq_, std::move(out_).str()};
+    }
+
+    std::optional<JournalRecord> JournalTracker::Capture(const app::GameManager& manager, uint64_t seq) {
+        ++pass_;
+        JournalRecordBuilder builder{seq, manager.GetCurrentValueSessionId(), manager.GetDogId()};
+
+        // Сессии только добавляются, поэтому карта сессий по типу меняется вместе со своим размером
+        if(manager.GetGameSessions().size() != session_keys_count_) {
+            builder.SetSessionKeys(CaptureSessionKeys(manager));
+            session_keys_count_ = manager.GetGameSessions().size();
+        }
+
+        for(const auto& [session_id, session] : manager.GetAllSessions()) {
+            // id предметов не повторяются, поэтому число и сумма id меняются при появлении и подборе предмета
+            LootState loot;
+            for(const auto& [object_id, _] : session->GetLostObjects()) {
+                ++loot.count;
+                loot.ids_sum += object_id;
+            }
+
+            auto [loot_it, new_session] = sessions_.try_emplace(session_id, loot);
+            const bool whole_session = new_session || loot_it->second != loot;
+            loot_it->second = loot;
+
+            if(whole_session) {
+                builder.AddSession(session_id, GameSessionRepr{*session});
+            }
+
+            for(const auto& [dog_id, dog] : session->GetDogsList()) {
+                const DogState state{dog->GetCurrentPosition(), dog->GetVelocity(), dog->GetDirection()};
+                auto [dog_it, new_dog] = dogs_.try_emplace(dog_id, DogEntry{session_id, state, pass_});
+
+                // Псы сессии, записанной целиком, уже есть в записи
+                if(!whole_session && (new_dog || dog_it->second.state != state)) {
+                    builder.AddDog(session_id, DogRepr{*dog});
+                }
+
+                dog_it->second = DogEntry{session_id, state, pass_};
+            }
+        }
+
+        for(const auto& player : manager.GetPlayers()) {
+            const auto& bag = player->GetBag();
+            PlayerState state{player->GetScore(), 0, 0};
+            for(const auto& object : bag.GetObjects()) {
+                ++state.bag_count;
+                state.bag_ids_sum += object.GetId();
+            }
+
+            const std::string_view token = player->GetToken();
+            auto player_it = players_.find(token);
+
+            if(player_it == players_.end()) {
+                players_.emplace(std::string{token}, PlayerEntry{state, pass_});
+                builder.AddPlayer(PlayerRepr{*player});
+                continue;
+            }
+
+            if(player_it->second.state != state) {
+                builder.AddPlayer(PlayerRepr{*player});
+            }
+
+            player_it->second = PlayerEntry{state, pass_};
+        }
+
+        // Не встреченные в этом проходе псы и игроки покинули игру
+        std::erase_if(dogs_, [&builder, this](const auto& item) {
+            if(item.second.seen == pass_) {
+                return false;
+            }
+
+            builder.RemoveDog(item.second.session_id, item.first);
+            return true;
+        });
+
+        std::erase_if(players_, [&builder, this](const auto& item) {
+            if(item.second.seen == pass_) {
+                return false;
+            }
+
+            builder.RemovePlayer(item.first);
+            return true;
+        });
+
+        if(builder.Empty()) {
+            return std::nullopt;
+        }
+
+        return builder.Finish();
+    }
+
+    JournalFile::JournalFile(fs::path path)
+        : path_{std::move(path)} {
+        Open();
+    }
+
+    JournalFile::~JournalFile() {
+        Close();
+    }
+
+    void JournalFile::Append(const JournalRecord& record) {
+        WriteAll(fd_, record.data, path_);
+    }
+
+    void JournalFile::Sync() {
+        if(::fdatasync(fd_) != 0) {
+            throw SnapshotError("fdatasync failed for "s + path_.string());
+        }
+    }
+
+    void JournalFile::Rewrite(const std::vector<JournalRecord>& records) {
+        const fs::path temp_path = path_.string() + ".tmp"s;
+        const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0) {
+            throw SnapshotError("Couldn't open journal "s + temp_path.string());
+        }
+
+        try {
+            WriteAll(fd, JournalHeader(), temp_path);
+            for(const auto& record : records) {
+                WriteAll(fd, record.data, temp_path);
+            }
+
+            if(::fdatasync(fd) != 0) {
+                throw SnapshotError("fdatasync failed for "s + temp_path.string());
+            }
+        } catch(...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+
+        fs::rename(temp_path, path_);
+        SyncPath(path_.has_parent_path() ? path_.parent_path() : fs::path{"."});
+
+        Close();
+        Open();
+    }
+
+    void JournalFile::Open() {
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if(fd_ < 0) {
+            throw SnapshotError("Couldn't open journal "s + path_.string());
+        }
+
+        // Новый (или обрезанный до пустого при восстановлении) журнал начинается с заголовка
+        if(fs::file_size(path_) == 0) {
+            WriteAll(fd_, JournalHeader(), path_);
+            Sync();
+        }
+    }
+
+    void JournalFile::Close() noexcept {
+        if(fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    uint64_t ReplayJournal(std::istream& in, GameStateCapture& state) {
+        SnapshotReader reader{in};
+        BinaryIArchive ar{reader};
+
+        std::string magic(JOURNAL_MAGIC.size(), '\0');
+        std::array<char, sizeof(JOURNAL_VERSION)> version;
+        try {
+            reader.ReadRaw(magic.data(), magic.size());
+            reader.ReadRaw(version.data(), version.size());
+        } catch(const SnapshotError&) {
+            // Сбой при создании журнала: заголовок не дописан
+            return 0;
+        }
+
+        if(magic != JOURNAL_MAGIC) {
+            throw SnapshotError("Not a game state journal"s);
+        }
+
+        if(SnapshotReader::LoadLittleEndian(version.data(), version.size()) != JOURNAL_VERSION) {
+            throw SnapshotError("Unsupported game state journal version"s);
+        }
+
+        JournalApplier applier{state};
+        uint64_t good_size = magic.size() + version.size();
+
+        while(in.peek() != std::istream::traits_type::eof()) {
+            ParsedRecord record;
+            try {
+                record = ReadRecord(reader, ar);
+            } catch(const SnapshotError&) {
+                // Запись не дописана до конца - дальше журнал не читаем
+                break;
+            }
+
+            good_size = static_cast<uint64_t>(in.tellg());
+
+            // Записи до контрольной точки уже есть в снимке
+            if(record.seq > state.journal_seq) {
+                applier.Apply(record);
+            }
+        }
+
+        return good_size;
+    }
+
+} // namespace serialization
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "binary_snapshot.h"
+
+namespace serialization {
+
+    namespace fs = std::filesystem;
+
+    // Первые байты файла журнала изменений и версия формата
+    const std::string JOURNAL_MAGIC = "DOGWAL"s;
+    const uint32_t JOURNAL_VERSION = 1;
+
+    // Виды изменений в записи журнала. Изменение несет итоговое состояние объекта, а не команду:
+    // движение и появление предметов случайны, поэтому повторить тик при восстановлении нельзя
+    enum class JournalOp : uint8_t {
+        END = 0,            // конец записи
+        SESSION = 1,        // сессия целиком: новая сессия или изменились предметы на карте
+        DOG = 2,            // пес сессии: сменил положение, скорость или направление
+        DOG_REMOVE = 3,
+        PLAYER = 4,         // игрок: вошел в игру, подобрал или сдал предметы
+        PLAYER_REMOVE = 5,  // игрок ушел на покой
+        SESSION_KEYS = 6    // карта сессий по типу целиком
+    };
+
+    // Закодированная запись журнала: секция JOURNAL_RECORD_SECTION с номером записи,
+    // счетчиками GameManager и списком изменений
+    struct JournalRecord {
+        uint64_t seq = 0;
+        std::string data;
+    };
+
+    class JournalRecordBuilder {
+    public:
+        JournalRecordBuilder(uint64_t seq, uint64_t id_session, uint64_t dog_id);
+
+        void AddSession(uint64_t session_id, const GameSessionRepr& session);
+        void AddDog(uint64_t session_id, const DogRepr& dog);
+        void RemoveDog(uint64_t session_id, uint64_t dog_id);
+        void AddPlayer(const PlayerRepr& player);
+        void RemovePlayer(const std::string& token);
+        void SetSessionKeys(const std::vector<SessionKeyRepr>& keys);
+
+        bool Empty() const noexcept;
+        [[nodiscard]] JournalRecord Finish();
+
+    private:
+        uint64_t seq_ = 0;
+        size_t changes_ = 0;
+        std::ostringstream out_;
+        SnapshotWriter writer_;
+        BinaryOArchive ar_;
+    };
+
+    // Находит изменения состояния GameManager с прошлого вызова. Вызывается на strand после тика:
+    // сравнивает короткие признаки объектов (положение пса, очки и рюкзак игрока, набор предметов сессии)
+    // и кодирует только изменившиеся объекты
+    class JournalTracker {
+    public:
+        // Запись с изменениями или std::nullopt, если ничего не изменилось
+        [[nodiscard]] std::optional<JournalRecord> Capture(const app::GameManager& manager, uint64_t seq);
+
+    private:
+        struct LootState {
+            size_t count = 0;
+            size_t ids_sum = 0;
+            bool operator==(const LootState&) const = default;
+        };
+
+        struct DogState {
+            model::Position position;
+            model::Velocity velocity;
+            model::Direction direction;
+            bool operator==(const DogState&) const = default;
+        };
+
+        struct DogEntry {
+            uint64_t session_id = 0;
+            DogState state;
+            uint64_t seen = 0;
+        };
+
+        struct PlayerState {
+            size_t score = 0;
+            size_t bag_count = 0;
+            size_t bag_ids_sum = 0;
+            bool operator==(const PlayerState&) const = default;
+        };
+
+        struct PlayerEntry {
+            PlayerState state;
+            uint64_t seen = 0;
+        };
+
+        // Поиск по токену из string_view без создания строки
+        struct TokenHasher {
+            using is_transparent = void;
+            size_t operator()(std::string_view token) const noexcept {
+                return std::hash<std::string_view>{}(token);
+            }
+        };
+
+        // Номер вызова Capture: объекты, не встреченные в текущем вызове, удалены из игры
+        uint64_t pass_ = 0;
+        size_t session_keys_count_ = 0;
+        std::unordered_map<uint64_t, LootState> sessions_;
+        std::unordered_map<uint64_t, DogEntry> dogs_;
+        std::unordered_map<std::string, PlayerEntry, TokenHasher, std::equal_to<>> players_;
+    };
+
+    // Сбрасывает на диск содержимое файла или каталога (для каталога - запись о переименовании)
+    void SyncPath(const fs::path& path);
+
+    // Файл журнала. Записи дописываются в конец, Sync сбрасывает их на диск
+    class JournalFile {
+    public:
+        explicit JournalFile(fs::path path);
+        ~JournalFile();
+
+        JournalFile(const JournalFile&) = delete;
+        JournalFile& operator=(const JournalFile&) = delete;
+
+        void Append(const JournalRecord& record);
+        void Sync();
+        // Сжатие после контрольной точки: журнал атомарно заменяется файлом из оставшихся записей
+        void Rewrite(const std::vector<JournalRecord>& records);
+
+    private:
+        void Open();
+        void Close() noexcept;
+
+        fs::path path_;
+        int fd_ = -1;
+    };
+
+    // Применяет к state записи журнала с номером больше state.journal_seq. Оборванная или поврежденная
+    // последняя запись отбрасывается целиком: возвращается длина неповрежденной части журнала
+    uint64_t ReplayJournal(std::istream& in, GameStateCapture& state);
+
+} // namespace serialization
@@ -1,11 +1,10 @@
 #include "http_server.h"
 
 #include <iostream>
+#include <utility>
 
 #include <boost/asio/dispatch.hpp>
 
-#include "../request/request_handler.h"
-
 namespace http_server {
 
 using namespace std::literals;
@@ -15,6 +14,25 @@ void ReportError(beast::error_code ec, std::string_view what) {
 }
 
 //---------------------------------------------------------------------------------------------------- методы SessionBase
+    SessionBase::SessionBase(SessionSocket&& socket)
+        : stream_(std::move(socket))
+        , response_timer_(stream_.get_executor()) {
+        // Адрес клиента читается один раз на соединение, а не на каждый запрос
+        beast::error_code ec;
+        endpoint_ = stream_.socket().remote_endpoint(ec);
+        // Ответы конвейера уходят в сокет по мере готовности: без задержки Нейгла (ждущей
+        // подтверждения от клиента с отложенным ACK) каждый следующий ответ не ждет десятки миллисекунд
+        stream_.socket().set_option(tcp::no_delay(true), ec);
+    }
+
+    SessionBase::~SessionBase() {
+        for (auto*& response : responses_) {
+            if (response) {
+                ReleaseResponse(std::exchange(response, nullptr));
+            }
+        }
+    }
+
     void SessionBase::Run() {
     // Вызываем метод Read, используя executor объекта stream_.
     // Таким образом вся работа со stream_ будет выполняться, используя его executor
@@ -23,11 +41,35 @@ void ReportError(beast::error_code ec, std::string_view what) {
 }
 
 tcp::endpoint SessionBase::GetEndpoint() const {
-  return stream_.socket().remote_endpoint();
+  return endpoint_;
 }
 
-    void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    void SessionBase::WriteNext() {
+        if (writing_ || closed_) {
+            return;
+        }
+
+        // Ответ на очередной по порядку запрос еще не готов - следующие ответы ждут его
+        PendingResponse* response = responses_[write_seq_ % MAX_PIPELINED_REQUESTS];
+        if (!response) {
+            return;
+        }
+
+        writing_ = true;
+        // Идущее чтение сохраняет свой срок: basic_stream не меняет срок начатой операции
+        stream_.expires_after(WRITE_TIMEOUT);
+        response->AsyncWrite(*this);
+    }
+
+    void SessionBase::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+        writing_ = false;
+        auto& slot = responses_[write_seq_ % MAX_PIPELINED_REQUESTS];
+        const bool close = slot->NeedEof();
+        ReleaseResponse(std::exchange(slot, nullptr));
+        ++write_seq_;
+
         if (ec) {
+            response_timer_.cancel();
             return ReportError(ec, "write"sv);
         }
 
@@ -36,25 +78,52 @@ tcp::endpoint SessionBase::GetEndpoint() const {
             return Close();
         }
 
-        // Считываем следующий запрос
-        Read();
+        if (read_paused_) {
+            // Очередь освободилась - считываем следующий запрос
+            read_paused_ = false;
+            response_timer_.cancel();
+            Read();
+        } else if (read_closed_) {
+            if (read_seq_ == write_seq_) {
+                // Клиент закрыл соединение, все ответы ему отправлены
+                return Close();
+            }
+            // Срок ответа на следующий запрос отсчитывается заново
+            WaitForResponses();
+        }
+
+        WriteNext();
+    }
+
+    void SessionBase::ReleaseResponse(PendingResponse* response) noexcept {
+        const size_t size = response->allocated_size;
+        const size_t align = response->allocated_align;
+        response->~PendingResponse();
+        responses_pool_.deallocate(response, size, align);
     }
 
     void SessionBase::Read() {
         /* Асинхронное чтение запроса */
-        // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
-        request_ = {};
-        stream_.expires_after(30s);
-        // Считываем request_ из stream_, используя buffer_ для хранения считанных данных
-        http::async_read(stream_, buffer_, request_,
+        // Парсер создается заново на месте прежнего (метод Read может быть вызван несколько раз)
+        parser_.emplace();
+        // Идущая запись сохраняет свой срок: basic_stream не меняет срок начатой операции
+        stream_.expires_after(READ_TIMEOUT);
+        // Считываем запрос из stream_, используя buffer_ для хранения считанных данных
+        http::async_read(stream_, buffer_, *parser_,
                          // По окончании операции будет вызван метод OnRead
                          beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
     }
 
     void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
         if (ec == http::error::end_of_stream) {
-            // Нормальная ситуация - клиент закрыл соединение
-            return Close();
+            // Нормальная ситуация - клиент закрыл соединение. Ответы на прочитанные запросы еще дописываем
+            read_closed_ = true;
+            if (read_seq_ == write_seq_) {
+                Close();
+            } else {
+                WaitForResponses();
+            }
+            return;
         }
 
         if (ec) {
@@ -62,11 +131,32 @@ tcp::endpoint SessionBase::GetEndpoint() const {
             return ReportError(ec, "read"sv);
         }
 
+        // Соединение уже закрыто ответом на прежний запрос
+        if (closed_) {
+            return;
+        }
+
         // Запрос прочитан без ошибок, делегируйте его обработку классу-наследнику
-        HandleRequest(std::move(request_));
+        HttpRequest request = parser_->release();
+        const bool keep_alive = request.keep_alive();
+        HandleRequest(std::move(request), read_seq_++);
+
+        if (!keep_alive) {
+            // После ответа на этот запрос соединение закроется
+            read_closed_ = true;
+            WaitForResponses();
+        } else if (read_seq_ - write_seq_ < MAX_PIPELINED_REQUESTS) {
+            // Следующий запрос читаем, не дожидаясь ответа на этот
+            Read();
+        } else {
+            read_paused_ = true;
+            WaitForResponses();
+        }
     }
 
     void SessionBase::Close() {
+        closed_ = true;
+        response_timer_.cancel();
         beast::error_code ec;
         stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
         
@@ -75,5 +165,26 @@ tcp::endpoint SessionBase::GetEndpoint() const {
         }
     }
 
+    void SessionBase::WaitForResponses() {
+        response_timer_.expires_after(RESPONSE_TIMEOUT);
+        response_timer_.async_wait(beast::bind_front_handler(&SessionBase::OnResponseTimeout, GetSharedThis()));
+    }
+
+    void SessionBase::OnResponseTimeout(beast::error_code ec) {
+        // Таймер отменен: ответ записан или соединение уже закрыто
+        if (ec == net::error::operation_aborted || closed_) {
+            return;
+        }
+
+        // Идет запись ответа - ее ограничивает собственный срок, после нее сессия снова читает или закрывается
+        if (writing_) {
+            return WaitForResponses();
+        }
+
+        // Обработчик не ответил в срок. Ответы, пришедшие позже, отбрасываются (closed_)
+        ReportError(beast::error::timeout, "response"sv);
+        closed_ = true;
+        stream_.close();
+    }
 
-}  // namespace http_server
\ No newline at end of file
+}  // namespace http_server
\ No newline at end of file
@@ -2,7 +2,17 @@
 
 #include "../sdk.h"
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <optional>
+
+#include <boost/asio/detail/socket_option.hpp>
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
@@ -17,11 +27,23 @@ namespace http_server {
 
     void ReportError(beast::error_code ec, std::string_view what);
 
+    // SO_REUSEPORT: несколько сокетов слушают один порт, ядро распределяет между ними входящие соединения
+    using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+    // Сокет сессии с конкретным типом strand вместо any_io_executor: стертый тип хранит strand
+    // в куче и выделял память на каждую асинхронную операцию сессии
+    using SessionStrand = net::strand<net::io_context::executor_type>;
+    using SessionSocket = tcp::socket::rebind_executor<SessionStrand>::other;
+    using SessionStream = beast::basic_stream<tcp, SessionStrand>;
+    using SessionTimer = net::basic_waitable_timer<std::chrono::steady_clock
+                                                 , net::wait_traits<std::chrono::steady_clock>, SessionStrand>;
+
+    // Сессия HTTP/1.1 с конвейером (pipelining): следующий запрос читается, не дожидаясь ответа
+    // на предыдущий, а ответы пишутся в сокет в порядке запросов. На постоянном соединении сессия
+    // не выделяет память под разбор запросов и запись ответов: парсер, буфер и пул ответов живут в сессии
     class SessionBase {
         public:
-        explicit SessionBase(tcp::socket&& socket)
-            : stream_(std::move(socket)) {
-        }
+        explicit SessionBase(SessionSocket&& socket);
 
         // Запрещаем копирование и присваивание объектов SessionBase и его наследников
         SessionBase(const SessionBase&) = delete;
@@ -32,20 +54,72 @@ namespace http_server {
     protected:
         using HttpRequest = http::request<http::string_body>;
 
+        // Ответ на запрос с номером seq. Вызывается из любого потока: ответ передается в executor сессии
         template <typename Body, typename Fields>
-        void Write(http::response<Body, Fields>&& response);
+        void Write(uint64_t seq, http::response<Body, Fields>&& response);
 
+        // Адрес клиента, прочитанный при приеме соединения
         tcp::endpoint GetEndpoint() const;
-        const tcp::socket& GetSocket() const {
+        const SessionSocket& GetSocket() const {
             return stream_.socket();
         }
 
-        ~SessionBase() = default;
+        ~SessionBase();
 
     private:
+        // Сколько запросов может ждать ответа, прежде чем сессия перестанет читать новые
+        static constexpr size_t MAX_PIPELINED_REQUESTS = 16;
+        // Срок чтения запроса и записи ответа отсчитывается от начала каждой операции отдельно.
+        // Срок ответа действует, пока сессия не читает (очередь заполнена или клиент закончил
+        // отправку) и ждет ответа обработчика: по его истечении соединение закрывается
+        static constexpr std::chrono::seconds READ_TIMEOUT{30};
+        static constexpr std::chrono::seconds WRITE_TIMEOUT{30};
+        static constexpr std::chrono::seconds RESPONSE_TIMEOUT{30};
+
+        // Ответ в очереди на запись. Сериализатор хранится рядом с ответом, поэтому async_write
+        // не выделяет память под него; сам ответ лежит в пуле сессии и возвращается в пул после записи
+        class PendingResponse {
+        public:
+            virtual ~PendingResponse() = default;
+            virtual void AsyncWrite(SessionBase& session) = 0;
+            virtual bool NeedEof() const = 0;
+
+            size_t allocated_size = 0;
+            size_t allocated_align = 0;
+        };
+
+        template <typename Body, typename Fields>
+        class PendingResponseImpl final : public PendingResponse {
+        public:
+            explicit PendingResponseImpl(http::response<Body, Fields>&& response)
+                : response_(std::move(response))
+                , serializer_(response_) {
+            }
+
+            void AsyncWrite(SessionBase& session) override {
+                http::async_write(session.stream_, serializer_
+                                , beast::bind_front_handler(&SessionBase::OnWrite, session.GetSharedThis()));
+            }
+
+            bool NeedEof() const override {
+                return response_.need_eof();
+            }
+
+        private:
+            http::response<Body, Fields> response_;
+            http::response_serializer<Body, Fields> serializer_;
+        };
+
         virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
 
-        void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+        template <typename Body, typename Fields>
+        void QueueResponse(uint64_t seq, http::response<Body, Fields>&& response);
+
+        void WriteNext();
+
+        void OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+
+        void ReleaseResponse(PendingResponse* response) noexcept;
 
         void Read();
 
@@ -53,35 +127,50 @@ namespace http_server {
 
         void Close();
 
-        // Обработку запроса делегируем подклассу
-        virtual void HandleRequest(HttpRequest&& request) = 0;
+        // Срок ответа обработчика, пока сессия не читает новых запросов
+        void WaitForResponses();
+        void OnResponseTimeout(beast::error_code ec);
+
+        // Обработку запроса делегируем подклассу. seq - номер запроса в соединении для Write
+        virtual void HandleRequest(HttpRequest&& request, uint64_t seq) = 0;
 
     private:
         // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
-        beast::tcp_stream stream_;
+        SessionStream stream_;
+        SessionTimer response_timer_;
         beast::flat_buffer buffer_;
-        HttpRequest request_;
+        tcp::endpoint endpoint_;
+        // Парсер создается на месте для каждого запроса, без выделения памяти под операцию чтения
+        std::optional<http::request_parser<http::string_body>> parser_;
+
+        std::pmr::unsynchronized_pool_resource responses_pool_;
+        // Ответы по номеру запроса по модулю MAX_PIPELINED_REQUESTS
+        std::array<PendingResponse*, MAX_PIPELINED_REQUESTS> responses_{};
+        // Номер следующего прочитанного запроса и номер запроса, ответ на который пишется следующим
+        uint64_t read_seq_ = 0;
+        uint64_t write_seq_ = 0;
+        bool writing_ = false;
+        bool read_paused_ = false;
+        bool read_closed_ = false;
+        bool closed_ = false;
     };
 
     template <typename RequestHandler>
     class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
     public:
         template <typename Handler>
-        Session(tcp::socket&& socket, Handler&& request_handler)
+        Session(SessionSocket&& socket, Handler&& request_handler)
             : SessionBase(std::move(socket))
             , request_handler_(std::forward<Handler>(request_handler)) {
         }
 
     private:
-    void HandleRequest(HttpRequest&& request) override{
+    void HandleRequest(HttpRequest&& request, uint64_t seq) override{
         // Захватываем умный указатель на текущий объект Session в лямбде,
         // чтобы продлить время жизни сессии до вызова лямбды.
-        // Получаем IP-адрес из сокета
-        auto ip_address = GetSocket().remote_endpoint().address().to_string();
-
         // Используется generic-лямбда функция, способная принять response произвольного типа
-        request_handler_(GetEndpoint(), std::move(request), [self = this->shared_from_this()](auto&& response) {
-            self->Write(std::move(response));
+        request_handler_(GetEndpoint(), std::move(request), [self = this->shared_from_this(), seq](auto&& response) {
+            self->Write(seq, std::move(response));
         });
     }
 
@@ -97,8 +186,9 @@ namespace http_server {
     template <typename RequestHandler>
     class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
     public:
+        // reuse_port - слушать порт вместе с другими Listener (по одному на io_context)
         template <typename Handler>
-        Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+        Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler, bool reuse_port = false)
             : ioc_(ioc)
             // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
             , acceptor_(net::make_strand(ioc))
@@ -111,6 +201,9 @@ namespace http_server {
             // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
             // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
             acceptor_.set_option(net::socket_base::reuse_address(true));
+            if(reuse_port) {
+                acceptor_.set_option(ReusePort(true));
+            }
             // Привязываем acceptor к адресу и порту endpoint
             acceptor_.bind(endpoint);
             // Переводим acceptor в состояние, в котором он способен принимать новые соединения
@@ -140,7 +233,7 @@ namespace http_server {
         }
 
         // Метод socket::async_accept создаст сокет и передаст его в OnAccept
-        void OnAccept(sys::error_code ec, tcp::socket socket){
+        void OnAccept(sys::error_code ec, SessionSocket socket){
             using namespace std::literals;
 
             if (ec) {
@@ -154,7 +247,7 @@ namespace http_server {
             DoAccept();
         }
 
-        void AsyncRunSession(tcp::socket&& socket){
+        void AsyncRunSession(SessionSocket&& socket){
             std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
         }
 
@@ -169,24 +262,44 @@ namespace http_server {
 
 // шаблонные функции-----------------------------------------------------------------------------------------------------------
     template <typename Body, typename Fields>
-    inline void SessionBase::Write(http::response<Body, Fields> &&response) {
-            // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
-            auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
-            auto self = GetSharedThis();
-
-            http::async_write(stream_, *safe_response,
-                            [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                                self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                            });
+    inline void SessionBase::Write(uint64_t seq, http::response<Body, Fields> &&response) {
+        // Очередь ответов меняется только в executor сессии. Из него (ответ на статический файл)
+        // dispatch выполняет лямбду сразу, из strand игры - передает ее в executor сессии
+        net::dispatch(stream_.get_executor(), [self = GetSharedThis(), seq, response = std::move(response)]() mutable {
+            self->QueueResponse(seq, std::move(response));
+        });
+    }
+
+    template <typename Body, typename Fields>
+    void SessionBase::QueueResponse(uint64_t seq, http::response<Body, Fields>&& response) {
+        // Соединение уже закрыто ответом на один из прежних запросов
+        if (closed_) {
+            return;
+        }
+
+        using Pending = PendingResponseImpl<Body, Fields>;
+        void* memory = responses_pool_.allocate(sizeof(Pending), alignof(Pending));
+        Pending* pending = nullptr;
+        try {
+            pending = new (memory) Pending(std::move(response));
+        } catch (...) {
+            responses_pool_.deallocate(memory, sizeof(Pending), alignof(Pending));
+            throw;
+        }
+
+        pending->allocated_size = sizeof(Pending);
+        pending->allocated_align = alignof(Pending);
+        responses_[seq % MAX_PIPELINED_REQUESTS] = pending;
+        WriteNext();
     }
 
     template <typename RequestHandler>
-    void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler) {
+    void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler, bool reuse_port = false) {
         // При помощи decay_t исключим ссылки из типа RequestHandler,
         // чтобы Listener хранил RequestHandler по значению
         using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-        std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+        std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), reuse_port)->Run();
     }
 
-} // namespace http_server
\ No newline at end of file
+} // namespace http_server
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "io_context_pool.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace http_server {
+
+    using namespace std::literals;
+
+    namespace {
+
+        void PinCurrentThread(size_t index) {
+            const unsigned cpus = std::max(std::thread::hardware_concurrency(), 1u);
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(index % cpus, &cpu_set);
+
+            // Закрепление - только оптимизация: без него поток просто может сменить процессор
+            if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+                std::cerr << "Failed to pin io thread to CPU "sv << index % cpus << std::endl;
+            }
+        }
+
+    } // namespace
+
+    IoContextPool::IoContextPool(size_t size, bool pin_threads)
+        : pin_threads_(pin_threads) {
+        size = std::max<size_t>(size, 1);
+        contexts_.reserve(size);
+        work_guards_.reserve(size);
+
+        for(size_t i = 0; i < size; ++i) {
+            // Подсказка asio: io_context выполняется одним потоком
+            contexts_.push_back(std::make_unique<net::io_context>(1));
+            work_guards_.push_back(net::make_work_guard(*contexts_.back()));
+        }
+    }
+
+    IoContextPool::~IoContextPool() {
+        Stop();
+        Join();
+    }
+
+    void IoContextPool::Run() {
+        threads_.reserve(contexts_.size());
+
+        for(size_t i = 0; i < contexts_.size(); ++i) {
+            threads_.emplace_back([this, i] {
+                if(pin_threads_) {
+                    PinCurrentThread(i);
+                }
+
+                contexts_[i]->run();
+            });
+        }
+    }
+
+    void IoContextPool::Stop() {
+        for(auto& context : contexts_) {
+            context->stop();
+        }
+    }
+
+    void IoContextPool::Join() {
+        threads_.clear();
+    }
+
+} // namespace http_server
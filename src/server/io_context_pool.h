@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+namespace http_server {
+
+    namespace net = boost::asio;
+
+    // Набор io_context, по одному на поток. Соединение, принятое в io_context, обслуживается
+    // тем же потоком от приема до закрытия: без передачи обработчиков между потоками
+    class IoContextPool {
+    public:
+        // pin_threads - закрепить поток i за процессором i (по кругу, если потоков больше, чем процессоров)
+        explicit IoContextPool(size_t size, bool pin_threads = false);
+        ~IoContextPool();
+
+        IoContextPool(const IoContextPool&) = delete;
+        IoContextPool& operator=(const IoContextPool&) = delete;
+
+        size_t Size() const noexcept {
+            return contexts_.size();
+        }
+
+        net::io_context& GetContext(size_t index) {
+            return *contexts_.at(index);
+        }
+
+        // Запускает потоки пула, каждый выполняет свой io_context
+        void Run();
+        // Останавливает все io_context (можно вызывать из обработчика сигнала в любом потоке)
+        void Stop();
+        // Дожидается завершения потоков пула
+        void Join();
+
+    private:
+        using WorkGuard = net::executor_work_guard<net::io_context::executor_type>;
+
+        bool pin_threads_;
+        std::vector<std::unique_ptr<net::io_context>> contexts_;
+        // Не дают io_context завершиться, пока на нем нет соединений
+        std::vector<WorkGuard> work_guards_;
+        std::vector<std::jthread> threads_;
+    };
+
+} // namespace http_server
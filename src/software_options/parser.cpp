@@ -19,11 +19,22 @@ namespace prog_opt {
         desc.add_options()
             ("help,h", "produce help message")
             ("tick-period,t", po::value(&args.tick_period)->value_name("milliseconds"s), "set tick period")
+            ("tick-max-step", po::value(&args.tick_max_step)->value_name("milliseconds"s), "split automatic ticks longer than this into sub-steps (0 - off)")
             ("config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path")
             ("www-root,w", po::value(&args.www_root)->value_name("dir"s), "set static files root")
             ("randomize-spawn-points", po::value(&args.randomize_spawn_points), "spawn dogs at random positions")
             ("state-file", po::value(&args.state_file)->value_name("file"s), "set file for save and restore game state")
-            ("save-state-period", po::value(&args.save_state_period)->value_name("milliseconds"s), "set save game state period");
+            ("save-state-period", po::value(&args.save_state_period)->value_name("milliseconds"s), "set save game state period")
+            ("state-journal", po::value(&args.state_journal)->value_name("file"s), "set journal of game state changes between saves (written every tick)")
+            ("collision-threads", po::value(&args.collision_threads)->value_name("count"s), "set number of threads for collision detection in one session")
+            ("per-core-io", po::value(&args.per_core_io), "serve connections by an io_context per core with SO_REUSEPORT listeners")
+            ("pin-io-threads", po::value(&args.pin_io_threads), "pin per-core io threads to CPUs")
+            ("records-journal", po::value(&args.records_journal)->value_name("file"s), "set journal for player records not yet saved to database")
+            ("records-storage", po::value(&args.records_storage)->value_name("postgres|embedded"s), "set player records storage (embedded does not need GAME_DB_URL)")
+            ("records-log", po::value(&args.records_log)->value_name("file"s), "set player records file for embedded storage")
+            ("metrics-port", po::value(&args.metrics_port)->value_name("port"s), "serve Prometheus metrics on 127.0.0.1:<port>/metrics")
+            ("sync-log", po::value(&args.sync_log), "write log records in the logging thread instead of a background writer")
+            ("log-requests-sample", po::value(&args.log_requests_sample)->value_name("n"s), "log every n-th request of a thread (0 - none)");
 
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -75,6 +86,17 @@ namespace prog_opt {
             throw StaticContentPathNotSpecifiedException();
         }
 
+        if (args.records_storage != POSTGRES_RECORDS_STORAGE && args.records_storage != EMBEDDED_RECORDS_STORAGE) {
+            logger::LogEntryToConsole(boost::json::object{  {"records-storage"s, args.records_storage},
+                                                            {"Example"s, "game_server --records-storage embedded --records-log records.log"s},
+                                                            {"exit_code", EXIT_FAILURE}
+                }
+                , "Unknown records storage"s
+                , boost::log::trivial::error);
+
+            throw UnknownRecordsStorageException();
+        }
+
         return args;
     };
 
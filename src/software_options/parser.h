@@ -4,13 +4,28 @@
 
 namespace prog_opt {
 
+    // Допустимые значения --records-storage
+    const std::string POSTGRES_RECORDS_STORAGE = "postgres";
+    const std::string EMBEDDED_RECORDS_STORAGE = "embedded";
+
     struct Args {
         size_t tick_period{0};
+        size_t tick_max_step{0};
         std::string config_file;
         std::string www_root;
         bool randomize_spawn_points{false};
         std::string state_file{};
+        std::string state_journal{};
         size_t save_state_period{0};
+        size_t collision_threads{1};
+        bool per_core_io{false};
+        bool pin_io_threads{false};
+        std::string records_journal{"records.journal"};
+        std::string records_storage{POSTGRES_RECORDS_STORAGE};
+        std::string records_log{"records.log"};
+        size_t metrics_port{0};
+        bool sync_log{false};
+        size_t log_requests_sample{1};
     };
 
     [[nodiscard]] Args ParseCommandLine(int argc, const char* const argv[]);
@@ -29,4 +44,11 @@ namespace prog_opt {
         }
     };
 
+    class UnknownRecordsStorageException : public std::exception {
+    public:
+        char const* what () {
+            return "Unknown records storage.";
+        }
+    };
+
 }
\ No newline at end of file
@@ -1,9 +1,14 @@
 #include "ticker.h"
 
+#include <algorithm>
+
+#include "../metrics/metrics.h"
+
 namespace time_m {
     void Ticker::Start() {
         net::dispatch(strand_, [self = shared_from_this()] {
             self->last_tick_ = Clock::now();
+            self->next_deadline_ = self->last_tick_ + self->period_;
             self->ScheduleTick();
         });
     }
@@ -16,9 +21,37 @@ namespace time_m {
         });
     }
 
+    void Ticker::SetMaxStep(std::chrono::milliseconds max_step) {
+        net::dispatch(strand_, [self = shared_from_this(), max_step] {
+            self->max_step_ = max_step;
+        });
+    }
+
+    // Вызывается на каждом разделенном тике, поэтому подшаги складываются в массив фиксированного размера
+    Ticker::SubSteps Ticker::SplitDelta(std::chrono::milliseconds delta, std::chrono::milliseconds max_step) {
+        SubSteps result;
+
+        if (max_step.count() <= 0 || delta <= max_step) {
+            result.steps[0] = delta;
+            result.count = 1;
+            return result;
+        }
+
+        const auto steps = std::min<int64_t>((delta.count() + max_step.count() - 1) / max_step.count(), MAX_SUBSTEPS);
+        // Остаток от деления достается первым подшагам по миллисекунде
+        const auto base = delta.count() / steps;
+        const auto remainder = delta.count() % steps;
+
+        for (int64_t i = 0; i < steps; ++i) {
+            result.steps[static_cast<size_t>(i)] = std::chrono::milliseconds{base + (i < remainder ? 1 : 0)};
+        }
+        result.count = static_cast<size_t>(steps);
+        return result;
+    }
+
     void Ticker::ScheduleTick() {
         assert(strand_.running_in_this_thread());
-        timer_.expires_after(period_);
+        timer_.expires_at(next_deadline_);
 
         timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
                 self->OnTick(ec);
@@ -36,16 +69,25 @@ namespace time_m {
         }  
 
         if (!ec) {
-            auto this_tick = Clock::now();
-            auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
-            last_tick_ = this_tick;
-
-            try {
-                // Вызов обработчика
-                handler_(delta);
-            } catch (...) {
-                throw;
+            auto& server_metrics = metrics::GetServerMetrics();
+            const auto this_tick = Clock::now();
+
+            // Опоздание относительно расписания: очередь strand или долгий предыдущий тик
+            const auto lateness = std::max(this_tick - next_deadline_, Clock::duration::zero());
+            server_metrics.tick_jitter.Record(static_cast<uint64_t>(duration_cast<microseconds>(lateness).count()));
+            if (lateness >= period_) {
+                // Сроки, прошедшие за время опоздания, объединяются с этим тиком
+                const auto missed = lateness / period_;
+                server_metrics.tick_overruns.Add();
+                server_metrics.ticks_skipped.Add(static_cast<uint64_t>(missed));
+                next_deadline_ += missed * period_;
             }
+            next_deadline_ += period_;
+
+            const auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
+            last_tick_ += delta;
+
+            RunHandler(delta);
 
             if(run_timer_){
                 ScheduleTick();
@@ -53,4 +95,17 @@ namespace time_m {
         }
     }
 
-}
\ No newline at end of file
+    void Ticker::RunHandler(std::chrono::milliseconds delta) {
+        if (max_step_.count() <= 0 || delta <= max_step_) {
+            handler_(delta);
+            return;
+        }
+
+        const auto steps = SplitDelta(delta, max_step_);
+        metrics::GetServerMetrics().tick_substeps.Add(steps.size());
+        for (const auto step : steps) {
+            handler_(step);
+        }
+    }
+
+}
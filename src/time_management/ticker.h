@@ -2,7 +2,9 @@
 
 #include <boost/asio.hpp>
 #include <boost/asio/strand.hpp>
+#include <array>
 #include <chrono>
+#include <functional>
 #include <memory>
 
 namespace time_m {
@@ -15,7 +17,32 @@ namespace time_m {
         using Strand = net::strand<net::io_context::executor_type>;
         using Handler = std::function<void(std::chrono::milliseconds delta)>;
 
-        // Функция handler будет вызываться внутри strand с интервалом period
+        // Наибольшее число подшагов одного тика. Если опоздание так велико, что подшагов не хватает,
+        // подшаги удлиняются: игровое время не теряется, а работа тика остается ограниченной
+        static constexpr size_t MAX_SUBSTEPS = 8;
+
+        // Подшаги одного тика без выделения памяти: первые count элементов steps
+        struct SubSteps {
+            std::array<std::chrono::milliseconds, MAX_SUBSTEPS> steps{};
+            size_t count = 0;
+
+            auto begin() const noexcept {
+                return steps.begin();
+            }
+
+            auto end() const noexcept {
+                return steps.begin() + count;
+            }
+
+            size_t size() const noexcept {
+                return count;
+            }
+        };
+
+        // Функция handler будет вызываться внутри strand с интервалом period. Сроки тиков отсчитываются
+        // от запуска (period, 2 * period, ...), а не от конца предыдущего тика, поэтому время работы
+        // обработчика не замедляет игру. Если тик опоздал на период и больше, пропущенные тики
+        // объединяются с ним: обработчик вызывается один раз с настоящим прошедшим временем
         Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
             : strand_{strand}
             , period_{period}
@@ -26,20 +53,32 @@ namespace time_m {
 
         void Stop();
 
+        // Тик длиннее max_step делится на подшаги не длиннее max_step (0 - не делить)
+        void SetMaxStep(std::chrono::milliseconds max_step);
+
+        // Подшаги тика delta: равные (с точностью до миллисекунды) и в сумме дающие delta
+        static SubSteps SplitDelta(std::chrono::milliseconds delta, std::chrono::milliseconds max_step);
+
     private:
         void ScheduleTick();
 
         void OnTick(sys::error_code ec);
 
+        void RunHandler(std::chrono::milliseconds delta);
+
         using Clock = std::chrono::steady_clock;
 
     private:
         Strand strand_;
         std::chrono::milliseconds period_;
+        std::chrono::milliseconds max_step_{0};
         net::steady_timer timer_{strand_};
         Handler handler_;
+        // Время, уже переданное обработчику (дробные миллисекунды переходят в следующий тик)
         std::chrono::steady_clock::time_point last_tick_;
+        // Срок следующего тика по расписанию
+        std::chrono::steady_clock::time_point next_deadline_;
         bool run_timer_ = true;
     };
 
-} // namespace time_m
\ No newline at end of file
+} // namespace time_m
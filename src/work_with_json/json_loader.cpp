@@ -95,6 +95,9 @@ namespace json_loader {
                 result.scale = value.as_double();
             } else if(key == "value"sv) { 
                 result.value = static_cast<int>(value.as_int64());
+            } else if(key == "width"sv) {
+                // Радиус подбора хранится в карте (см. AddLootTypesToMap)
+                continue;
             } else {
 
                 #ifndef DEBAGER
@@ -329,7 +332,14 @@ namespace json_loader {
             json::object loot_obj = loot.as_object();
 
             try {
-                map.AddLootType(GetLootType(loot_obj));
+                // Радиус подбора трофея, по умолчанию трофей - точка
+                double width = 0.0;
+
+                if(auto found_width = loot_obj.find("width"sv); found_width != loot_obj.end()) {
+                    width = found_width->value().to_number<double>();
+                }
+
+                map.AddLootType(GetLootType(loot_obj), width);
             } catch (const std::exception& e) {
                 std::string message =  "Error processing loot type: " + std::string(e.what());
                 logger::LogEntryToConsole(json::object{}, message, boost::log::trivial::error);
@@ -449,6 +459,19 @@ namespace json_loader {
             bag_capasity != map_config_obj.end() ? map.SetBagCapacity(static_cast<size_t>(bag_capasity->value().as_uint64())) 
                                                 : map.SetBagCapacity(game.GetGameSetting().default_bag_capacity);
 
+            // Параметры столкновений карты. Если не заданы, используются значения игры по умолчанию
+            if(auto office_width = map_config_obj.find("officeWidth"sv); office_width != map_config_obj.end()) {
+                map.SetOfficeWidth(office_width->value().to_number<double>());
+            }
+
+            if(auto dog_width = map_config_obj.find("dogWidth"sv); dog_width != map_config_obj.end()) {
+                map.SetDogWidth(dog_width->value().to_number<double>());
+            }
+
+            if(auto cell_size = map_config_obj.find("collisionCellSize"sv); cell_size != map_config_obj.end()) {
+                map.SetCollisionCellSize(cell_size->value().to_number<double>());
+            }
+
             // Добавляем объекты на карту
             AddRoadsToMap(map, map_config);
             AddBuildingsToMap(map, map_config);
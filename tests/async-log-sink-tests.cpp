@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/sources/logger.hpp>
+#include <boost/log/sources/record_ostream.hpp>
+
+#include "../src/logging/async_sink.h"
+#include "../src/metrics/metrics.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    namespace logging = boost::log;
+    const std::string TAG = "[AsyncLogSink]"s;
+
+    void MessageFormatter(logging::record_view const& rec, logging::formatting_ostream& strm) {
+        strm << rec[logging::expressions::smessage];
+    }
+
+    std::vector<std::string> SplitLines(const std::string& text) {
+        std::vector<std::string> lines;
+        std::istringstream stream{text};
+        for(std::string line; std::getline(stream, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    TEST_CASE("Records of every thread are written in order", TAG) {
+        constexpr int THREADS = 4;
+        constexpr int RECORDS = 1000;
+        std::ostringstream out;
+        {
+            logger::AsyncLogRegistration registration{out, &MessageFormatter};
+            {
+                std::vector<std::jthread> threads;
+                for(int t = 0; t < THREADS; ++t) {
+                    threads.emplace_back([t] {
+                        logging::sources::logger lg;
+                        for(int i = 0; i < RECORDS; ++i) {
+                            BOOST_LOG(lg) << t << ' ' << i;
+                        }
+                    });
+                }
+            }
+            logging::core::get()->flush();
+
+            const auto lines = SplitLines(out.str());
+            REQUIRE(lines.size() == THREADS * RECORDS);
+            std::map<int, int> next;
+            for(const auto& line : lines) {
+                std::istringstream stream{line};
+                int t = 0;
+                int i = 0;
+                stream >> t >> i;
+                CHECK(next[t]++ == i);
+            }
+        }
+    }
+
+    TEST_CASE("Full buffer drops records instead of growing", TAG) {
+        std::atomic<bool> writer_busy{false};
+        std::atomic<bool> release{false};
+        std::ostringstream out;
+        // Поток вывода задерживается на первой записи, пока тест не заполнит буфер
+        auto formatter = [&](logging::record_view const& rec, logging::formatting_ostream& strm) {
+            writer_busy = true;
+            while(!release) {
+                std::this_thread::yield();
+            }
+            MessageFormatter(rec, strm);
+        };
+        logger::AsyncLogRegistration registration{out, formatter, 4};
+
+        const uint64_t dropped_before = metrics::GetServerMetrics().log_records_dropped.Value();
+        logging::sources::logger lg;
+        BOOST_LOG(lg) << "first";
+        while(!writer_busy) {
+            std::this_thread::yield();
+        }
+        for(int i = 0; i < 10; ++i) {
+            BOOST_LOG(lg) << "next " << i;
+        }
+        CHECK(metrics::GetServerMetrics().log_records_dropped.Value() - dropped_before == 6);
+
+        release = true;
+        registration.GetSink().flush();
+        CHECK(SplitLines(out.str()) == std::vector{"first"s, "next 0"s, "next 1"s, "next 2"s, "next 3"s});
+    }
+
+    TEST_CASE("Request sampler keeps every n-th request", TAG) {
+        int logged = 0;
+        logger::RequestSampler sampler{10};
+        for(int i = 0; i < 1000; ++i) {
+            logged += sampler.Sample() ? 1 : 0;
+        }
+        CHECK(logged == 100);
+        CHECK(logger::RequestSampler{1}.Sample());
+        CHECK_FALSE(logger::RequestSampler{0}.Sample());
+    }
+
+} // namespace catch_tests
@@ -4,9 +4,12 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
 #include "../physics/collision_detector.h"
+#include "../physics/parallel_collision_detector.h"
 
 #include <string>
 #include <memory>
+#include <random>
+#include <tuple>
 
 // Напишите здесь тесты для функции collision_detector::FindGatherEvents
 
@@ -191,4 +194,184 @@ namespace catch_tests {
 
 
     }
+
+    TEST_CASE("Removed item is not collected"s, TAG) {
+        collision_detector::ItemGathererProviderImpl provider;
+        provider.AddItem(7, collision_detector::Item{{6.5, 0}, 0.0});
+        provider.AddItem(8, collision_detector::Item{{12.5, 0}, 0.0});
+        provider.AddItem(9, collision_detector::Item{{18.5, 0}, 0.0});
+        provider.AddGatherer(0, collision_detector::Gatherer{{0, 0}, {22.5, 0}, 0.6});
+
+        CHECK(provider.RemoveItem(7));
+        CHECK_FALSE(provider.RemoveItem(7));
+        CHECK_FALSE(provider.ContainsItem(7));
+        CHECK(provider.ItemsCount() == 2);
+
+        auto events = collision_detector::FindGatherEvents(provider);
+
+        REQUIRE(events.size() == 2);
+        CHECK(events[0].item_id == 8);
+        CHECK(events[1].item_id == 9);
+    }
+
+    TEST_CASE("Contested item events are merged by time and gatherer id"s, TAG) {
+        collision_detector::ItemGathererProviderImpl provider;
+        // Предмет 0 задевают собиратели 5 и 2, предмет 1 - только собиратель 4, офис - собиратель 3
+        provider.AddItem(0, collision_detector::Item{{5, 0}, 0.0});
+        provider.AddItem(1, collision_detector::Item{{0, 20}, 0.0});
+        provider.AddItem(2, collision_detector::Item{{8, 10}, 0.0, collision_detector::BASE});
+        provider.AddGatherer(5, collision_detector::Gatherer{{0, 0}, {10, 0}, 0.6});
+        provider.AddGatherer(3, collision_detector::Gatherer{{0, 10}, {10, 10}, 0.6});
+        provider.AddGatherer(2, collision_detector::Gatherer{{4, 0}, {9, 0}, 0.6});
+        provider.AddGatherer(4, collision_detector::Gatherer{{0, 12}, {0, 40}, 0.6});
+        provider.AddGatherer(1, collision_detector::Gatherer{{10, -10}, {10, 10}, 0.6});
+
+        auto events = collision_detector::FindGatherEvents(provider);
+
+        REQUIRE(events.size() == 4);
+
+        // Собиратель 2 доходит до предмета раньше (time 0.2 против 0.5) и идет первым
+        auto first_2 = std::find_if(events.begin(), events.end(), [](const auto& e) { return e.gatherer_id == 2; });
+        auto first_5 = std::find_if(events.begin(), events.end(), [](const auto& e) { return e.gatherer_id == 5; });
+        REQUIRE(first_2 != events.end());
+        REQUIRE(first_5 != events.end());
+        CHECK(first_2 < first_5);
+        CHECK(first_2->item_id == 0);
+        CHECK(first_5->item_id == 0);
+
+        // События каждого собирателя упорядочены по времени
+        for(size_t i = 1; i < events.size(); ++i) {
+            if(events[i].gatherer_id == events[i - 1].gatherer_id) {
+                CHECK(events[i - 1].time <= events[i].time);
+            }
+        }
+    }
+
+    TEST_CASE("Items with different widths are collected by own radius after cell size change"s, TAG) {
+        collision_detector::ItemGathererProviderImpl provider;
+        // Собиратель проходит в 0.8 от всех предметов: точечный трофей не задевает, широкие - задевает
+        provider.AddItem(0, collision_detector::Item{{5, 0.8}, 0.0});
+        provider.AddItem(1, collision_detector::Item{{7, 0.8}, 0.5});
+        provider.AddItem(2, collision_detector::Item{{9, 0.8}, 0.6, collision_detector::BASE});
+        provider.SetCellSize(2.0);
+        provider.AddGatherer(0, collision_detector::Gatherer{{0, 0}, {10, 0}, 0.4});
+
+        auto events = collision_detector::FindGatherEvents(provider);
+
+        REQUIRE(events.size() == 2);
+        CHECK(events[0].item_id == 1);
+        CHECK(events[0].actor == collision_detector::MOVE_BAG);
+        CHECK(events[1].item_id == 2);
+        CHECK(events[1].actor == collision_detector::MOVE_BASE);
+    }
+
+    TEST_CASE("Grid broad phase finds the same events as full search"s, TAG) {
+        std::mt19937 gen{42};
+        std::uniform_real_distribution<double> coord{0.0, 100.0};
+        std::uniform_real_distribution<double> step{-5.0, 5.0};
+
+        // Мелкая сетка против одной большой ячейки (полный перебор)
+        collision_detector::ItemGathererProviderImpl grid_provider{std::pmr::get_default_resource(), 1.0};
+        collision_detector::ItemGathererProviderImpl full_provider{std::pmr::get_default_resource(), 1e6};
+
+        for(size_t i = 0; i < 500; ++i) {
+            collision_detector::Item item{{coord(gen), coord(gen)}, i % 3 == 0 ? 0.5 : 0.0};
+            grid_provider.AddItem(i, item);
+            full_provider.AddItem(i, item);
+        }
+
+        // Удаляем часть предметов, чтобы проверить перестановку индексов
+        for(size_t i = 0; i < 500; i += 7) {
+            grid_provider.RemoveItem(i);
+            full_provider.RemoveItem(i);
+        }
+
+        for(size_t g = 0; g < 100; ++g) {
+            geom::Point2D start{coord(gen), coord(gen)};
+            collision_detector::Gatherer gatherer{start, {start.x + step(gen), start.y + step(gen)}, 0.6};
+            grid_provider.AddGatherer(g, gatherer);
+            full_provider.AddGatherer(g, gatherer);
+        }
+
+        auto grid_events = collision_detector::FindGatherEvents(grid_provider);
+        auto full_events = collision_detector::FindGatherEvents(full_provider);
+
+        auto by_key = [](const collision_detector::GatheringEvent& lhs, const collision_detector::GatheringEvent& rhs) {
+            return std::tie(lhs.gatherer_id, lhs.item_id) < std::tie(rhs.gatherer_id, rhs.item_id);
+        };
+        std::sort(grid_events.begin(), grid_events.end(), by_key);
+        std::sort(full_events.begin(), full_events.end(), by_key);
+
+        REQUIRE(grid_events.size() == full_events.size());
+        CHECK(grid_events.size() > 0);
+
+        for(size_t i = 0; i < grid_events.size(); ++i) {
+            CHECK(grid_events[i].gatherer_id == full_events[i].gatherer_id);
+            CHECK(grid_events[i].item_id == full_events[i].item_id);
+        }
+    }
+
+    // Плотная сессия: собиратели часто задевают одни и те же предметы
+    void FillDenseSession(collision_detector::ItemGathererProviderImpl& provider, size_t gatherers_count) {
+        std::mt19937 gen{7};
+        std::uniform_real_distribution<double> coord{0.0, 30.0};
+        std::uniform_real_distribution<double> step{-3.0, 3.0};
+
+        for(size_t i = 0; i < 300; ++i) {
+            collision_detector::Item item{{coord(gen), coord(gen)}, 0.0
+                                        , i % 10 == 0 ? collision_detector::BASE : collision_detector::LOST_OBJ};
+            provider.AddItem(i, item);
+        }
+
+        for(size_t g = 0; g < gatherers_count; ++g) {
+            geom::Point2D start{coord(gen), coord(gen)};
+            // Часть собирателей стоит на месте
+            geom::Point2D end = g % 13 == 0 ? start : geom::Point2D{start.x + step(gen), start.y + step(gen)};
+            provider.AddGatherer(g * 3 + 1, collision_detector::Gatherer{start, end, 0.6});
+        }
+    }
+
+    void CheckSameEvents(const std::pmr::vector<collision_detector::GatheringEvent>& lhs
+                        , const std::pmr::vector<collision_detector::GatheringEvent>& rhs) {
+        REQUIRE(lhs.size() == rhs.size());
+
+        for(size_t i = 0; i < lhs.size(); ++i) {
+            CHECK(lhs[i].item_id == rhs[i].item_id);
+            CHECK(lhs[i].gatherer_id == rhs[i].gatherer_id);
+            CHECK(lhs[i].time == rhs[i].time);
+            CHECK(lhs[i].sq_distance == rhs[i].sq_distance);
+            CHECK(lhs[i].actor == rhs[i].actor);
+        }
+    }
+
+    TEST_CASE("Parallel search finds the same events as single-threaded"s, TAG) {
+        collision_detector::ItemGathererProviderImpl provider;
+        FillDenseSession(provider, 400);
+
+        size_t expected_pairs = 0;
+        auto expected = collision_detector::FindGatherEvents(provider, std::pmr::get_default_resource(), &expected_pairs);
+        CHECK(expected.size() > 0);
+        CHECK(expected_pairs >= expected.size());
+
+        for(size_t threads : {2u, 3u, 4u, 7u}) {
+            collision_detector::ParallelGatherEventsFinder finder{threads, 1};
+
+            // Повторный вызов проверяет переиспользование буферов потоков
+            for(int i = 0; i < 2; ++i) {
+                size_t actual_pairs = 0;
+                auto actual = finder.FindGatherEvents(provider, std::pmr::get_default_resource(), &actual_pairs);
+                CheckSameEvents(expected, actual);
+                CHECK(actual_pairs == expected_pairs);
+            }
+        }
+    }
+
+    TEST_CASE("Parallel search falls back to single thread on small sessions"s, TAG) {
+        collision_detector::ItemGathererProviderImpl provider;
+        FillDenseSession(provider, 10);
+
+        collision_detector::ParallelGatherEventsFinder finder{4};
+        CHECK(finder.ThreadsCount() == 4);
+        CheckSameEvents(collision_detector::FindGatherEvents(provider), finder.FindGatherEvents(provider));
+    }
  } // namespace catch_tests
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include "../src/database/connection_pool.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    const std::string TAG = "[ConnectionPool]"s;
+
+    // Соединение, которое можно "оборвать"
+    struct FakeConnection {
+        bool is_open() const noexcept {
+            return open;
+        }
+
+        bool open = true;
+    };
+
+    using Pool = db::BasicConnectionPool<FakeConnection>;
+
+    // Фабрика соединений, которая считает созданные соединения и может "не достучаться" до сервера
+    struct FakeServer {
+        Pool::ConnectionFactory Factory() {
+            return [this] {
+                if(!available) {
+                    throw std::runtime_error("server is down"s);
+                }
+                ++created;
+                return std::make_shared<FakeConnection>();
+            };
+        }
+
+        bool available = true;
+        size_t created = 0;
+    };
+
+    TEST_CASE("Async acquisition waits for a returned connection without blocking"s, TAG) {
+        FakeServer server;
+        Pool pool{1, server.Factory()};
+        boost::asio::io_context ioc;
+
+        std::optional<Pool::ConnectionWrapper> held = pool.GetConnection();
+        std::optional<std::error_code> result;
+        std::optional<Pool::ConnectionWrapper> received;
+
+        pool.AsyncGetConnection(ioc.get_executor(), 1000ms, [&](std::error_code ec, Pool::ConnectionWrapper conn) {
+            result = ec;
+            received.emplace(std::move(conn));
+        });
+
+        ioc.poll();
+        CHECK_FALSE(result);
+        CHECK(pool.GetMetrics().waiting == 1);
+
+        held.reset();
+        ioc.run_for(100ms);
+
+        REQUIRE(result);
+        CHECK_FALSE(*result);
+        REQUIRE(received);
+        CHECK(static_cast<bool>(*received));
+
+        const auto metrics = pool.GetMetrics();
+        CHECK(metrics.acquired == 2);
+        CHECK(metrics.in_use == 1);
+        CHECK(metrics.waiting == 0);
+        CHECK(metrics.timeouts == 0);
+    }
+
+    TEST_CASE("Acquisition times out when all connections are busy"s, TAG) {
+        FakeServer server;
+        Pool pool{1, server.Factory()};
+        boost::asio::io_context ioc;
+
+        auto held = pool.GetConnection();
+        std::optional<std::error_code> result;
+        bool received = true;
+
+        pool.AsyncGetConnection(ioc.get_executor(), 20ms, [&](std::error_code ec, Pool::ConnectionWrapper conn) {
+            result = ec;
+            received = static_cast<bool>(conn);
+        });
+
+        ioc.run_for(1s);
+
+        REQUIRE(result);
+        CHECK(*result == std::errc::timed_out);
+        CHECK_FALSE(received);
+
+        CHECK_THROWS_AS(pool.GetConnection(10ms), db_ex::ConnectionTimeout);
+
+        const auto metrics = pool.GetMetrics();
+        CHECK(metrics.timeouts == 2);
+        CHECK(metrics.waiting == 0);
+        CHECK(metrics.in_use == 1);
+    }
+
+    TEST_CASE("Broken connections are reopened before being handed out"s, TAG) {
+        FakeServer server;
+        Pool pool{1, server.Factory()};
+        REQUIRE(server.created == 1);
+
+        {
+            auto conn = pool.GetConnection();
+            conn->open = false;
+        }
+
+        {
+            auto conn = pool.GetConnection();
+            CHECK(conn->is_open());
+            CHECK(server.created == 2);
+        }
+
+        // Сервер недоступен: ошибка доходит до вызывающего, а соединение остается в пуле
+        pool.GetConnection()->open = false;
+        server.available = false;
+        CHECK_THROWS(pool.GetConnection());
+
+        boost::asio::io_context ioc;
+        std::optional<std::error_code> result;
+        pool.AsyncGetConnection(ioc.get_executor(), 100ms, [&](std::error_code ec, Pool::ConnectionWrapper conn) {
+            result = ec;
+            CHECK_FALSE(conn);
+        });
+        ioc.run();
+
+        REQUIRE(result);
+        CHECK(*result == std::errc::connection_refused);
+
+        server.available = true;
+        CHECK(pool.GetConnection()->is_open());
+
+        const auto metrics = pool.GetMetrics();
+        CHECK(metrics.reconnects == 2);
+        CHECK(metrics.failed_reconnects == 2);
+        CHECK(metrics.in_use == 0);
+    }
+
+    TEST_CASE("Sync and async requests get connections in arrival order"s, TAG) {
+        FakeServer server;
+        Pool pool{1, server.Factory()};
+        boost::asio::io_context ioc;
+
+        std::optional<Pool::ConnectionWrapper> held = pool.GetConnection();
+
+        // Первым в очередь встает синхронный запрос, за ним асинхронный
+        std::atomic_bool sync_received = false;
+        std::jthread sync_client{[&] {
+            auto conn = pool.GetConnection(5s);
+            sync_received = true;
+        }};
+        while(pool.GetMetrics().waiting == 0) {
+            std::this_thread::yield();
+        }
+
+        std::optional<std::error_code> async_result;
+        std::optional<Pool::ConnectionWrapper> async_conn;
+        pool.AsyncGetConnection(ioc.get_executor(), 5s, [&](std::error_code ec, Pool::ConnectionWrapper conn) {
+            async_result = ec;
+            async_conn.emplace(std::move(conn));
+        });
+        ioc.poll();
+        CHECK(pool.GetMetrics().waiting == 2);
+
+        // Освободившееся соединение достается синхронному запросу, хотя асинхронный тоже ждет
+        held.reset();
+        sync_client.join();
+        CHECK(sync_received);
+
+        // Синхронный клиент вернул соединение - теперь его получает асинхронный запрос
+        ioc.run_for(100ms);
+        REQUIRE(async_result);
+        CHECK_FALSE(*async_result);
+        CHECK(static_cast<bool>(*async_conn));
+        CHECK(pool.GetMetrics().acquired == 3);
+    }
+
+    TEST_CASE("Many async requests share a small pool across io threads"s, TAG) {
+        FakeServer server;
+        Pool pool{2, server.Factory()};
+        boost::asio::thread_pool ioc{4};
+
+        const size_t requests = 200;
+        std::atomic_size_t completed = 0;
+        std::atomic_size_t failed = 0;
+        std::atomic_size_t in_use = 0;
+        std::atomic_size_t max_in_use = 0;
+
+        for(size_t i = 0; i < requests; ++i) {
+            pool.AsyncGetConnection(ioc.get_executor(), 5s, [&](std::error_code ec, Pool::ConnectionWrapper conn) {
+                if(ec) {
+                    ++failed;
+                    ++completed;
+                    return;
+                }
+
+                const size_t now = ++in_use;
+                size_t prev = max_in_use;
+                while(prev < now && !max_in_use.compare_exchange_weak(prev, now)) {
+                }
+
+                // "Медленный запрос": соединение удерживается до срабатывания таймера, поток не блокируется
+                auto timer = std::make_shared<boost::asio::steady_timer>(ioc.get_executor(), 1ms);
+                timer->async_wait([&, timer, conn = std::move(conn)](const boost::system::error_code&) mutable {
+                    --in_use;
+                    ++completed;
+                });
+            });
+        }
+
+        ioc.join();
+
+        CHECK(completed == requests);
+        CHECK(failed == 0);
+        CHECK(max_in_use <= 2);
+
+        const auto metrics = pool.GetMetrics();
+        CHECK(metrics.acquired == requests);
+        CHECK(metrics.in_use == 0);
+        CHECK(metrics.max_wait > std::chrono::nanoseconds::zero());
+    }
+
+} // namespace catch_tests
@@ -0,0 +1,239 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/database/embedded_records.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    const std::string TAG = "[EmbeddedRecords]"s;
+
+    std::filesystem::path LogPath(const std::string& name) {
+        auto path = std::filesystem::temp_directory_path() / ("embedded_records_"s + name + ".log"s);
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    std::vector<domain::PlayerRecord> MakeRandomRecords(size_t count, unsigned seed) {
+        std::mt19937 gen{seed};
+        std::uniform_int_distribution<size_t> score{0, 30};
+        std::uniform_int_distribution<int64_t> play_time{0, 10};
+        std::vector<domain::PlayerRecord> records;
+
+        for(size_t i = 0; i < count; ++i) {
+            records.emplace_back("dog "s + std::to_string(seed) + "-"s + std::to_string(i), score(gen), play_time(gen)
+                               , seed * 1'000 + i + 1);
+        }
+
+        return records;
+    }
+
+    void CheckSameRecords(const std::vector<domain::PlayerRecord>& lhs, const std::vector<domain::PlayerRecord>& rhs) {
+        REQUIRE(lhs.size() == rhs.size());
+
+        for(size_t i = 0; i < lhs.size(); ++i) {
+            CHECK(lhs[i].GetName() == rhs[i].GetName());
+            CHECK(lhs[i].GetScore() == rhs[i].GetScore());
+            CHECK(lhs[i].GetPlayTime() == rhs[i].GetPlayTime());
+            CHECK(lhs[i].GetId() == rhs[i].GetId());
+        }
+    }
+
+    TEST_CASE("Embedded records keep table order and survive reopening"s, TAG) {
+        const auto path = LogPath("order"s);
+        std::vector<domain::PlayerRecord> all;
+        {
+            embedded::PlayerRecordRepositoryImpl repository{path};
+
+            for(unsigned seed = 1; seed <= 5; ++seed) {
+                auto batch = MakeRandomRecords(40, seed);
+                repository.SaveRecordsTable(batch);
+                all.insert(all.end(), batch.begin(), batch.end());
+            }
+        }
+        std::stable_sort(all.begin(), all.end(), domain::IsRecordBefore);
+
+        embedded::PlayerRecordRepositoryImpl repository{path};
+        REQUIRE(repository.Size() == all.size());
+
+        CheckSameRecords(repository.GetRecordsTable(0, 1000), all);
+        CheckSameRecords(repository.GetRecordsTable(150, 100), std::vector(all.begin() + 150, all.end()));
+        CHECK(repository.GetRecordsTable(500, 10).empty());
+
+        // Продолжение после записи совпадает со смещением на следующую позицию
+        for(size_t pos : {0u, 17u, 99u, 198u}) {
+            CheckSameRecords(repository.GetRecordsTableAfter(all[pos], 0, 20), repository.GetRecordsTable(pos + 1, 20));
+        }
+    }
+
+    TEST_CASE("Table larger than an index block keeps order across batches"s, TAG) {
+        embedded::PlayerRecordRepositoryImpl repository{{}};
+        std::vector<domain::PlayerRecord> all;
+
+        for(unsigned seed = 1; seed <= 8; ++seed) {
+            auto batch = MakeRandomRecords(embedded::RECORDS_BLOCK_SIZE / 2 + 100, seed);
+            repository.SaveRecordsTable(batch);
+            all.insert(all.end(), batch.begin(), batch.end());
+        }
+        std::stable_sort(all.begin(), all.end(), domain::IsRecordBefore);
+
+        REQUIRE(repository.Size() == all.size());
+        CheckSameRecords(repository.GetRecordsTable(0, all.size()), all);
+
+        // Страницы на границах блоков и за концом таблицы
+        for(size_t pos : {0u, 1023u, 1024u, 2047u, 3000u, 4879u}) {
+            const auto end = all.begin() + static_cast<std::ptrdiff_t>(std::min(pos + 50, all.size()));
+            CheckSameRecords(repository.GetRecordsTable(pos, 50), std::vector(all.begin() + pos, end));
+            CheckSameRecords(repository.GetRecordsTableAfter(all[pos], 3, 50), repository.GetRecordsTable(pos + 4, 50));
+        }
+        CHECK(repository.GetRecordsTable(all.size(), 10).empty());
+    }
+
+    TEST_CASE("Torn record at the end of the log is dropped"s, TAG) {
+        const auto path = LogPath("torn"s);
+        {
+            embedded::PlayerRecordRepositoryImpl repository{path};
+            repository.SaveRecordsTable(MakeRandomRecords(3, 7));
+        }
+
+        // Имитируем сбой во время дозаписи: в файле только начало следующей записи
+        {
+            std::ofstream out{path, std::ios::binary | std::ios::app};
+            out << "\x05\x00\x00"s;
+        }
+
+        {
+            std::vector<std::string> errors;
+            embedded::PlayerRecordRepositoryImpl repository{path, [&errors](const std::string& message) {
+                errors.push_back(message);
+            }};
+            CHECK(repository.Size() == 3);
+            // Отрезанные байты не пропадают молча
+            REQUIRE(errors.size() == 1);
+            CHECK(errors.front().find("Dropped 3 bytes"s) != std::string::npos);
+            repository.SaveRecordsTable({domain::PlayerRecord{"Rex"s, 100, 5, 1}});
+        }
+
+        embedded::PlayerRecordRepositoryImpl repository{path};
+        REQUIRE(repository.Size() == 4);
+        CHECK(repository.GetRecordsTable(0, 1).front().GetName() == "Rex"s);
+    }
+
+    TEST_CASE("Corrupt record in the middle of the log stops opening"s, TAG) {
+        const auto path = LogPath("corrupt"s);
+        {
+            embedded::PlayerRecordRepositoryImpl repository{path};
+            repository.SaveRecordsTable(MakeRandomRecords(5, 9));
+        }
+
+        // Портим байт имени второй записи: следующие записи целы и не должны быть отброшены
+        const auto size = std::filesystem::file_size(path);
+        {
+            std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+            file.seekp(static_cast<std::streamoff>(embedded::RECORDS_LOG_MAGIC.size() + (size - embedded::RECORDS_LOG_MAGIC.size()) / 5 + 30));
+            file.put('#');
+        }
+
+        CHECK_THROWS_AS(embedded::PlayerRecordRepositoryImpl{path}, std::runtime_error);
+        // Файл не отрезан и не дописан
+        CHECK(std::filesystem::file_size(path) == size);
+    }
+
+    TEST_CASE("Record with a full header cut by the end of the log is dropped"s, TAG) {
+        const auto path = LogPath("torn_body"s);
+        {
+            embedded::PlayerRecordRepositoryImpl repository{path};
+            repository.SaveRecordsTable(MakeRandomRecords(4, 8));
+        }
+
+        // Последняя запись записана без конца имени и контрольной суммы
+        const auto size = std::filesystem::file_size(path);
+        std::filesystem::resize_file(path, size - 6);
+
+        std::vector<std::string> errors;
+        embedded::PlayerRecordRepositoryImpl repository{path, [&errors](const std::string& message) {
+            errors.push_back(message);
+        }};
+        CHECK(repository.Size() == 3);
+        CHECK(errors.size() == 1);
+    }
+
+    TEST_CASE("Name size reaching past the end of the log is corruption when whole records follow"s, TAG) {
+        const auto path = LogPath("corrupt_size"s);
+        std::streamoff second = 0;
+        {
+            embedded::PlayerRecordRepositoryImpl repository{path};
+            const auto batch = MakeRandomRecords(5, 9);
+            repository.SaveRecordsTable(batch);
+            // Запись: 32 байта заголовка и контрольной суммы плюс имя
+            second = static_cast<std::streamoff>(embedded::RECORDS_LOG_MAGIC.size() + 32 + batch.front().GetName().size());
+        }
+
+        // Длина имени второй записи (в пределах наибольшей) уводит запись за конец файла,
+        // хотя за ней еще три целые записи
+        const auto size = std::filesystem::file_size(path);
+        {
+            std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+            file.seekp(second + 24);
+            file.put('\x00');
+            file.put('\x0F');
+        }
+
+        CHECK_THROWS_AS(embedded::PlayerRecordRepositoryImpl{path}, std::runtime_error);
+        CHECK(std::filesystem::file_size(path) == size);
+    }
+
+    TEST_CASE("Records with saved ids are not added again"s, TAG) {
+        const auto path = LogPath("repeat"s);
+        const auto batch = MakeRandomRecords(10, 3);
+        {
+            embedded::PlayerRecordRepositoryImpl repository{path};
+            repository.SaveRecordsTable(batch);
+            // Повтор пачки после сбоя (часть записей уже сохранена)
+            auto repeated = MakeRandomRecords(15, 3);
+            repository.SaveRecordsTable(repeated);
+            CHECK(repository.Size() == 15);
+            CHECK(repository.GetLastRecordId() == 3'015);
+        }
+
+        embedded::PlayerRecordRepositoryImpl repository{path};
+        CHECK(repository.Size() == 15);
+        CHECK(repository.GetLastRecordId() == 3'015);
+    }
+
+    TEST_CASE("Records table without log path lives in memory only"s, TAG) {
+        db_conn_settings::DbConnectrioSettings settings;
+        settings.records_storage = db_conn_settings::RecordsStorage::MEMORY;
+        settings.records_log = LogPath("memory"s).string();
+
+        embedded::Database database{settings};
+        auto& repository = database.GetPlayerRecords();
+        CHECK(repository.Size() == 0);
+
+        auto all = MakeRandomRecords(30, 7);
+        repository.SaveRecordsTable(all);
+        std::stable_sort(all.begin(), all.end(), domain::IsRecordBefore);
+
+        CheckSameRecords(repository.GetRecordsTable(0, 100), all);
+        CheckSameRecords(repository.GetRecordsTableAfter(all[9], 0, 5), repository.GetRecordsTable(10, 5));
+        // Путь из настроек не используется: файл не создается
+        CHECK_FALSE(std::filesystem::exists(settings.records_log));
+    }
+
+    TEST_CASE("Log with unknown header is rejected"s, TAG) {
+        const auto path = LogPath("foreign"s);
+        {
+            std::ofstream out{path, std::ios::binary};
+            out << "not a records log"s;
+        }
+
+        CHECK_THROWS(embedded::PlayerRecordRepositoryImpl{path});
+    }
+
+} // namespace catch_tests
@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/work_with_json/json_loader.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    const std::string TAG = "[JsonLoader]"s;
+
+    // Конфигурация с двумя картами: на первой заданы все параметры столкновений,
+    // на второй ни одного - для нее действуют значения по умолчанию
+    const std::string COLLISION_CONFIG = R"({
+        "defaultDogSpeed": 3.0,
+        "lootGeneratorConfig": {"period": 5.0, "probability": 0.5},
+        "maps": [
+            {
+                "id": "custom", "name": "Custom widths",
+                "officeWidth": 0.9, "dogWidth": 0.4, "collisionCellSize": 5,
+                "roads": [{"x0": 0, "y0": 0, "x1": 40}],
+                "buildings": [],
+                "offices": [{"id": "o0", "x": 40, "y": 0, "offsetX": 5, "offsetY": 0}],
+                "lootTypes": [
+                    {"name": "key", "file": "key.obj", "type": "obj", "scale": 0.03, "value": 10, "width": 0.7},
+                    {"name": "wallet", "file": "wallet.obj", "type": "obj", "scale": 0.01, "value": 30, "width": 1.5}
+                ]
+            },
+            {
+                "id": "default", "name": "Default widths",
+                "roads": [{"x0": 0, "y0": 0, "y1": 20}],
+                "buildings": [],
+                "offices": [{"id": "o0", "x": 0, "y": 20, "offsetX": 0, "offsetY": 5}],
+                "lootTypes": [
+                    {"name": "key", "file": "key.obj", "type": "obj", "scale": 0.03, "value": 10}
+                ]
+            }
+        ]
+    })"s;
+
+    std::filesystem::path WriteConfig(const std::string& name, const std::string& text) {
+        auto path = std::filesystem::temp_directory_path() / ("json_loader_"s + name + ".json"s);
+        std::ofstream out{path};
+        out << text;
+        return path;
+    }
+
+    TEST_CASE("Collision widths and cell size are read from map and loot type keys"s, TAG) {
+        const model::Game game = json_loader::LoadGame(WriteConfig("collision"s, COLLISION_CONFIG));
+
+        const model::Map* map = game.FindMap(model::Map::Id{"custom"s});
+        REQUIRE(map != nullptr);
+
+        CHECK(map->GetOfficeWidth() == 0.9);
+        CHECK(map->GetDogWidth() == 0.4);
+        CHECK(map->GetCollisionCellSize() == 5.0);
+
+        REQUIRE(map->GetLootTypes().size() == 2);
+        CHECK(map->GetLootWidth(0) == 0.7);
+        CHECK(map->GetLootWidth(1) == 1.5);
+        CHECK(map->GetMaxLootWidth() == 1.5);
+    }
+
+    TEST_CASE("Missing collision keys leave game defaults and point-sized loot"s, TAG) {
+        const model::Game game = json_loader::LoadGame(WriteConfig("collision"s, COLLISION_CONFIG));
+
+        const model::Map* map = game.FindMap(model::Map::Id{"default"s});
+        REQUIRE(map != nullptr);
+
+        // Ширины не заданы - CollisionManager берет значения игры по умолчанию,
+        // а размер ячейки вычисляет по радиусам подбора
+        CHECK_FALSE(map->GetOfficeWidth());
+        CHECK_FALSE(map->GetDogWidth());
+        CHECK_FALSE(map->GetCollisionCellSize());
+
+        REQUIRE(map->GetLootTypes().size() == 1);
+        CHECK(map->GetLootWidth(0) == 0.0);
+        CHECK(map->GetMaxLootWidth() == 0.0);
+        // Неизвестный тип трофея - тоже точка
+        CHECK(map->GetLootWidth(5) == 0.0);
+    }
+
+} // namespace catch_tests
@@ -0,0 +1,285 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include "../src/database/leaderboard.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    const std::string TAG = "[Leaderboard]"s;
+
+    // Таблица рекордов в памяти, повторяющая запросы PostgreSQL
+    class FakeRecordsStorage : public db_storage::UseCases {
+    public:
+        void AddPlayerRecords(const std::vector<domain::PlayerRecord>& player_records) override {
+            records_.insert(records_.end(), player_records.begin(), player_records.end());
+            std::stable_sort(records_.begin(), records_.end(), domain::IsRecordBefore);
+        }
+
+        std::vector<domain::PlayerRecord> GetRecordsTable(size_t offset, size_t limit) override {
+            ++queries_;
+            return Slice(records_.begin(), offset, limit);
+        }
+
+        std::vector<domain::PlayerRecord> GetRecordsTableAfter(const domain::PlayerRecord& after
+                                                            , size_t offset, size_t limit) override {
+            ++queries_;
+            auto first = std::upper_bound(records_.begin(), records_.end(), after, domain::IsRecordBefore);
+            return Slice(first, offset, limit);
+        }
+
+        void AsyncGetRecordsTableAfter(const domain::PlayerRecord& after, size_t offset, size_t limit
+                                     , const boost::asio::any_io_executor& executor
+                                     , domain::RecordsHandler handler) override {
+            ++async_queries_;
+            boost::asio::post(executor, [handler = std::move(handler), records = GetRecordsTableAfter(after, offset, limit)] {
+                handler(nullptr, records);
+            });
+        }
+
+        uint64_t GetLastRecordId() override {
+            uint64_t last_id = 0;
+            for(const auto& record : records_) {
+                last_id = std::max(last_id, record.GetId());
+            }
+            return last_id;
+        }
+
+        size_t Queries() const noexcept {
+            return queries_;
+        }
+
+        size_t AsyncQueries() const noexcept {
+            return async_queries_;
+        }
+
+    private:
+        using Iterator = std::vector<domain::PlayerRecord>::const_iterator;
+
+        std::vector<domain::PlayerRecord> Slice(Iterator first, size_t offset, size_t limit) const {
+            const size_t available = static_cast<size_t>(records_.end() - first);
+            offset = std::min(offset, available);
+            return {first + offset, first + offset + std::min(limit, available - offset)};
+        }
+
+        std::vector<domain::PlayerRecord> records_;
+        size_t queries_ = 0;
+        size_t async_queries_ = 0;
+    };
+
+    // Результат асинхронного запроса к таблице лидеров (обработчик вызывается на io_context)
+    template <typename Request>
+    std::vector<domain::PlayerRecord> Run(Request&& request) {
+        boost::asio::io_context ioc;
+        std::vector<domain::PlayerRecord> result;
+        std::exception_ptr result_error;
+        bool called = false;
+
+        request(ioc.get_executor(), [&](std::exception_ptr error, std::vector<domain::PlayerRecord> records) {
+            called = true;
+            result_error = error;
+            result = std::move(records);
+        });
+        // Обработчик не вызывается изнутри запроса
+        REQUIRE_FALSE(called);
+        ioc.run();
+
+        REQUIRE(called);
+        if(result_error) {
+            std::rethrow_exception(result_error);
+        }
+        return result;
+    }
+
+    std::vector<domain::PlayerRecord> GetRecords(const db_storage::Leaderboard& leaderboard, size_t offset, size_t limit) {
+        return Run([&](const auto& executor, auto handler) {
+            leaderboard.GetRecords(offset, limit, executor, std::move(handler));
+        });
+    }
+
+    std::vector<domain::PlayerRecord> GetRecordsAfter(const db_storage::Leaderboard& leaderboard
+                                                    , const domain::PlayerRecord& after, size_t limit) {
+        return Run([&](const auto& executor, auto handler) {
+            leaderboard.GetRecordsAfter(after, limit, executor, std::move(handler));
+        });
+    }
+
+    std::vector<domain::PlayerRecord> MakeRandomRecords(size_t count, unsigned seed) {
+        std::mt19937 gen{seed};
+        std::uniform_int_distribution<size_t> score{0, 50};
+        std::uniform_int_distribution<int64_t> play_time{0, 20};
+        std::vector<domain::PlayerRecord> records;
+
+        for(size_t i = 0; i < count; ++i) {
+            records.emplace_back("dog "s + std::to_string(seed) + "-"s + std::to_string(i), score(gen), play_time(gen)
+                               , seed * 1'000 + i + 1);
+        }
+
+        return records;
+    }
+
+    void CheckSameRecords(const std::vector<domain::PlayerRecord>& lhs, const std::vector<domain::PlayerRecord>& rhs) {
+        REQUIRE(lhs.size() == rhs.size());
+
+        for(size_t i = 0; i < lhs.size(); ++i) {
+            CHECK(lhs[i].GetName() == rhs[i].GetName());
+            CHECK(lhs[i].GetScore() == rhs[i].GetScore());
+            CHECK(lhs[i].GetPlayTime() == rhs[i].GetPlayTime());
+            CHECK(lhs[i].GetId() == rhs[i].GetId());
+        }
+    }
+
+    TEST_CASE("Top records are served from memory after warm up and updates"s, TAG) {
+        FakeRecordsStorage storage;
+        storage.AddPlayerRecords(MakeRandomRecords(30, 1));
+
+        db_storage::Leaderboard leaderboard{storage, 100};
+        leaderboard.Warm();
+
+        // Новые записи попадают и в БД (через очередь записи), и в таблицу лидеров
+        const auto added = MakeRandomRecords(20, 2);
+        storage.AddPlayerRecords(added);
+        leaderboard.Add(added);
+
+        const size_t queries_before = storage.Queries();
+        const auto expected = storage.GetRecordsTable(0, 100);
+
+        CheckSameRecords(GetRecords(leaderboard, 0, 100), expected);
+        CheckSameRecords(GetRecords(leaderboard, 45, 10), std::vector(expected.begin() + 45, expected.end()));
+        CHECK(GetRecords(leaderboard, 60, 10).empty());
+        // Единственный запрос к БД - получение ожидаемого результата
+        CHECK(storage.Queries() == queries_before + 1);
+        CHECK(storage.AsyncQueries() == 0);
+    }
+
+    TEST_CASE("Records beyond capacity are requested from database after the last one in memory"s, TAG) {
+        FakeRecordsStorage storage;
+        storage.AddPlayerRecords(MakeRandomRecords(200, 3));
+
+        db_storage::Leaderboard leaderboard{storage, 50};
+        leaderboard.Warm();
+
+        for(unsigned seed = 4; seed < 10; ++seed) {
+            const auto added = MakeRandomRecords(15, seed);
+            storage.AddPlayerRecords(added);
+            leaderboard.Add(added);
+        }
+
+        CHECK(leaderboard.Size() == 50);
+
+        for(size_t offset : {0u, 30u, 49u, 50u, 120u, 280u, 400u}) {
+            const auto expected = storage.GetRecordsTable(offset, 40);
+            CheckSameRecords(GetRecords(leaderboard, offset, 40), expected);
+        }
+        // Записи дальше памяти запрашиваются у БД без блокировки потока
+        CHECK(storage.AsyncQueries() > 0);
+    }
+
+    TEST_CASE("Cursor pages match database pages in memory and beyond capacity"s, TAG) {
+        FakeRecordsStorage storage;
+        storage.AddPlayerRecords(MakeRandomRecords(150, 11));
+
+        db_storage::Leaderboard leaderboard{storage, 40};
+        leaderboard.Warm();
+
+        const auto added = MakeRandomRecords(30, 12);
+        storage.AddPlayerRecords(added);
+        leaderboard.Add(added);
+
+        // Проходим всю таблицу страницами, передавая последнюю запись страницы как курсор
+        const auto expected = storage.GetRecordsTable(0, 1000);
+        std::vector<domain::PlayerRecord> collected = GetRecords(leaderboard, 0, 7);
+
+        while(true) {
+            auto page = GetRecordsAfter(leaderboard, collected.back(), 7);
+            if(page.empty()) {
+                break;
+            }
+            CHECK(page.size() <= 7);
+            collected.insert(collected.end(), page.begin(), page.end());
+        }
+
+        CheckSameRecords(collected, expected);
+
+        // Курсор, которого нет в таблице, указывает место между записями
+        const domain::PlayerRecord cursor{"dog"s, 25, 10, 0};
+        CheckSameRecords(GetRecordsAfter(leaderboard, cursor, 20), storage.GetRecordsTableAfter(cursor, 0, 20));
+    }
+
+    TEST_CASE("Synchronous pages match asynchronous ones and query database on the calling thread"s, TAG) {
+        FakeRecordsStorage storage;
+        storage.AddPlayerRecords(MakeRandomRecords(120, 13));
+
+        db_storage::Leaderboard leaderboard{storage, 30};
+        leaderboard.Warm();
+
+        for(size_t offset : {0u, 25u, 30u, 90u, 200u}) {
+            CheckSameRecords(leaderboard.GetRecords(offset, 20), GetRecords(leaderboard, offset, 20));
+        }
+
+        const auto expected = storage.GetRecordsTable(0, 1000);
+        for(size_t pos : {0u, 28u, 29u, 70u, 119u}) {
+            CheckSameRecords(leaderboard.GetRecordsAfter(expected[pos], 15), GetRecordsAfter(leaderboard, expected[pos], 15));
+        }
+
+        const size_t async_before = storage.AsyncQueries();
+        leaderboard.GetRecords(50, 10);
+        leaderboard.GetRecordsAfter(expected[40], 10);
+        CHECK(storage.AsyncQueries() == async_before);
+    }
+
+    TEST_CASE("Records with equal score, play time and name are ordered by id"s, TAG) {
+        FakeRecordsStorage storage;
+        std::vector<domain::PlayerRecord> twins;
+        for(uint64_t id : {5u, 2u, 9u, 7u}) {
+            twins.emplace_back("Rex"s, 10, 100, id);
+        }
+        // Имена сравниваются побайтно: заглавные буквы раньше строчных независимо от локали
+        twins.emplace_back("rex"s, 10, 100, 1);
+        storage.AddPlayerRecords(twins);
+
+        db_storage::Leaderboard leaderboard{storage, 2};
+        leaderboard.Warm();
+
+        // Страницы по одной записи: на границе памяти и БД ни одна запись не теряется и не повторяется
+        std::vector<domain::PlayerRecord> collected = GetRecords(leaderboard, 0, 1);
+        while(true) {
+            auto page = GetRecordsAfter(leaderboard, collected.back(), 1);
+            if(page.empty()) {
+                break;
+            }
+            collected.insert(collected.end(), page.begin(), page.end());
+        }
+
+        REQUIRE(collected.size() == 5);
+        std::vector<uint64_t> ids;
+        for(const auto& record : collected) {
+            ids.push_back(record.GetId());
+        }
+        CHECK(ids == std::vector<uint64_t>{2, 5, 7, 9, 1});
+    }
+
+    TEST_CASE("Records cursor is parsed from score, play time, id and name"s, TAG) {
+        auto record = domain::ParseRecordCursor("120,3500,42,Pluto, the dog"sv);
+        REQUIRE(record);
+        CHECK(record->GetScore() == 120);
+        CHECK(record->GetPlayTime() == 3500);
+        CHECK(record->GetId() == 42);
+        CHECK(record->GetName() == "Pluto, the dog"s);
+
+        CHECK(domain::ParseRecordCursor("7,0,1,"sv)->GetName().empty());
+
+        for(auto bad : {""sv, "120"sv, "120,3500"sv, "120,3500,dog"sv, "x,1,1,dog"sv, "1,-5,1,dog"sv
+                        , "1,5,-1,dog"sv, "1;2;3;dog"sv, ",1,1,dog"sv}) {
+            CHECK_FALSE(domain::ParseRecordCursor(bad));
+        }
+    }
+
+} // namespace catch_tests
@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/metrics/metrics.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    const std::string TAG = "[Metrics]"s;
+
+    TEST_CASE("Counter sums increments of all threads", TAG) {
+        metrics::Counter counter;
+        {
+            std::vector<std::jthread> threads;
+            for(int i = 0; i < 16; ++i) {
+                threads.emplace_back([&counter] {
+                    for(int j = 0; j < 10'000; ++j) {
+                        counter.Add();
+                    }
+                });
+            }
+        }
+        counter.Add(5);
+        CHECK(counter.Value() == 160'005);
+    }
+
+    TEST_CASE("Disabled recording leaves counters and histograms unchanged", TAG) {
+        metrics::Counter counter;
+        metrics::Histogram histogram;
+
+        metrics::SetRecording(false);
+        counter.Add(3);
+        histogram.Record(10);
+        {
+            metrics::ScopedTimer timer{histogram};
+        }
+        metrics::SetRecording(true);
+
+        CHECK(counter.Value() == 0);
+        CHECK(histogram.Collect().count == 0);
+
+        counter.Add(3);
+        histogram.Record(10);
+        CHECK(counter.Value() == 3);
+        CHECK(histogram.Collect().count == 1);
+    }
+
+    TEST_CASE("Histogram buckets keep relative error within one sub-bucket", TAG) {
+        using metrics::Histogram;
+
+        SECTION("Small values get exact buckets") {
+            for(uint64_t value = 0; value < Histogram::SUB_BUCKETS; ++value) {
+                CHECK(Histogram::BucketUpperBound(Histogram::BucketIndex(value)) == value);
+            }
+        }
+
+        SECTION("Every value lies inside its bucket") {
+            for(uint64_t value = 1; value < 100'000; value = value * 3 / 2 + 1) {
+                const size_t index = Histogram::BucketIndex(value);
+                const uint64_t upper = Histogram::BucketUpperBound(index);
+                CHECK(value <= upper);
+                CHECK(upper - value <= value / Histogram::SUB_BUCKETS);
+                if(index > 0) {
+                    CHECK(Histogram::BucketUpperBound(index - 1) < value);
+                }
+            }
+        }
+
+        SECTION("Huge values go to the last bucket") {
+            CHECK(Histogram::BucketIndex(uint64_t{1} << 50) == Histogram::BUCKETS_COUNT - 1);
+        }
+    }
+
+    TEST_CASE("Histogram snapshot counts values and quantiles", TAG) {
+        metrics::Histogram histogram;
+        for(uint64_t value = 1; value <= 1000; ++value) {
+            histogram.Record(value);
+        }
+
+        const auto snapshot = histogram.Collect();
+        CHECK(snapshot.count == 1000);
+        CHECK(snapshot.sum == 500'500);
+        // Степени двойки - границы интервалов, для них счет точный
+        CHECK(snapshot.CountBelow(1) == 0);
+        CHECK(snapshot.CountBelow(16) == 15);
+        CHECK(snapshot.CountBelow(256) == 255);
+
+        const uint64_t median = snapshot.ValueAtQuantile(0.5);
+        CHECK(median >= 500);
+        CHECK(median <= 500 + 500 / metrics::Histogram::SUB_BUCKETS);
+        CHECK(metrics::Histogram{}.Collect().ValueAtQuantile(0.99) == 0);
+    }
+
+    TEST_CASE("Request targets are classified by endpoint", TAG) {
+        using metrics::ApiEndpoint;
+        using metrics::ClassifyTarget;
+
+        CHECK(ClassifyTarget("/api/v1/maps"sv) == ApiEndpoint::MAPS);
+        CHECK(ClassifyTarget("/api/v1/maps/"sv) == ApiEndpoint::MAPS);
+        CHECK(ClassifyTarget("/api/v1/maps/map1"sv) == ApiEndpoint::MAP);
+        CHECK(ClassifyTarget("/api/v1/game/state"sv) == ApiEndpoint::STATE);
+        CHECK(ClassifyTarget("/api/v1/game/records?start=0&maxItems=10"sv) == ApiEndpoint::RECORDS);
+        CHECK(ClassifyTarget("/api/v1/unknown"sv) == ApiEndpoint::OTHER_API);
+        CHECK(ClassifyTarget("/index.html"sv) == ApiEndpoint::STATIC);
+        CHECK(metrics::EndpointName(ApiEndpoint::ACTION) == "action"sv);
+    }
+
+    TEST_CASE("Prometheus exposition lists every family", TAG) {
+        metrics::ServerMetrics server_metrics;
+        server_metrics.ticks.Add(3);
+        server_metrics.tick_duration.Record(10);
+        server_metrics.Api(metrics::ApiEndpoint::STATE).duration.Record(100);
+        server_metrics.Api(metrics::ApiEndpoint::JOIN).errors.Add();
+
+        const std::string text = metrics::SerializePrometheus(server_metrics);
+        CHECK(text.find("# TYPE game_ticks_total counter\ngame_ticks_total 3\n"sv) != std::string::npos);
+        CHECK(text.find("game_tick_duration_seconds_bucket{le=\"0.000016\"} 1\n"sv) != std::string::npos);
+        CHECK(text.find("game_tick_duration_seconds_bucket{le=\"+Inf\"} 1\n"sv) != std::string::npos);
+        CHECK(text.find("game_tick_duration_seconds_sum 0.000010\n"sv) != std::string::npos);
+        CHECK(text.find("http_request_duration_seconds_count{endpoint=\"state\"} 1\n"sv) != std::string::npos);
+        CHECK(text.find("http_request_errors_total{endpoint=\"join\"} 1\n"sv) != std::string::npos);
+        CHECK(text.find("# TYPE records_flush_duration_seconds histogram\n"sv) != std::string::npos);
+        CHECK(text.find("# TYPE db_pool_wait_seconds histogram\n"sv) != std::string::npos);
+        CHECK(text.find("# TYPE db_pool_timeouts_total counter\n"sv) != std::string::npos);
+        CHECK(text.find("# TYPE game_save_captures_dropped_total counter\n"sv) != std::string::npos);
+    }
+
+} // namespace catch_tests
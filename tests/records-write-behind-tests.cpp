@@ -0,0 +1,245 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/database/records_write_behind.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    const std::string TAG = "[RecordsWriteBehind]"s;
+
+    // Хранилище рекордов в памяти, которое можно "отключить"
+    class FakeUseCases : public db_storage::UseCases {
+    public:
+        void AddPlayerRecords(const std::vector<domain::PlayerRecord>& player_records) override {
+            std::lock_guard lock{mutex_};
+            ++calls_;
+
+            if(!available_) {
+                throw std::runtime_error("database is down"s);
+            }
+
+            batch_sizes_.emplace_back(player_records.size());
+            records_.insert(records_.end(), player_records.begin(), player_records.end());
+        }
+
+        std::vector<domain::PlayerRecord> GetRecordsTable([[maybe_unused]] size_t offset
+                                                        , [[maybe_unused]] size_t limit) override {
+            std::lock_guard lock{mutex_};
+            return records_;
+        }
+
+        std::vector<domain::PlayerRecord> GetRecordsTableAfter([[maybe_unused]] const domain::PlayerRecord& after
+                                                            , [[maybe_unused]] size_t offset
+                                                            , [[maybe_unused]] size_t limit) override {
+            return {};
+        }
+
+        void AsyncGetRecordsTableAfter([[maybe_unused]] const domain::PlayerRecord& after
+                                     , [[maybe_unused]] size_t offset, [[maybe_unused]] size_t limit
+                                     , [[maybe_unused]] const boost::asio::any_io_executor& executor
+                                     , [[maybe_unused]] domain::RecordsHandler handler) override {
+        }
+
+        uint64_t GetLastRecordId() override {
+            return 0;
+        }
+
+        void SetAvailable(bool available) {
+            std::lock_guard lock{mutex_};
+            available_ = available;
+        }
+
+        size_t Calls() {
+            std::lock_guard lock{mutex_};
+            return calls_;
+        }
+
+        std::vector<size_t> BatchSizes() {
+            std::lock_guard lock{mutex_};
+            return batch_sizes_;
+        }
+
+    private:
+        std::mutex mutex_;
+        bool available_ = true;
+        size_t calls_ = 0;
+        std::vector<size_t> batch_sizes_;
+        std::vector<domain::PlayerRecord> records_;
+    };
+
+    std::vector<domain::PlayerRecord> MakeRecords(size_t count, size_t first = 0) {
+        std::vector<domain::PlayerRecord> records;
+
+        for(size_t i = first; i < first + count; ++i) {
+            records.emplace_back("dog "s + std::to_string(i), i, static_cast<int64_t>(i * 10), i + 1);
+        }
+
+        return records;
+    }
+
+    std::filesystem::path JournalPath(const std::string& name) {
+        auto path = std::filesystem::temp_directory_path() / ("records_write_behind_"s + name + ".journal"s);
+        std::filesystem::remove(path);
+        std::filesystem::remove(path.string() + ".replaying"s);
+        std::filesystem::remove(path.string() + ".replaying.done"s);
+        return path;
+    }
+
+    TEST_CASE("Queued records are saved in batches and drained on stop"s, TAG) {
+        FakeUseCases use_cases;
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, db_storage::WriteBehindSettings{
+                .batch_size = 4, .flush_interval = std::chrono::milliseconds{10'000}}};
+
+            writer.Enqueue(MakeRecords(10));
+            writer.Stop();
+            CHECK(writer.PendingCount() == 0);
+        }
+
+        CHECK(use_cases.GetRecordsTable(0, 100).size() == 10);
+
+        for(size_t batch_size : use_cases.BatchSizes()) {
+            CHECK(batch_size <= 4);
+        }
+    }
+
+    TEST_CASE("Records are spilled to journal while database is down and replayed later"s, TAG) {
+        const auto journal = JournalPath("down"s);
+        FakeUseCases use_cases;
+        use_cases.SetAvailable(false);
+
+        db_storage::WriteBehindSettings settings{.batch_size = 8
+                                                , .flush_interval = std::chrono::milliseconds{1}
+                                                , .max_retries = 2
+                                                , .retry_delay = std::chrono::milliseconds{1}
+                                                , .journal_path = journal};
+        std::vector<std::string> errors;
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, settings, [&errors](const std::string& message) {
+                errors.emplace_back(message);
+            }};
+
+            writer.Enqueue(MakeRecords(5));
+
+            // Ждем, пока поток записи исчерпает попытки и сбросит пачку в журнал
+            for(int i = 0; i < 1000 && !std::filesystem::exists(journal); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            }
+        }
+
+        // Первая попытка и две повторные
+        CHECK(use_cases.Calls() == 3);
+        CHECK_FALSE(errors.empty());
+        CHECK(use_cases.GetRecordsTable(0, 100).empty());
+        REQUIRE(std::filesystem::exists(journal));
+
+        // Номера записей журнала заняты, пока записи не сохранены в БД
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, settings};
+            CHECK(writer.GetLastJournalId() == 5);
+        }
+
+        // После перезапуска с доступной БД журнал дописывается и удаляется
+        use_cases.SetAvailable(true);
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, settings};
+            writer.Enqueue(MakeRecords(2, 5));
+        }
+
+        const auto saved = use_cases.GetRecordsTable(0, 100);
+        REQUIRE(saved.size() == 7);
+        CHECK(saved.front().GetName() == "dog 0"s);
+        CHECK_FALSE(std::filesystem::exists(journal));
+    }
+
+    TEST_CASE("Queue overflow goes to journal without waiting for database"s, TAG) {
+        const auto journal = JournalPath("overflow"s);
+        FakeUseCases use_cases;
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, db_storage::WriteBehindSettings{
+                .queue_capacity = 3, .batch_size = 100, .flush_interval = std::chrono::milliseconds{10'000}
+                , .journal_path = journal}};
+
+            writer.Enqueue(MakeRecords(5));
+            CHECK(writer.PendingCount() == 3);
+
+            // Переполнение пишет в журнал поток записи, а не вызывающий поток
+            for(int i = 0; i < 1000 && !std::filesystem::exists(journal); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            }
+            CHECK(std::filesystem::exists(journal));
+        }
+
+        // Очередь сохранена при остановке, после успешного сохранения дописан и журнал
+        CHECK(use_cases.GetRecordsTable(0, 100).size() == 5);
+        CHECK_FALSE(std::filesystem::exists(journal));
+    }
+
+    TEST_CASE("Failed replay keeps the journal until every batch is saved"s, TAG) {
+        const auto journal = JournalPath("failed_replay"s);
+        const auto replaying = journal.string() + ".replaying"s;
+        FakeUseCases use_cases;
+        use_cases.SetAvailable(false);
+
+        db_storage::WriteBehindSettings settings{.batch_size = 2
+                                                , .flush_interval = std::chrono::milliseconds{10'000}
+                                                , .max_retries = 0
+                                                , .journal_path = journal};
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, settings};
+            writer.Enqueue(MakeRecords(5));
+        }
+        REQUIRE(std::filesystem::exists(journal));
+
+        // БД все еще недоступна: журнал забран на дописывание, но не удален
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, settings};
+            CHECK_FALSE(std::filesystem::exists(journal));
+            CHECK(std::filesystem::exists(replaying));
+        }
+        CHECK(std::filesystem::exists(replaying));
+        CHECK(use_cases.GetRecordsTable(0, 100).empty());
+
+        use_cases.SetAvailable(true);
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, settings};
+        }
+        CHECK(use_cases.GetRecordsTable(0, 100).size() == 5);
+        CHECK_FALSE(std::filesystem::exists(replaying));
+        CHECK_FALSE(std::filesystem::exists(journal));
+    }
+
+    TEST_CASE("Interrupted replay resumes after the last saved batch"s, TAG) {
+        const auto journal = JournalPath("resume"s);
+        // Файлы, оставшиеся после сбоя: две из пяти записей уже сохранены в БД
+        {
+            std::ofstream out{journal.string() + ".replaying"s, std::ios::binary};
+            for(const auto& record : MakeRecords(5)) {
+                out << record.GetId() << ' ' << record.GetScore() << ' ' << record.GetPlayTime() << ' '
+                    << record.GetName().size() << ' ' << record.GetName() << '\n';
+            }
+            std::ofstream{journal.string() + ".replaying.done"s} << 2;
+        }
+
+        FakeUseCases use_cases;
+        {
+            db_storage::RecordsWriteBehind writer{use_cases, db_storage::WriteBehindSettings{
+                .batch_size = 2, .flush_interval = std::chrono::milliseconds{10'000}, .journal_path = journal}};
+        }
+
+        const auto saved = use_cases.GetRecordsTable(0, 100);
+        REQUIRE(saved.size() == 3);
+        CHECK(saved.front().GetName() == "dog 2"s);
+        CHECK_FALSE(std::filesystem::exists(journal.string() + ".replaying"s));
+        CHECK_FALSE(std::filesystem::exists(journal.string() + ".replaying.done"s));
+    }
+
+} // namespace catch_tests
@@ -1,6 +1,7 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <filesystem>
 #include <sstream>
 
 #include <iostream>
@@ -13,6 +14,8 @@
 #include "../src/serialization_game/game_session_serialization.h"
 #include "../src/serialization_game/player_serialization.h"
 #include "../src/serialization_game/game_manager_serialization.h"
+#include "../src/serialization_game/binary_archive.h"
+#include "../src/serialization_game/state_journal.h"
 #include "../work_with_json/json_loader.h"
 #include "../application/application.h"
 
@@ -260,6 +263,185 @@ SCENARIO_METHOD(Fixture, "Dog Serialization"s) {
         }
     }
 }
+SCENARIO("Binary archive round trip"s) {
+    GIVEN("Values of primitive, string and container types"s) {
+        const Position pos{10.5, -20.25};
+        const Velocity velocity{0.0, 3.75};
+        const Direction direction = Direction::WEST;
+        const std::string name = "Пёс Pluto"s;
+        const std::vector<double> values{1.0, 2.5, -3.0};
+        const std::unordered_map<size_t, std::string> names{{1u, "Rex"s}, {7u, ""s}};
+        const std::pair<size_t, size_t> key{3u, 836586u};
+
+        WHEN("they are written to a binary snapshot section"s) {
+            std::stringstream strm;
+            {
+                serialization::SnapshotWriter writer{strm};
+                serialization::BinaryOArchive ar{writer};
+                writer.BeginSection(1, 7);
+                ar << pos << velocity << direction << name << values << names << key;
+                writer.EndSection();
+            }
+
+            THEN("the same values are read back"s) {
+                serialization::SnapshotReader reader{strm};
+                serialization::BinaryIArchive ar{reader};
+                CHECK(reader.BeginSection(1) == 7u);
+
+                Position restored_pos;
+                Velocity restored_velocity;
+                Direction restored_direction = Direction::NORTH;
+                std::string restored_name;
+                std::vector<double> restored_values;
+                std::unordered_map<size_t, std::string> restored_names;
+                std::pair<size_t, size_t> restored_key;
+                ar >> restored_pos >> restored_velocity >> restored_direction >> restored_name
+                   >> restored_values >> restored_names >> restored_key;
+                reader.EndSection();
+
+                CHECK(restored_pos == pos);
+                CHECK(restored_velocity == velocity);
+                CHECK(restored_direction == direction);
+                CHECK(restored_name == name);
+                CHECK(restored_values == values);
+                CHECK(restored_names == names);
+                CHECK(restored_key == key);
+            }
+        }
+    }
+}
+
+SCENARIO("Binary snapshot sections are checked"s) {
+    GIVEN("A section larger than one chunk"s) {
+        const std::string big(serialization::SNAPSHOT_CHUNK_SIZE * 2 + 123, 'x');
+        std::stringstream strm;
+        {
+            serialization::SnapshotWriter writer{strm};
+            serialization::BinaryOArchive ar{writer};
+            writer.BeginSection(2, 1);
+            ar << big;
+            writer.EndSection();
+        }
+
+        THEN("it is read back across chunks"s) {
+            serialization::SnapshotReader reader{strm};
+            serialization::BinaryIArchive ar{reader};
+            reader.BeginSection(2);
+            std::string restored;
+            ar >> restored;
+            reader.EndSection();
+            CHECK(restored == big);
+        }
+
+        WHEN("a byte of the section is damaged"s) {
+            std::string data = strm.str();
+            data[data.size() / 2] ^= 0x01;
+            std::stringstream damaged{data};
+
+            THEN("reading fails with a checksum error"s) {
+                serialization::SnapshotReader reader{damaged};
+                serialization::BinaryIArchive ar{reader};
+                reader.BeginSection(2);
+                std::string restored;
+                CHECK_THROWS_AS(ar >> restored, serialization::SnapshotError);
+            }
+        }
+
+        WHEN("a different section is expected"s) {
+            THEN("reading fails"s) {
+                serialization::SnapshotReader reader{strm};
+                CHECK_THROWS_AS(reader.BeginSection(3), serialization::SnapshotError);
+            }
+        }
+    }
+}
+
+SCENARIO("State journal replay"s) {
+    GIVEN("A journal with two records and a torn tail"s) {
+        const auto path = std::filesystem::temp_directory_path() / "state_journal_test.wal"s;
+        std::filesystem::remove(path);
+
+        serialization::JournalRecordBuilder first{1, 3, 5};
+        first.SetSessionKeys({{0, "map1"s, 0}});
+        first.RemovePlayer("absent"s);
+        const auto first_record = first.Finish();
+
+        serialization::JournalRecordBuilder second{2, 4, 7};
+        second.SetSessionKeys({{0, "map1"s, 0}, {0, "map2"s, 1}});
+        const auto second_record = second.Finish();
+
+        uint64_t complete_size = 0;
+        {
+            serialization::JournalFile journal{path};
+            journal.Append(first_record);
+            journal.Append(second_record);
+            journal.Sync();
+            complete_size = std::filesystem::file_size(path);
+            // Начало третьей записи: сбой во время дозаписи
+            journal.Append({3, second_record.data.substr(0, second_record.data.size() / 2)});
+        }
+
+        WHEN("it is replayed on top of an older checkpoint"s) {
+            serialization::GameStateCapture state;
+            std::ifstream in{path, std::ios::binary};
+            const uint64_t size = serialization::ReplayJournal(in, state);
+
+            THEN("complete records are applied and the torn one is dropped"s) {
+                CHECK(size == complete_size);
+                CHECK(state.journal_seq == 2u);
+                CHECK(state.id_session == 4u);
+                CHECK(state.dog_id == 7u);
+                REQUIRE(state.session_keys.size() == 2u);
+                CHECK(state.session_keys[1].map_id == "map2"s);
+            }
+        }
+
+        WHEN("the checkpoint already covers the first record"s) {
+            serialization::GameStateCapture state;
+            state.journal_seq = 1;
+            std::ifstream in{path, std::ios::binary};
+            static_cast<void>(serialization::ReplayJournal(in, state));
+
+            THEN("only the newer record is applied"s) {
+                CHECK(state.journal_seq == 2u);
+                CHECK(state.session_keys.size() == 2u);
+            }
+        }
+
+        WHEN("the journal is compacted"s) {
+            {
+                serialization::JournalFile journal{path};
+                journal.Rewrite({});
+            }
+
+            THEN("nothing is replayed"s) {
+                serialization::GameStateCapture state;
+                std::ifstream in{path, std::ios::binary};
+                CHECK(serialization::ReplayJournal(in, state) == std::filesystem::file_size(path));
+                CHECK(state.journal_seq == 0u);
+            }
+        }
+    }
+
+    GIVEN("A record changing a dog of an unknown session"s) {
+        const auto path = std::filesystem::temp_directory_path() / "state_journal_unknown.wal"s;
+        std::filesystem::remove(path);
+
+        serialization::JournalRecordBuilder record{1, 0, 1};
+        record.AddDog(42, serialization::DogRepr{Dog{"Pluto"s, 0}});
+        {
+            serialization::JournalFile journal{path};
+            journal.Append(record.Finish());
+        }
+
+        THEN("replay fails instead of losing the change"s) {
+            serialization::GameStateCapture state;
+            std::ifstream in{path, std::ios::binary};
+            CHECK_THROWS_AS(serialization::ReplayJournal(in, state), std::runtime_error);
+        }
+    }
+}
+
 /*
 model::Game game = 
      json_loader::LoadGame("/home/sergey/yandex_practicum/cppbackend/sprint4/problems/state_serialization/solution/data/config.json"s);
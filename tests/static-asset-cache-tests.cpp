@@ -0,0 +1,232 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "../src/response/static_asset_cache.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    namespace fs = std::filesystem;
+    namespace http = boost::beast::http;
+    const std::string TAG = "[StaticAssetCache]"s;
+
+    fs::path MakeRoot(const std::string& name) {
+        auto root = fs::temp_directory_path() / ("static_asset_cache_"s + name);
+        fs::remove_all(root);
+        fs::create_directories(root / "js"s);
+        return root;
+    }
+
+    void WriteFile(const fs::path& path, const std::string& content) {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << content;
+    }
+
+    std::string_view Content(const http_response::AssetDataPtr& data) {
+        return {data->Data(), static_cast<size_t>(data->Size())};
+    }
+
+    std::string_view Content(const http_response::AssetSlice& slice) {
+        return {slice.data->Data() + slice.offset, static_cast<size_t>(slice.length)};
+    }
+
+    // Ждем, пока поток наблюдения не применит изменение каталога
+    template <typename Predicate>
+    bool WaitFor(Predicate predicate) {
+        for(int i = 0; i < 100; ++i) {
+            if(predicate()) {
+                return true;
+            }
+            std::this_thread::sleep_for(20ms);
+        }
+        return predicate();
+    }
+
+    TEST_CASE("Static asset cache loads files with precomputed headers"s, TAG) {
+        const auto root = MakeRoot("load"s);
+        WriteFile(root / "index.html"s, "<html></html>"s);
+        WriteFile(root / "js"s / "three.js"s, std::string(4096, 'x'));
+        WriteFile(root / "js"s / "three.js.gz"s, "gzipped"s);
+        WriteFile(root / "js"s / "pug.FBX"s, std::string(3000, 'f'));
+
+        http_response::StaticAssetCache cache{root, 2048};
+
+        const auto index = cache.Find("/"sv);
+        REQUIRE(index);
+        CHECK(index->content_type == "text/html"s);
+        CHECK(Content(index->identity.data) == "<html></html>"sv);
+        CHECK_FALSE(index->identity.data->IsMapped());
+
+        const auto three = cache.Find("/js/three.js"sv);
+        REQUIRE(three);
+        CHECK(three->content_type == "text/javascript"s);
+        CHECK(three->identity.data->IsMapped());
+        CHECK(three->identity.data->Size() == 4096);
+        REQUIRE(three->gzip.data);
+        CHECK_FALSE(three->brotli.data);
+        CHECK(three->identity.etag.front() == '"');
+        CHECK(three->last_modified.ends_with(" GMT"s));
+
+        CHECK(cache.Find("/js/pug.FBX"sv)->content_type == "application/octet-stream"s);
+        CHECK_FALSE(cache.Find("/../static_asset_cache_load/index.html"sv));
+        CHECK_FALSE(cache.Find("/missing.js"sv));
+
+        SECTION("compressed variant is chosen by Accept-Encoding"s) {
+            http_response::AssetRequest request;
+            request.accept_encoding = "deflate, gzip;q=0.8"sv;
+            auto gzip = http_response::MakeAssetResponse(*three, request);
+            CHECK(gzip[http::field::content_encoding] == "gzip"sv);
+            CHECK(gzip[http::field::vary] == "Accept-Encoding"sv);
+            CHECK(gzip[http::field::etag] == three->gzip.etag);
+            CHECK(Content(gzip.body()) == "gzipped"sv);
+
+            request.accept_encoding = "gzip;q=0"sv;
+            auto identity = http_response::MakeAssetResponse(*three, request);
+            CHECK(identity[http::field::content_encoding].empty());
+            CHECK(identity[http::field::etag] == three->identity.etag);
+            CHECK(identity.body().length == 4096);
+            CHECK(identity[http::field::content_length] == "4096"sv);
+        }
+    }
+
+    TEST_CASE("Static asset responses honour validators and ranges"s, TAG) {
+        const auto root = MakeRoot("conditional"s);
+        WriteFile(root / "js"s / "game.js"s, "0123456789"s);
+        WriteFile(root / "js"s / "game.3f9a1c2e.js"s, "fingerprinted"s);
+
+        http_response::StaticAssetCache cache{root};
+        const auto asset = cache.Find("/js/game.js"sv);
+        REQUIRE(asset);
+        CHECK(asset->cache_control == "no-cache"s);
+        CHECK(cache.Find("/js/game.3f9a1c2e.js"sv)->cache_control.find("immutable"s) != std::string::npos);
+
+        http_response::AssetRequest request;
+
+        SECTION("matching ETag or date gives 304 without a body"s) {
+            std::string if_none_match = "\"other\", W/"s + asset->identity.etag;
+            request.if_none_match = if_none_match;
+            auto response = http_response::MakeAssetResponse(*asset, request);
+            CHECK(response.result() == http::status::not_modified);
+            CHECK(response.body().length == 0);
+            CHECK(response[http::field::etag] == asset->identity.etag);
+
+            request.if_none_match = "\"other\""sv;
+            request.if_modified_since = asset->last_modified;
+            CHECK(http_response::MakeAssetResponse(*asset, request).result() == http::status::ok);
+
+            request.if_none_match = {};
+            CHECK(http_response::MakeAssetResponse(*asset, request).result() == http::status::not_modified);
+
+            request.if_modified_since = "Thu, 01 Jan 1970 00:00:00 GMT"sv;
+            CHECK(http_response::MakeAssetResponse(*asset, request).result() == http::status::ok);
+        }
+
+        SECTION("a single range gives 206 with Content-Range"s) {
+            request.range = "bytes=2-4"sv;
+            auto middle = http_response::MakeAssetResponse(*asset, request);
+            CHECK(middle.result() == http::status::partial_content);
+            CHECK(middle[http::field::content_range] == "bytes 2-4/10"sv);
+            CHECK(middle[http::field::content_length] == "3"sv);
+            CHECK(Content(middle.body()) == "234"sv);
+
+            request.range = "bytes=-3"sv;
+            CHECK(Content(http_response::MakeAssetResponse(*asset, request).body()) == "789"sv);
+
+            request.range = "bytes=8-100"sv;
+            CHECK(Content(http_response::MakeAssetResponse(*asset, request).body()) == "89"sv);
+
+            request.range = "bytes=0-1, 4-5"sv;
+            auto several = http_response::MakeAssetResponse(*asset, request);
+            CHECK(several.result() == http::status::ok);
+            CHECK(several.body().length == 10);
+
+            request.range = "bytes=10-"sv;
+            auto unsatisfiable = http_response::MakeAssetResponse(*asset, request);
+            CHECK(unsatisfiable.result() == http::status::range_not_satisfiable);
+            CHECK(unsatisfiable[http::field::content_range] == "bytes */10"sv);
+
+            // Другая версия файла у клиента - отдаем файл целиком
+            request.range = "bytes=2-4"sv;
+            request.if_range = "\"stale\""sv;
+            CHECK(http_response::MakeAssetResponse(*asset, request).result() == http::status::ok);
+            request.if_range = asset->identity.etag;
+            CHECK(http_response::MakeAssetResponse(*asset, request).result() == http::status::partial_content);
+        }
+
+        SECTION("HEAD keeps headers of GET without the body"s) {
+            request.head = true;
+            auto response = http_response::MakeAssetResponse(*asset, request);
+            CHECK(response[http::field::content_length] == "10"sv);
+            CHECK(response.body().length == 0);
+        }
+    }
+
+    TEST_CASE("Large static files are copied, not mapped from disk"s, TAG) {
+        const auto root = MakeRoot("large"s);
+        WriteFile(root / "js"s / "three.js"s, std::string(4096, 'a'));
+
+        http_response::StaticAssetCache cache{root, 1024};
+        const auto old_asset = cache.Find("/js/three.js"sv);
+        REQUIRE(old_asset);
+        REQUIRE(old_asset->identity.data->IsMapped());
+        const std::string old_etag = old_asset->identity.etag;
+
+        // Перезапись на месте того же размера: прежняя копия не меняется, у новой другой ETag
+        WriteFile(root / "js"s / "three.js"s, std::string(4096, 'b'));
+        CHECK(Content(old_asset->identity.data) == std::string(4096, 'a'));
+        CHECK(WaitFor([&] {
+            const auto asset = cache.Find("/js/three.js"sv);
+            return asset && Content(asset->identity.data) == std::string(4096, 'b');
+        }));
+        CHECK(cache.Find("/js/three.js"sv)->identity.etag != old_etag);
+
+        // Файл укоротили на месте - прежняя копия остается целой
+        WriteFile(root / "js"s / "three.js"s, "short"s);
+        CHECK(old_asset->identity.data->Size() == 4096);
+    }
+
+    TEST_CASE("Static asset cache follows changes of the root directory"s, TAG) {
+        const auto root = MakeRoot("watch"s);
+        WriteFile(root / "js"s / "game.js"s, "v1"s);
+
+        http_response::StaticAssetCache cache{root};
+        const auto old_asset = cache.Find("/js/game.js"sv);
+        REQUIRE(old_asset);
+
+        WriteFile(root / "js"s / "game.js"s, "version 2"s);
+        CHECK(WaitFor([&] {
+            const auto asset = cache.Find("/js/game.js"sv);
+            return asset && Content(asset->identity.data) == "version 2"sv;
+        }));
+        // Ответ, собранный до изменения, продолжает отдавать прежнее содержимое
+        CHECK(Content(old_asset->identity.data) == "v1"sv);
+
+        WriteFile(root / "js"s / "game.js.br"s, "brotli"s);
+        CHECK(WaitFor([&] {
+            const auto asset = cache.Find("/js/game.js"sv);
+            return asset && asset->brotli.data;
+        }));
+
+        fs::create_directories(root / "models"s);
+        WriteFile(root / "models"s / "key.obj"s, "o key"s);
+        CHECK(WaitFor([&] {
+            return cache.Find("/models/key.obj"sv) != nullptr;
+        }));
+
+        fs::remove(root / "js"s / "game.js"s);
+        CHECK(WaitFor([&] {
+            return cache.Find("/js/game.js"sv) == nullptr;
+        }));
+
+        fs::remove_all(root / "models"s);
+        CHECK(WaitFor([&] {
+            return cache.Find("/models/key.obj"sv) == nullptr;
+        }));
+    }
+
+} // namespace catch_tests
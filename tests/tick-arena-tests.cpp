@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "../src/application/tick_arena.h"
+#include "../src/physics/collision_detector.h"
+
+// Подсчет обращений к глобальной куче во всем тестовом бинарнике
+namespace {
+
+    std::atomic<size_t> global_allocations{0};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    global_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if(void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, [[maybe_unused]] std::size_t size) noexcept {
+    std::free(p);
+}
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    const std::string TAG = "[TickArena]"s;
+
+    // Работа тика с ареной без модели игры: заполняем индекс коллизий, ищем события и собираем
+    // токены на удаление. Application::UpdateGameSessions и CollisionManager здесь не вызываются,
+    // поэтому тест проверяет только поиск столкновений и контейнеры арены, а не весь тик
+    size_t SimulateTick(app::TickArena& arena, size_t items_count, size_t gatherers_count) {
+        arena.Reset();
+        std::pmr::memory_resource* resource = arena.Resource();
+
+        collision_detector::ItemGathererProviderImpl provider{resource};
+        provider.Reserve(items_count, gatherers_count);
+
+        for(size_t i = 0; i < items_count; ++i) {
+            provider.AddItem(i, collision_detector::Item{{static_cast<double>(i), 0.0}, 0.0});
+        }
+
+        for(size_t g = 0; g < gatherers_count; ++g) {
+            provider.AddGatherer(g, collision_detector::Gatherer{{0.0, 0.1 * static_cast<double>(g)}
+                                                                , {static_cast<double>(items_count), 0.0}, 0.6});
+        }
+
+        auto events = collision_detector::FindGatherEvents(provider, resource);
+
+        std::pmr::vector<std::string_view> tokens{resource};
+        for(const auto& event : events) {
+            if(event.gatherer_id % 2 == 0) {
+                tokens.emplace_back("0123456789abcdef0123456789abcdef"sv);
+            }
+        }
+
+        return events.size() + tokens.size();
+    }
+
+    TEST_CASE("Collision search and token list in a warmed-up arena perform no global heap allocations"s, TAG) {
+        app::TickArena arena;
+
+        // Прогрев: арена подстраивает размер буфера под нагрузку
+        size_t warm_up_result = 0;
+        for(int i = 0; i < 3; ++i) {
+            warm_up_result = SimulateTick(arena, 200, 20);
+        }
+
+        const size_t before = global_allocations.load();
+        size_t result = 0;
+
+        for(int i = 0; i < 100; ++i) {
+            result = SimulateTick(arena, 200, 20);
+        }
+
+        const size_t after = global_allocations.load();
+
+        CHECK(result == warm_up_result);
+        CHECK(result > 0);
+        CHECK(after - before == 0);
+    }
+
+    TEST_CASE("Tick arena grows after overflow and stops allocating"s, TAG) {
+        app::TickArena arena{256};
+        const size_t initial_capacity = arena.Capacity();
+
+        SimulateTick(arena, 1000, 50);
+        SimulateTick(arena, 1000, 50);
+        CHECK(arena.Capacity() > initial_capacity);
+
+        const size_t before = global_allocations.load();
+        SimulateTick(arena, 1000, 50);
+        SimulateTick(arena, 1000, 50);
+        CHECK(global_allocations.load() - before == 0);
+    }
+
+} // namespace catch_tests
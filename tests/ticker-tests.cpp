@@ -0,0 +1,81 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/metrics/metrics.h"
+#include "../src/time_management/ticker.h"
+
+namespace catch_tests {
+
+    using namespace std::literals;
+    using std::chrono::milliseconds;
+    const std::string TAG = "[Ticker]"s;
+
+    std::vector<milliseconds> SplitDelta(milliseconds delta, milliseconds max_step) {
+        const auto steps = time_m::Ticker::SplitDelta(delta, max_step);
+        return {steps.begin(), steps.end()};
+    }
+
+    TEST_CASE("Long tick is split into equal sub-steps", TAG) {
+        using time_m::Ticker;
+
+        SECTION("Short tick and disabled splitting stay whole") {
+            CHECK(SplitDelta(40ms, 50ms) == std::vector<milliseconds>{40ms});
+            CHECK(SplitDelta(400ms, 0ms) == std::vector<milliseconds>{400ms});
+        }
+
+        SECTION("Sub-steps do not exceed the maximum and keep the whole delta") {
+            const auto steps = SplitDelta(125ms, 50ms);
+            CHECK(steps == std::vector<milliseconds>{42ms, 42ms, 41ms});
+        }
+
+        SECTION("Number of sub-steps is capped") {
+            const auto steps = SplitDelta(10'000ms, 10ms);
+            CHECK(steps.size() == Ticker::MAX_SUBSTEPS);
+            CHECK(std::accumulate(steps.begin(), steps.end(), 0ms) == 10'000ms);
+        }
+    }
+
+    TEST_CASE("Slow handler does not slow down game time", TAG) {
+        namespace net = boost::asio;
+        constexpr auto PERIOD = 10ms;
+        constexpr auto RUN_TIME = 200ms;
+
+        auto& server_metrics = metrics::GetServerMetrics();
+        const uint64_t overruns_before = server_metrics.tick_overruns.Value();
+        const uint64_t skipped_before = server_metrics.ticks_skipped.Value();
+
+        net::io_context ioc;
+        auto strand = net::make_strand(ioc);
+        std::vector<milliseconds> deltas;
+        std::shared_ptr<time_m::Ticker> ticker;
+        ticker = std::make_shared<time_m::Ticker>(strand, PERIOD, [&](milliseconds delta) {
+            // Первый тик занимает три с половиной периода
+            if(deltas.empty()) {
+                std::this_thread::sleep_for(35ms);
+            }
+            deltas.push_back(delta);
+            if(std::accumulate(deltas.begin(), deltas.end(), 0ms) >= RUN_TIME) {
+                ticker->Stop();
+            }
+        });
+
+        const auto start = std::chrono::steady_clock::now();
+        ticker->Start();
+        ioc.run();
+        const auto elapsed = std::chrono::duration_cast<milliseconds>(std::chrono::steady_clock::now() - start);
+
+        const auto game_time = std::accumulate(deltas.begin(), deltas.end(), 0ms);
+        CHECK(game_time >= RUN_TIME);
+        CHECK(game_time <= elapsed);
+        // Пропущенные сроки объединены с опоздавшим тиком, а не накоплены в очередь
+        CHECK(server_metrics.tick_overruns.Value() > overruns_before);
+        CHECK(server_metrics.ticks_skipped.Value() >= skipped_before + 2);
+        CHECK(deltas.size() < static_cast<size_t>(RUN_TIME / PERIOD));
+    }
+
+} // namespace catch_tests